@@ -30,6 +30,7 @@ layout (std140) uniform MaterialInformationBlock {
     float shininess;
     vec3 diffuse;
     int isMap; 	//using the last 4, ambient=8, diffuse=4, specular=2, opacity = 1
+    ivec4 textureLayers; //layers in texture arrays for ambient, diffuse, specular, opacity. -1 if not packed
 } material;
 
 in VS_FS {
@@ -50,6 +51,10 @@ uniform sampler2D diffuseSampler;
 uniform sampler2D specularSampler;
 uniform sampler2D opacitySampler;
 
+uniform sampler2DArray ambientArraySampler;
+uniform sampler2DArray diffuseArraySampler;
+uniform sampler2DArray opacityArraySampler;
+
 uniform vec3 pointSampleOffsetDirections[20] = vec3[]
 (
    vec3( 1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1),
@@ -112,16 +117,23 @@ float ShadowCalculationPoint(vec3 fragPos, float bias, float viewDistance, int l
     return shadow;
 }
 
+vec4 sampleMap(sampler2D mapSampler, sampler2DArray arraySampler, int layer) {
+    if(layer >= 0) {
+        return texture(arraySampler, vec3(from_vs.textureCoord, layer));
+    }
+    return texture(mapSampler, from_vs.textureCoord);
+}
+
 void main(void)
 {
         vec4 objectColor;
         if((material.isMap & 0x0004)!=0) {
             if((material.isMap & 0x0001)!=0) { //if there is a opacity map, and it with diffuse
-                vec4 opacity = texture(opacitySampler, from_vs.textureCoord);
-                objectColor = texture(diffuseSampler, from_vs.textureCoord);
+                vec4 opacity = sampleMap(opacitySampler, opacityArraySampler, material.textureLayers.w);
+                objectColor = sampleMap(diffuseSampler, diffuseArraySampler, material.textureLayers.y);
                 objectColor.w =  opacity.a;//FIXME some other textures used x
             } else {
-                objectColor = texture(diffuseSampler, from_vs.textureCoord);
+                objectColor = sampleMap(diffuseSampler, diffuseArraySampler, material.textureLayers.y);
             }
         } else {
             objectColor = vec4(material.diffuse, 1.0);
@@ -129,7 +141,7 @@ void main(void)
 
         vec3 lightingColorFactor = material.ambient;
         if((material.isMap & 0x0008)!=0) {
-            lightingColorFactor = vec3(texture(ambientSampler, from_vs.textureCoord));
+            lightingColorFactor = vec3(sampleMap(ambientSampler, ambientArraySampler, material.textureLayers.x));
         }
 
         float shadow;
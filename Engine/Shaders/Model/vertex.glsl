@@ -3,9 +3,9 @@
 #define NR_POINT_LIGHTS 4
 #define NR_MAX_MODELS 1000
 
-layout (location = 2) in vec4 position;
+layout (location = 2) in vec3 packedPosition;//normalized in bounding box of the mesh
 layout (location = 3) in vec2 textureCoordinate;
-layout (location = 4) in vec3 normal;
+layout (location = 4) in vec2 packedNormal;
 
 out VS_FS {
     vec3 boneColor;
@@ -45,8 +45,22 @@ layout (std140) uniform LightSourceBlock
     LightSource lights[NR_POINT_LIGHTS];
 } LightSources;
 
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 decodeNormal(vec2 encoded) {
+    //octahedral encoding, see VertexQuantizer
+    vec3 decoded = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-decoded.z, 0.0);
+    decoded.x += decoded.x >= 0.0 ? -fold : fold;
+    decoded.y += decoded.y >= 0.0 ? -fold : fold;
+    return normalize(decoded);
+}
+
 void main(void)
 {
+    vec4 position = vec4(positionOffset + packedPosition * positionScale, 1.0);
+    vec3 normal = decodeNormal(packedNormal);
     to_fs.textureCoord = textureCoordinate;
     mat4 currentWorldTransform = model.worldTransform[instance.models[gl_InstanceID].x];
     to_fs.normal = normalize(mat3(transpose(inverse(currentWorldTransform))) * normal);
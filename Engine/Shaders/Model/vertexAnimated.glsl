@@ -5,9 +5,9 @@
 
 #define NR_BONE 128
 
-layout (location = 2) in vec4 position;
+layout (location = 2) in vec3 packedPosition;//normalized in bounding box of the mesh
 layout (location = 3) in vec2 textureCoordinate;
-layout (location = 4) in vec3 normal;
+layout (location = 4) in vec2 packedNormal;
 layout (location = 5) in uvec4 boneIDs;
 layout (location = 6) in vec4 boneWeights;
 
@@ -52,9 +52,22 @@ layout (std140) uniform LightSourceBlock
 } LightSources;
 
 uniform mat4 boneTransformArray[NR_BONE];
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 decodeNormal(vec2 encoded) {
+    //octahedral encoding, see VertexQuantizer
+    vec3 decoded = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-decoded.z, 0.0);
+    decoded.x += decoded.x >= 0.0 ? -fold : fold;
+    decoded.y += decoded.y >= 0.0 ? -fold : fold;
+    return normalize(decoded);
+}
 
 void main(void)
 {
+    vec4 position = vec4(positionOffset + packedPosition * positionScale, 1.0);
+    vec3 normal = decodeNormal(packedNormal);
 
     mat4 BoneTransform = boneTransformArray[boneIDs[0]] * boneWeights[0];
     BoneTransform += boneTransformArray[boneIDs[1]] * boneWeights[1];
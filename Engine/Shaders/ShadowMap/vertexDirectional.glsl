@@ -5,7 +5,7 @@
 #define NR_MAX_MODELS 1000
 
 
-layout (location = 2) in vec4 position;
+layout (location = 2) in vec3 packedPosition;//normalized in bounding box of the mesh
 layout (location = 5) in uvec4 boneIDs;
 layout (location = 6) in vec4 boneWeights;
 
@@ -29,6 +29,7 @@ layout (std140) uniform MaterialInformationBlock {
     float shininess;
     vec3 diffuse;
     int isMap; 	//using the last 4, ambient=8, diffuse=4, specular=2, opacity = 1
+    ivec4 textureLayers; //layers in texture arrays for ambient, diffuse, specular, opacity. -1 if not packed
 } material;
 
 layout (std140) uniform ModelInformationBlock {
@@ -42,8 +43,11 @@ layout (std140) uniform ModelIndexBlock {
 uniform mat4 boneTransformArray[NR_BONE];
 uniform int renderLightIndex;
 uniform int isAnimated;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 void main() {
+    vec3 position = positionOffset + packedPosition * positionScale;
 
     mat4 BoneTransform = mat4(1.0);
     if(isAnimated==1) {
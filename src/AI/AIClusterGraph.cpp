@@ -0,0 +1,352 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "AIClusterGraph.h"
+#include "AIMovementGrid.h"
+
+#include <functional>
+#include <algorithm>
+
+const int32_t AIClusterGraph::CLUSTER_SIZE;
+
+AIClusterGraph::AIClusterGraph(const AIMovementGrid *grid) : grid(grid) {
+    nodeClusters.resize(grid->getNodeCount());
+    clusterCostStamps.assign(grid->getNodeCount(), 0);
+    clusterCosts.resize(grid->getNodeCount());
+    searchStamps.assign(grid->getNodeCount(), 0);
+    searchCosts.resize(grid->getNodeCount());
+    searchParents.resize(grid->getNodeCount());
+    closedNodes.resize(grid->getNodeCount());
+    if (grid->getNodeCount() == 0) {
+        return;
+    }
+    //root is on the lattice by definition
+    latticeOrigin = grid->getNode(grid->getRootIndex()).getPosition();
+    std::set<uint64_t> allClusters;
+    for (uint32_t i = 0; i < grid->getNodeCount(); ++i) {
+        nodeClusters[i] = calculateNodeCluster(i);
+        clusterNodes[nodeClusters[i]].push_back(i);
+        allClusters.insert(nodeClusters[i]);
+    }
+    rebuildClusters(allClusters);
+}
+
+uint64_t AIClusterGraph::calculateNodeCluster(uint32_t nodeIndex) const {
+    const glm::vec3 &position = grid->getNode(nodeIndex).getPosition();
+    int32_t x = (int32_t) std::lround(position.x - latticeOrigin.x);
+    int32_t z = (int32_t) std::lround(position.z - latticeOrigin.z);
+    //division rounding towards negative infinity, so clusters don't get bigger around 0
+    int32_t clusterX = x >= 0 ? x / CLUSTER_SIZE : -((-x + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+    int32_t clusterZ = z >= 0 ? z / CLUSTER_SIZE : -((-z + CLUSTER_SIZE - 1) / CLUSTER_SIZE);
+    return makeClusterKey(clusterX, clusterZ);
+}
+
+bool AIClusterGraph::isLinked(uint32_t from, uint32_t to) const {
+    const AIMovementNode &node = grid->getNode(from);
+    for (int i = 0; i < 9; ++i) {
+        if (node.getNeighbour(i) == to) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AIClusterGraph::collectCrossings(uint64_t fromCluster, uint64_t toCluster, bool fromIsFirst,
+                                      std::set<std::pair<uint32_t, uint32_t>> &crossings) const {
+    auto fromNodes = clusterNodes.find(fromCluster);
+    if (fromNodes == clusterNodes.end()) {
+        return;
+    }
+    for (size_t i = 0; i < fromNodes->second.size(); ++i) {
+        uint32_t nodeIndex = fromNodes->second[i];
+        if (!grid->isNodeWalkable(nodeIndex)) {
+            continue;
+        }
+        const AIMovementNode &node = grid->getNode(nodeIndex);
+        for (int j = 0; j < 9; ++j) {
+            uint32_t neighbour = node.getNeighbour(j);
+            if (neighbour == AIMovementNode::NO_NEIGHBOUR || nodeClusters[neighbour] != toCluster ||
+                !grid->isNodeWalkable(neighbour)) {
+                continue;
+            }
+            if (fromIsFirst) {
+                crossings.insert(std::make_pair(nodeIndex, neighbour));
+            } else {
+                crossings.insert(std::make_pair(neighbour, nodeIndex));
+            }
+        }
+    }
+}
+
+void AIClusterGraph::buildPairEntrances(uint64_t firstCluster, uint64_t secondCluster) {
+    std::pair<uint64_t, uint64_t> pairKey = std::make_pair(firstCluster, secondCluster);
+    pairEntrances.erase(pairKey);
+
+    //links might be one way, so both sides are checked
+    std::set<std::pair<uint32_t, uint32_t>> crossings;
+    collectCrossings(firstCluster, secondCluster, true, crossings);
+    collectCrossings(secondCluster, firstCluster, false, crossings);
+    if (crossings.empty()) {
+        return;
+    }
+
+    std::map<uint32_t, uint32_t> crossingPartners;//first side node -> a second side node
+    for (auto it = crossings.begin(); it != crossings.end(); ++it) {
+        crossingPartners.insert(*it);
+    }
+
+    //each contiguous segment of first side nodes gets one entrance, at its middle
+    std::vector<Entrance> &entrances = pairEntrances[pairKey];
+    std::set<uint32_t> assignedNodes;
+    for (auto it = crossingPartners.begin(); it != crossingPartners.end(); ++it) {
+        if (assignedNodes.count(it->first)) {
+            continue;
+        }
+        std::vector<uint32_t> segment;
+        segment.push_back(it->first);
+        assignedNodes.insert(it->first);
+        for (size_t k = 0; k < segment.size(); ++k) {
+            const AIMovementNode &node = grid->getNode(segment[k]);
+            for (int j = 0; j < 9; ++j) {
+                uint32_t neighbour = node.getNeighbour(j);
+                if (neighbour != AIMovementNode::NO_NEIGHBOUR && crossingPartners.count(neighbour) &&
+                    !assignedNodes.count(neighbour)) {
+                    assignedNodes.insert(neighbour);
+                    segment.push_back(neighbour);
+                }
+            }
+        }
+        Entrance entrance;
+        entrance.firstNode = segment[segment.size() / 2];
+        entrance.secondNode = crossingPartners[entrance.firstNode];
+        entrances.push_back(entrance);
+    }
+}
+
+uint32_t AIClusterGraph::nextGeneration(std::vector<uint32_t> &stamps, uint32_t generation) {
+    generation++;
+    if (generation == 0) {
+        //wrapped around, old stamps might match again
+        std::fill(stamps.begin(), stamps.end(), 0);
+        generation = 1;
+    }
+    return generation;
+}
+
+void AIClusterGraph::calculateCostsInCluster(uint32_t startNode, uint64_t cluster, bool isReverse) {
+    clusterCostGeneration = nextGeneration(clusterCostStamps, clusterCostGeneration);
+    frontier.clear();
+    clusterCostStamps[startNode] = clusterCostGeneration;
+    clusterCosts[startNode] = 0;
+    frontier.push_back(std::make_pair(0.0f, startNode));
+    uint32_t forwardLinks[9];
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), std::greater<PriorityNode>());
+        PriorityNode current = frontier.back();
+        frontier.pop_back();
+        if (current.first > clusterCosts[current.second]) {
+            continue;//stale entry
+        }
+        const AIMovementNode &node = grid->getNode(current.second);
+        const uint32_t *linksBegin = forwardLinks;
+        const uint32_t *linksEnd = forwardLinks;
+        if (isReverse) {
+            linksBegin = grid->getReverseLinksBegin(current.second);
+            linksEnd = grid->getReverseLinksEnd(current.second);
+        } else {
+            for (int i = 0; i < 9; ++i) {
+                forwardLinks[i] = node.getNeighbour(i);
+            }
+            linksEnd = forwardLinks + 9;
+        }
+        for (const uint32_t *link = linksBegin; link != linksEnd; ++link) {
+            uint32_t neighbour = *link;
+            if (neighbour == AIMovementNode::NO_NEIGHBOUR || nodeClusters[neighbour] != cluster ||
+                !grid->isNodeWalkable(neighbour)) {
+                continue;
+            }
+            float cost = current.first + glm::length(grid->getNode(neighbour).getPosition() - node.getPosition());
+            if (clusterCostStamps[neighbour] != clusterCostGeneration || cost < clusterCosts[neighbour]) {
+                clusterCostStamps[neighbour] = clusterCostGeneration;
+                clusterCosts[neighbour] = cost;
+                frontier.push_back(std::make_pair(cost, neighbour));
+                std::push_heap(frontier.begin(), frontier.end(), std::greater<PriorityNode>());
+            }
+        }
+    }
+}
+
+void AIClusterGraph::buildAbstractNodes(uint64_t cluster) {
+    auto nodesOfCluster = clusterNodes.find(cluster);
+    if (nodesOfCluster == clusterNodes.end()) {
+        return;
+    }
+    for (size_t i = 0; i < nodesOfCluster->second.size(); ++i) {
+        abstractNodes.erase(nodesOfCluster->second[i]);
+    }
+
+    //entrance node -> nodes on the other side
+    std::map<uint32_t, std::vector<uint32_t>> entranceNodes;
+    int32_t clusterX = getClusterX(cluster);
+    int32_t clusterZ = getClusterZ(cluster);
+    for (int32_t i = -1; i <= 1; ++i) {
+        for (int32_t j = -1; j <= 1; ++j) {
+            uint64_t otherCluster = makeClusterKey(clusterX + i, clusterZ + j);
+            if (otherCluster == cluster) {
+                continue;
+            }
+            bool isFirst = cluster < otherCluster;
+            auto entrances = pairEntrances.find(
+                    isFirst ? std::make_pair(cluster, otherCluster) : std::make_pair(otherCluster, cluster));
+            if (entrances == pairEntrances.end()) {
+                continue;
+            }
+            for (size_t k = 0; k < entrances->second.size(); ++k) {
+                const Entrance &entrance = entrances->second[k];
+                if (isFirst) {
+                    entranceNodes[entrance.firstNode].push_back(entrance.secondNode);
+                } else {
+                    entranceNodes[entrance.secondNode].push_back(entrance.firstNode);
+                }
+            }
+        }
+    }
+
+    for (auto it = entranceNodes.begin(); it != entranceNodes.end(); ++it) {
+        AbstractNode &abstractNode = abstractNodes[it->first];
+        abstractNode.cluster = cluster;
+        calculateCostsInCluster(it->first, cluster, false);
+        for (auto otherIt = entranceNodes.begin(); otherIt != entranceNodes.end(); ++otherIt) {
+            float cost;
+            if (otherIt->first != it->first && getClusterCost(otherIt->first, &cost)) {
+                abstractNode.edges.push_back(Edge{otherIt->first, cost});
+            }
+        }
+        for (size_t k = 0; k < it->second.size(); ++k) {
+            uint32_t otherSide = it->second[k];
+            if (isLinked(it->first, otherSide)) {
+                float cost = glm::length(grid->getNode(otherSide).getPosition() - grid->getNode(it->first).getPosition());
+                abstractNode.edges.push_back(Edge{otherSide, cost});
+            }
+        }
+    }
+}
+
+void AIClusterGraph::rebuildClusters(const std::set<uint64_t> &dirtyClusters) {
+    std::set<std::pair<uint64_t, uint64_t>> dirtyPairs;
+    std::set<uint64_t> affectedClusters;
+    for (auto it = dirtyClusters.begin(); it != dirtyClusters.end(); ++it) {
+        int32_t clusterX = getClusterX(*it);
+        int32_t clusterZ = getClusterZ(*it);
+        for (int32_t i = -1; i <= 1; ++i) {
+            for (int32_t j = -1; j <= 1; ++j) {
+                uint64_t otherCluster = makeClusterKey(clusterX + i, clusterZ + j);
+                if (clusterNodes.find(otherCluster) == clusterNodes.end()) {
+                    continue;
+                }
+                affectedClusters.insert(otherCluster);
+                if (otherCluster != *it) {
+                    dirtyPairs.insert(*it < otherCluster ? std::make_pair(*it, otherCluster)
+                                                         : std::make_pair(otherCluster, *it));
+                }
+            }
+        }
+    }
+    for (auto it = dirtyPairs.begin(); it != dirtyPairs.end(); ++it) {
+        buildPairEntrances(it->first, it->second);
+    }
+    //entrances of neighbours might be changed, so their intra cluster costs are recalculated too
+    for (auto it = affectedClusters.begin(); it != affectedClusters.end(); ++it) {
+        buildAbstractNodes(*it);
+    }
+}
+
+void AIClusterGraph::updateNodes(const std::vector<uint32_t> &changedNodes) {
+    std::set<uint64_t> dirtyClusters;
+    for (size_t i = 0; i < changedNodes.size(); ++i) {
+        dirtyClusters.insert(nodeClusters[changedNodes[i]]);
+    }
+    rebuildClusters(dirtyClusters);
+}
+
+void AIClusterGraph::relax(uint32_t from, uint32_t to, float edgeCost, const glm::vec3 &goalPosition) {
+    float cost = searchCosts[from] + edgeCost;
+    bool isSeen = searchStamps[to] == searchGeneration;
+    if (isSeen && (closedNodes[to] || cost >= searchCosts[to])) {
+        return;
+    }
+    searchStamps[to] = searchGeneration;
+    closedNodes[to] = 0;
+    searchCosts[to] = cost;
+    searchParents[to] = from;
+    frontier.push_back(std::make_pair(cost + glm::length(goalPosition - grid->getNode(to).getPosition()), to));
+    std::push_heap(frontier.begin(), frontier.end(), std::greater<PriorityNode>());
+}
+
+bool AIClusterGraph::findAbstractPath(uint32_t startNode, uint32_t goalNode, std::vector<uint32_t> *waypoints) {
+    //entrances start can reach
+    startEntranceCosts.clear();
+    calculateCostsInCluster(startNode, nodeClusters[startNode], false);
+    auto startClusterNodes = clusterNodes.find(nodeClusters[startNode]);
+    if (startClusterNodes != clusterNodes.end()) {
+        for (size_t i = 0; i < startClusterNodes->second.size(); ++i) {
+            uint32_t nodeIndex = startClusterNodes->second[i];
+            float cost;
+            if (abstractNodes.count(nodeIndex) && getClusterCost(nodeIndex, &cost)) {
+                startEntranceCosts.push_back(std::make_pair(nodeIndex, cost));
+            }
+        }
+    }
+    //costs to goal, kept in cluster scratch for the rest of the search
+    calculateCostsInCluster(goalNode, nodeClusters[goalNode], true);
+
+    const glm::vec3 &goalPosition = grid->getNode(goalNode).getPosition();
+    searchGeneration = nextGeneration(searchStamps, searchGeneration);
+    frontier.clear();
+    searchStamps[startNode] = searchGeneration;
+    closedNodes[startNode] = 0;
+    searchCosts[startNode] = 0;
+    searchParents[startNode] = AIMovementNode::NO_NEIGHBOUR;
+    frontier.push_back(std::make_pair(glm::length(goalPosition - grid->getNode(startNode).getPosition()), startNode));
+
+    bool isFound = false;
+    while (!frontier.empty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), std::greater<PriorityNode>());
+        uint32_t current = frontier.back().second;
+        frontier.pop_back();
+        if (closedNodes[current]) {
+            continue;//stale entry
+        }
+        closedNodes[current] = 1;
+        if (current == goalNode) {
+            isFound = true;
+            break;
+        }
+        if (current == startNode) {
+            for (size_t i = 0; i < startEntranceCosts.size(); ++i) {
+                relax(current, startEntranceCosts[i].first, startEntranceCosts[i].second, goalPosition);
+            }
+        }
+        auto abstractNode = abstractNodes.find(current);
+        if (abstractNode != abstractNodes.end()) {
+            for (size_t i = 0; i < abstractNode->second.edges.size(); ++i) {
+                relax(current, abstractNode->second.edges[i].target, abstractNode->second.edges[i].cost, goalPosition);
+            }
+        }
+        float goalCost;
+        if (getClusterCost(current, &goalCost)) {
+            relax(current, goalNode, goalCost, goalPosition);
+        }
+    }
+
+    if (!isFound) {
+        return false;
+    }
+    waypoints->clear();
+    for (uint32_t node = goalNode; node != AIMovementNode::NO_NEIGHBOUR; node = searchParents[node]) {
+        waypoints->push_back(node);
+    }
+    std::reverse(waypoints->begin(), waypoints->end());
+    return true;
+}
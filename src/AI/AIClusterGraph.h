@@ -0,0 +1,147 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_AICLUSTERGRAPH_H
+#define LIMONENGINE_AICLUSTERGRAPH_H
+
+
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+class AIMovementGrid;
+
+/**
+ * Abstract graph over the AI grid for hierarchical path search.
+ *
+ * Grid is divided into CLUSTER_SIZE x CLUSTER_SIZE clusters on the lattice. For each contiguous segment of a
+ * border between two clusters, one node pair is selected as entrance. Entrance nodes are the abstract nodes,
+ * they are connected by the crossing link to the other cluster, and by the precomputed costs of paths
+ * that stay in the cluster to the other entrances of the same cluster.
+ *
+ * Search is done on abstract nodes only, start and goal are connected to the entrances of their clusters
+ * for each search. Goal is connected over reverse links, since links might be one way. When grid walkability
+ * changes, only the changed clusters and their neighbours are rebuilt.
+ */
+class AIClusterGraph {
+public:
+    static const int32_t CLUSTER_SIZE = 16;
+
+private:
+    struct Edge {
+        uint32_t target;
+        float cost;
+    };
+
+    struct AbstractNode {
+        uint64_t cluster;
+        std::vector<Edge> edges;
+    };
+
+    /**
+     * first node is in the cluster with smaller key of the pair
+     */
+    struct Entrance {
+        uint32_t firstNode;
+        uint32_t secondNode;
+    };
+
+    typedef std::pair<float, uint32_t> PriorityNode;
+
+    const AIMovementGrid *grid;
+    glm::vec3 latticeOrigin;
+    std::vector<uint64_t> nodeClusters;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> clusterNodes;
+    std::map<std::pair<uint64_t, uint64_t>, std::vector<Entrance>> pairEntrances;
+    std::unordered_map<uint32_t, AbstractNode> abstractNodes;
+
+    /**
+     * Search scratch, indexed by grid node and reused between searches like grid A*. An entry is only valid if
+     * its stamp is equal to the generation, so nothing is cleared between searches.
+     */
+    std::vector<uint32_t> clusterCostStamps;
+    std::vector<float> clusterCosts;
+    uint32_t clusterCostGeneration = 0;
+    std::vector<uint32_t> searchStamps;
+    std::vector<float> searchCosts;
+    std::vector<uint32_t> searchParents;
+    std::vector<uint8_t> closedNodes;
+    uint32_t searchGeneration = 0;
+    std::vector<PriorityNode> frontier;//binary heap, stale entries are skipped when popped
+    std::vector<std::pair<uint32_t, float>> startEntranceCosts;
+
+    static uint32_t nextGeneration(std::vector<uint32_t> &stamps, uint32_t generation);
+
+    static uint64_t makeClusterKey(int32_t x, int32_t z) {
+        return (((uint64_t) (uint32_t) x) << 32) | ((uint64_t) (uint32_t) z);
+    }
+
+    static int32_t getClusterX(uint64_t key) {
+        return (int32_t) (uint32_t) (key >> 32);
+    }
+
+    static int32_t getClusterZ(uint64_t key) {
+        return (int32_t) (uint32_t) (key & 0xFFFFFFFF);
+    }
+
+    uint64_t calculateNodeCluster(uint32_t nodeIndex) const;
+
+    bool isLinked(uint32_t from, uint32_t to) const;
+
+    void collectCrossings(uint64_t fromCluster, uint64_t toCluster, bool fromIsFirst,
+                          std::set<std::pair<uint32_t, uint32_t>> &crossings) const;
+
+    void buildPairEntrances(uint64_t firstCluster, uint64_t secondCluster);
+
+    void buildAbstractNodes(uint64_t cluster);
+
+    /**
+     * Dijkstra that doesn't leave the cluster. Results are read by getClusterCost, until next call.
+     *
+     * @param isReverse if true, costs are from each node to startNode, following links backwards
+     */
+    void calculateCostsInCluster(uint32_t startNode, uint64_t cluster, bool isReverse);
+
+    bool getClusterCost(uint32_t nodeIndex, float *cost) const {
+        if (clusterCostStamps[nodeIndex] != clusterCostGeneration) {
+            return false;
+        }
+        *cost = clusterCosts[nodeIndex];
+        return true;
+    }
+
+    void relax(uint32_t from, uint32_t to, float edgeCost, const glm::vec3 &goalPosition);
+
+    void rebuildClusters(const std::set<uint64_t> &dirtyClusters);
+
+public:
+    explicit AIClusterGraph(const AIMovementGrid *grid);
+
+    uint64_t getNodeCluster(uint32_t nodeIndex) const {
+        return nodeClusters[nodeIndex];
+    }
+
+    /**
+     * Rebuilds clusters of the given nodes, and their neighbour clusters since entrances are shared.
+     */
+    void updateNodes(const std::vector<uint32_t> &changedNodes);
+
+    /**
+     * Searches the abstract graph.
+     *
+     * @param waypoints filled with grid node indices, from start to goal, both included
+     * @return false if goal can't be reached
+     */
+    bool findAbstractPath(uint32_t startNode, uint32_t goalNode, std::vector<uint32_t> *waypoints);
+
+    size_t getAbstractNodeCount() const {
+        return abstractNodes.size();
+    }
+};
+
+
+#endif //LIMONENGINE_AICLUSTERGRAPH_H
@@ -3,77 +3,262 @@
 //
 
 #include "AIMovementGrid.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+#include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcher.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <BulletCollision/CollisionDispatch/btManifoldResult.h>
 
 constexpr float AIMovementGrid::floatingHeight;
+const uint32_t AIMovementNode::NO_NEIGHBOUR;
+const uint32_t AIMovementGrid::CACHE_MAGIC;
+const uint32_t AIMovementGrid::CACHE_VERSION;
+const int32_t AIMovementGrid::TILE_SIZE;
+const uint32_t AIMovementGrid::CLEARANCE_BATCH_SIZE;
+const uint32_t AIMovementGrid::CLOSED_NODE;
 
-//FIXME: this must be the worst way to check for a node in a graph, when you already implemented a*
-AIMovementNode *AIMovementGrid::isAlreadyVisited(const AIMovementNode *node) {
-    for (int i = visited.size() - 1; i >= 0; --i) {
-        if (isPositionCloseEnough(node->getPosition(), visited[i]->getPosition())) {
-            return visited[i];
+/**
+ * Checks the grid capsule like contactTest does, but with its own dispatcher, so each worker thread can have one.
+ * Algorithm and manifold pools of the world dispatcher are not locked. World broadphase is only read.
+ */
+class ClearanceTester : public btBroadphaseAabbCallback {
+    struct PenetrationResult : public btManifoldResult {
+        bool hasPenetration = false;
+
+        PenetrationResult(const btCollisionObjectWrapper *body0Wrap, const btCollisionObjectWrapper *body1Wrap)
+                : btManifoldResult(body0Wrap, body1Wrap) {}
+
+        void addContactPoint(const btVector3 &normalOnBInWorld, const btVector3 &pointInWorld, btScalar depth) override {
+            if (depth < 0.f) {
+                hasPenetration = true;
+            }
         }
+    };
+
+    btDiscreteDynamicsWorld *staticWorld;
+    btDefaultCollisionConfiguration collisionConfiguration;
+    btCollisionDispatcher dispatcher;
+    btCollisionObject clearanceObject;
+    std::vector<const btCollisionObject *> candidates;
+
+public:
+    ClearanceTester(btDiscreteDynamicsWorld *staticWorld, btCollisionShape *shape)
+            : staticWorld(staticWorld), dispatcher(&collisionConfiguration) {
+        clearanceObject.setCollisionShape(shape);
     }
-    return nullptr;
+
+    bool process(const btBroadphaseProxy *proxy) override {
+        //same filtering with shared ghost object
+        if ((proxy->m_collisionFilterGroup & (btBroadphaseProxy::AllFilter & ~btBroadphaseProxy::SensorTrigger)) != 0 &&
+            (proxy->m_collisionFilterMask & btBroadphaseProxy::SensorTrigger) != 0) {
+            candidates.push_back(static_cast<const btCollisionObject *>(proxy->m_clientObject));
+        }
+        return true;
+    }
+
+    bool hasPenetration(const glm::vec3 &position) {
+        btTransform transform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(position));
+        clearanceObject.setWorldTransform(transform);
+        btVector3 aabbMin, aabbMax;
+        clearanceObject.getCollisionShape()->getAabb(transform, aabbMin, aabbMax);
+        candidates.clear();
+        staticWorld->getBroadphase()->aabbTest(aabbMin, aabbMax, *this);
+
+        btCollisionObjectWrapper clearanceWrapper(nullptr, clearanceObject.getCollisionShape(), &clearanceObject,
+                                                  transform, -1, -1);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            btCollisionObjectWrapper candidateWrapper(nullptr, candidates[i]->getCollisionShape(), candidates[i],
+                                                      candidates[i]->getWorldTransform(), -1, -1);
+            btCollisionAlgorithm *algorithm = dispatcher.findAlgorithm(&clearanceWrapper, &candidateWrapper, nullptr,
+                                                                       BT_CLOSEST_POINT_ALGORITHMS);
+            if (algorithm == nullptr) {
+                continue;
+            }
+            PenetrationResult penetrationResult(&clearanceWrapper, &candidateWrapper);
+            algorithm->processCollision(&clearanceWrapper, &candidateWrapper, staticWorld->getDispatchInfo(),
+                                        &penetrationResult);
+            algorithm->~btCollisionAlgorithm();
+            dispatcher.freeCollisionAlgorithm(algorithm);
+            if (penetrationResult.hasPenetration) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+uint32_t AIMovementGrid::isAlreadyVisited(const glm::vec3 &position) const {
+    auto range = nodeHashMap.equal_range(getLatticeKey(position));
+    for (auto it = range.first; it != range.second; ++it) {
+        //same lattice point might have multiple nodes with different heights
+        if (isPositionCloseEnough(position, generatedNodes[it->second].getPosition())) {
+            return it->second;
+        }
+    }
+    return AIMovementNode::NO_NEIGHBOUR;
 }
 
-const AIMovementNode *
-AIMovementGrid::aStarPath(const AIMovementNode *start, const glm::vec3 &destination, std::vector<glm::vec3> *route) {
-    std::priority_queue<AINodeWithPriority, std::vector<AINodeWithPriority>, std::greater<AINodeWithPriority>> frontier;
-    frontier.push(AINodeWithPriority(start, 0));
+void AIMovementGrid::printPathSearchStats() const {
+    if (pathSearchStats.queryCount == 0) {
+        return;
+    }
+    std::cout << "AI path searches: " << pathSearchStats.queryCount << " queries, "
+              << pathSearchStats.nodesExpanded / pathSearchStats.queryCount << " nodes expanded and "
+              << pathSearchStats.microseconds / pathSearchStats.queryCount << " us per query on average."
+              << std::endl;
+}
 
-    std::unordered_map<const AIMovementNode *, const AIMovementNode *> from;
-    std::unordered_map<const AIMovementNode *, float> totalCost;
-    const AIMovementNode *finalNode = nullptr;
-    from[start] = nullptr;
-    totalCost[start] = 0;
-    while (!frontier.empty()) {
-        AINodeWithPriority nodeWithPriority = frontier.top();
-        //std::cout << "testing with a* " << GLMUtils::vectorToString(nodeWithPriority.node->getPosition()) << std::endl;
-        frontier.pop();
-        if (isPositionCloseEnough(destination, nodeWithPriority.node->getPosition())) {
-            finalNode = nodeWithPriority.node;
+void AIMovementGrid::prepareSearch() {
+    if (searchStamps.size() != nodeCount) {
+        searchStamps.assign(nodeCount, 0);
+        searchParents.resize(nodeCount);
+        searchCosts.resize(nodeCount);
+        searchPriorities.resize(nodeCount);
+        heapPositions.resize(nodeCount);
+        openHeap.reserve(nodeCount);
+        searchGeneration = 0;
+    }
+    searchGeneration++;
+    if (searchGeneration == 0) {
+        //wrapped around, old stamps might match again
+        std::fill(searchStamps.begin(), searchStamps.end(), 0);
+        searchGeneration = 1;
+    }
+    openHeap.clear();
+}
+
+void AIMovementGrid::heapSiftUp(uint32_t heapPosition) {
+    uint32_t nodeIndex = openHeap[heapPosition];
+    float priority = searchPriorities[nodeIndex];
+    while (heapPosition > 0) {
+        uint32_t parentPosition = (heapPosition - 1) / 2;
+        uint32_t parentNode = openHeap[parentPosition];
+        if (searchPriorities[parentNode] <= priority) {
+            break;
+        }
+        openHeap[heapPosition] = parentNode;
+        heapPositions[parentNode] = heapPosition;
+        heapPosition = parentPosition;
+    }
+    openHeap[heapPosition] = nodeIndex;
+    heapPositions[nodeIndex] = heapPosition;
+}
+
+void AIMovementGrid::heapSiftDown(uint32_t heapPosition) {
+    uint32_t heapSize = (uint32_t) openHeap.size();
+    uint32_t nodeIndex = openHeap[heapPosition];
+    float priority = searchPriorities[nodeIndex];
+    while (true) {
+        uint32_t childPosition = heapPosition * 2 + 1;
+        if (childPosition >= heapSize) {
+            break;
+        }
+        if (childPosition + 1 < heapSize &&
+            searchPriorities[openHeap[childPosition + 1]] < searchPriorities[openHeap[childPosition]]) {
+            childPosition++;
+        }
+        uint32_t childNode = openHeap[childPosition];
+        if (priority <= searchPriorities[childNode]) {
+            break;
+        }
+        openHeap[heapPosition] = childNode;
+        heapPositions[childNode] = heapPosition;
+        heapPosition = childPosition;
+    }
+    openHeap[heapPosition] = nodeIndex;
+    heapPositions[nodeIndex] = heapPosition;
+}
+
+void AIMovementGrid::heapPush(uint32_t nodeIndex) {
+    openHeap.push_back(nodeIndex);//never reallocates, reserved for all nodes
+    heapSiftUp((uint32_t) openHeap.size() - 1);
+}
+
+uint32_t AIMovementGrid::heapPopMin() {
+    uint32_t minNode = openHeap[0];
+    uint32_t lastNode = openHeap.back();
+    openHeap.pop_back();
+    if (!openHeap.empty()) {
+        openHeap[0] = lastNode;
+        heapSiftDown(0);
+    }
+    heapPositions[minNode] = CLOSED_NODE;
+    return minNode;
+}
+
+uint32_t
+AIMovementGrid::aStarPath(uint32_t start, const glm::vec3 &destination, std::vector<glm::vec3> *route) {
+    Uint64 searchStartTime = SDL_GetPerformanceCounter();
+    prepareSearch();
+    uint32_t expandedNodeCount = 0;
+
+    searchStamps[start] = searchGeneration;
+    searchParents[start] = AIMovementNode::NO_NEIGHBOUR;
+    searchCosts[start] = 0;
+    searchPriorities[start] = glm::length(destination - nodes[start].getPosition());
+    heapPush(start);
+
+    uint32_t finalNode = AIMovementNode::NO_NEIGHBOUR;
+    while (!openHeap.empty()) {
+        uint32_t currentIndex = heapPopMin();
+        expandedNodeCount++;
+        const AIMovementNode &node = nodes[currentIndex];
+        if (isPositionCloseEnough(destination, node.getPosition())) {
+            finalNode = currentIndex;
             break;
         }
 
         for (int i = 0; i < 9; ++i) {
-            AIMovementNode *currentNode = nodeWithPriority.node->getNeighbour(i);
-            if (currentNode == nullptr) {
+            uint32_t neighbour = node.getNeighbour(i);
+            if (neighbour == AIMovementNode::NO_NEIGHBOUR) {
                 continue;
             }
-            if (!currentNode->isIsMovable()) {
+            if (!isNodeWalkable(neighbour)) {
                 continue;//if not movable, it means we don't need its child
             }
-            //make going cross a little harder
-            float movementCost = glm::length(currentNode->getPosition() - nodeWithPriority.node->getPosition());
-            float heuristic = glm::length(destination - currentNode->getPosition());
-            float currentCost = totalCost[nodeWithPriority.node] + movementCost + heuristic;
-            if (!totalCost.count(currentNode) || currentCost < totalCost[currentNode]) {
-                //float currentPriority = currentCost + heuristic;
-//                std::cout << "for node " << GLMUtils::vectorToString(currentNode->getPosition()) << " priority is " << currentCost << " with heuristic " << heuristic << std::endl;
-                frontier.push(AINodeWithPriority(currentNode, currentCost));
-                from[currentNode] = nodeWithPriority.node;
-                totalCost[currentNode] = currentCost;
+            bool isSeen = isNodeSeen(neighbour);
+            if (isSeen && heapPositions[neighbour] == CLOSED_NODE) {
+                continue;//heuristic is straight distance so it is consistent, closed nodes can't get cheaper
+            }
+            float cost = searchCosts[currentIndex] + glm::length(nodes[neighbour].getPosition() - node.getPosition());
+            if (isSeen && cost >= searchCosts[neighbour]) {
+                continue;
+            }
+            searchParents[neighbour] = currentIndex;
+            searchCosts[neighbour] = cost;
+            searchPriorities[neighbour] = cost + glm::length(destination - nodes[neighbour].getPosition());
+            if (isSeen) {
+                heapSiftUp(heapPositions[neighbour]);//decrease key
+            } else {
+                searchStamps[neighbour] = searchGeneration;
+                heapPush(neighbour);
             }
         }
-
     }
 
-    if (finalNode == nullptr) {
-        std::cerr << "Path search failed, please check the values: " << GLMUtils::vectorToString(start->getPosition())
+    pathSearchStats.queryCount++;
+    pathSearchStats.nodesExpanded += expandedNodeCount;
+    pathSearchStats.microseconds +=
+            ((SDL_GetPerformanceCounter() - searchStartTime) * 1000000) / SDL_GetPerformanceFrequency();
+
+    if (finalNode == AIMovementNode::NO_NEIGHBOUR) {
+        std::cerr << "Path search failed, please check the values: " << GLMUtils::vectorToString(nodes[start].getPosition())
                   << " to " << GLMUtils::vectorToString(destination) << std::endl;
         return finalNode;
     } else {
-        if (start == finalNode) {
+        if (start == finalNode || route == nullptr) {
             return finalNode;//don't put anything to the route;
         }
         route->clear();
-        route->push_back(finalNode->getPosition());
-        //std::cout << GLMUtils::vectorToString(finalNode->getPosition()) << ", " << (finalNode->isIsMovable()? " yes":"no") << std::endl;
-        const AIMovementNode *fromNode = from[finalNode];
+        route->push_back(nodes[finalNode].getPosition());
+        uint32_t fromNode = searchParents[finalNode];
         while (start != fromNode) {
-            route->push_back(fromNode->getPosition());
-            fromNode = from[fromNode];
-            //std::cout << GLMUtils::vectorToString(fromNode->getPosition()) << ", " << (fromNode->isIsMovable()? " yes":"no") << std::endl;
+            route->push_back(nodes[fromNode].getPosition());
+            fromNode = searchParents[fromNode];
         }
         return finalNode;
     }
@@ -107,45 +292,52 @@ bool AIMovementGrid::setProperHeight(glm::vec3 *position, float floatingHeight,
     }
 }
 
-AIMovementNode *
+uint32_t
 AIMovementGrid::walkMonster(glm::vec3 walkPoint, btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min,
-                            const glm::vec3 &max) {
-    std::queue<AIMovementNode *> frontier;
+                            const glm::vec3 &max, const SampledColumns *sampledColumns) {
+    std::queue<uint32_t> frontier;
     if (!setProperHeight(&walkPoint, floatingHeight, 0.0f, staticWorld)) {
         std::cerr << "Root node has nothing underneath, grid generation failed. " << std::endl;
-        return root;
+        return AIMovementNode::NO_NEIGHBOUR;
     }
-    AIMovementNode *root = new AIMovementNode(walkPoint);
+    latticeOrigin = walkPoint;
+    uint32_t root = createNode(walkPoint);
     staticWorld->addCollisionObject(sharedGhostObject, btBroadphaseProxy::SensorTrigger,
                                     btBroadphaseProxy::AllFilter & ~btBroadphaseProxy::SensorTrigger);
     sharedGhostObject->setWorldTransform(
-            btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(root->getPosition())));
+            btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(walkPoint)));
     bool isMovable = !isThereCollision(staticWorld);
     staticWorld->removeCollisionObject(sharedGhostObject);
     if (isMovable) {
-        root->setIsMovable(isMovable);
+        generatedNodes[root].setIsMovable(isMovable);
         frontier.push(root);
-        visited.push_back(root);
     } else {
         std::cerr << "Root node " << GLMUtils::vectorToString(walkPoint) << "is not movable, AI walk grid generation failed. Please check map." << std::endl;
         return root;
     }
-    AIMovementNode *current;
+    uint32_t current;
     while (!frontier.empty()) {
         current = frontier.front();
         frontier.pop();
+        //copy, since creating nodes might reallocate the vector
+        glm::vec3 currentPosition = generatedNodes[current].getPosition();
         for (int i = -1; i <= 1; ++i) {
             for (int j = -1; j <= 1; ++j) {
                 if (i == 0 && j == 0) {
                     continue; //skip the center, it is the self
                 } else {
-                    if (current->getPosition().x < 1.1 && current->getPosition().x > -1.1 &&
-                        current->getPosition().z < 0.1 && current->getPosition().z > -0.1) {
-                    }
                     int neighbourIndex = (i + 1) * 3 + (j + 1);
-                    glm::vec3 neighbourPosition = current->getPosition() + glm::vec3(i, 0, j);
-                    if (!setProperHeight(&neighbourPosition, floatingHeight, floatingHeight + 1.0f, staticWorld)) {
-                        current->setNeighbour(neighbourIndex, nullptr);
+                    glm::vec3 neighbourPosition = currentPosition + glm::vec3(i, 0, j);
+                    bool isSurfaceFound;
+                    if (sampledColumns != nullptr) {
+                        isSurfaceFound = setSampledHeight(&neighbourPosition, floatingHeight, floatingHeight + 1.0f,
+                                                          *sampledColumns);
+                    } else {
+                        isSurfaceFound = setProperHeight(&neighbourPosition, floatingHeight, floatingHeight + 1.0f,
+                                                         staticWorld);
+                    }
+                    if (!isSurfaceFound) {
+                        generatedNodes[current].setNeighbour(neighbourIndex, AIMovementNode::NO_NEIGHBOUR);
                         continue;// if there is nothing under for 1.5f, than don't process this node.
                     }
 
@@ -154,26 +346,24 @@ AIMovementGrid::walkMonster(glm::vec3 walkPoint, btDiscreteDynamicsWorld *static
                         //this means this position is out of whole world AABB, skip
                         continue;
                     }
-                    AIMovementNode *neighbour = new AIMovementNode(neighbourPosition);
-                    AIMovementNode *visitedNode = isAlreadyVisited(neighbour);
-                    if (visitedNode != nullptr) {
-                        //std::cout << "already visited node at " << GLMUtils::vectorToString(neighbourPosition) << std::endl;
-                        //std::cout << "already visited node position is " << GLMUtils::vectorToString(visitedNode->getPosition()) << std::endl;
-                        current->setNeighbour(neighbourIndex, visitedNode);
-                        delete neighbour;
+                    uint32_t visitedNode = isAlreadyVisited(neighbourPosition);
+                    if (visitedNode != AIMovementNode::NO_NEIGHBOUR) {
+                        generatedNodes[current].setNeighbour(neighbourIndex, visitedNode);
                     } else {
-//                        std::cout << "adding new node with position " << GLMUtils::vectorToString(neighbourPosition) << std::endl;
-                        staticWorld->addCollisionObject(sharedGhostObject, btBroadphaseProxy::SensorTrigger,
-                                                        btBroadphaseProxy::AllFilter &
-                                                        ~btBroadphaseProxy::SensorTrigger);
-                        sharedGhostObject->setWorldTransform(
-                                btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(neighbourPosition)));
-                        isMovable = !isThereCollision(staticWorld);
-                        staticWorld->removeCollisionObject(sharedGhostObject);
-                        neighbour->setIsMovable(isMovable);
-                        current->setNeighbour(neighbourIndex, neighbour);
+                        uint32_t neighbour = createNode(neighbourPosition);
+                        //movable flag doesn't change the walk, so sampled walk leaves it to clearance workers
+                        if (sampledColumns == nullptr) {
+                            staticWorld->addCollisionObject(sharedGhostObject, btBroadphaseProxy::SensorTrigger,
+                                                            btBroadphaseProxy::AllFilter &
+                                                            ~btBroadphaseProxy::SensorTrigger);
+                            sharedGhostObject->setWorldTransform(
+                                    btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(neighbourPosition)));
+                            isMovable = !isThereCollision(staticWorld);
+                            staticWorld->removeCollisionObject(sharedGhostObject);
+                            generatedNodes[neighbour].setIsMovable(isMovable);
+                        }
+                        generatedNodes[current].setNeighbour(neighbourIndex, neighbour);
                         frontier.push(neighbour);
-                        visited.push_back(neighbour);
                     }
                 }
             }
@@ -215,8 +405,164 @@ bool AIMovementGrid::isThereCollision(btDiscreteDynamicsWorld *staticWorld) {
     return false;
 }
 
+void AIMovementGrid::sampleTile(Tile &tile, btDiscreteDynamicsWorld *staticWorld, float fromHeight,
+                                float toHeight) const {
+    tile.surfaceOffsets.push_back(0);
+    for (int32_t x = tile.startX; x < tile.endX; ++x) {
+        for (int32_t z = tile.startZ; z < tile.endZ; ++z) {
+            btVector3 from(latticeOrigin.x + x, fromHeight, latticeOrigin.z + z);
+            btVector3 to(latticeOrigin.x + x, toHeight, latticeOrigin.z + z);
+            btCollisionWorld::AllHitsRayResultCallback rayResults(from, to);
+            staticWorld->rayTest(from, to, rayResults);
+
+            //walk doesn't check hit normals, so faces looking down are kept too
+            size_t columnStart = tile.surfaceHeights.size();
+            for (int k = 0; k < rayResults.m_hitPointWorld.size(); ++k) {
+                tile.surfaceHeights.push_back(rayResults.m_hitPointWorld[k].getY());
+            }
+            std::sort(tile.surfaceHeights.begin() + columnStart, tile.surfaceHeights.end(), std::greater<float>());
+            tile.surfaceOffsets.push_back((uint32_t) tile.surfaceHeights.size());
+        }
+    }
+}
+
+int AIMovementGrid::staticTileWorker(void *workerParameters) {
+    TileWorkerParameters *parameters = static_cast<TileWorkerParameters *>(workerParameters);
+    std::vector<Tile> &tiles = parameters->sampledColumns->tiles;
+    while (true) {
+        int tileIndex = SDL_AtomicAdd(parameters->nextTile, 1);
+        if (tileIndex >= (int) tiles.size()) {
+            break;
+        }
+        parameters->grid->sampleTile(tiles[tileIndex], parameters->staticWorld, parameters->fromHeight,
+                                     parameters->toHeight);
+    }
+    return 0;
+}
+
+int AIMovementGrid::staticClearanceWorker(void *workerParameters) {
+    ClearanceWorkerParameters *parameters = static_cast<ClearanceWorkerParameters *>(workerParameters);
+    std::vector<AIMovementNode> &nodes = parameters->grid->generatedNodes;
+    ClearanceTester clearanceTester(parameters->staticWorld, parameters->grid->ghostShape);
+    while (true) {
+        //root is checked by walk
+        size_t batchStart = 1 + (size_t) SDL_AtomicAdd(parameters->nextBatch, 1) * CLEARANCE_BATCH_SIZE;
+        if (batchStart >= nodes.size()) {
+            break;
+        }
+        size_t batchEnd = std::min(batchStart + CLEARANCE_BATCH_SIZE, nodes.size());
+        for (size_t i = batchStart; i < batchEnd; ++i) {
+            nodes[i].setIsMovable(!clearanceTester.hasPenetration(nodes[i].getPosition()));
+        }
+        SDL_AtomicAdd(parameters->testCount, (int) (batchEnd - batchStart));
+    }
+    return 0;
+}
+
+void AIMovementGrid::runWorkers(int (*worker)(void *), void *workerParameters, size_t threadCount) {
+    //calling thread works too, so one less thread is created
+    std::vector<SDL_Thread *> workers(std::max((size_t) 1, threadCount) - 1);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i] = SDL_CreateThread(worker, "aiGridWorker", workerParameters);
+        if (workers[i] == nullptr) {
+            std::cerr << "AI grid worker thread creation failed. " << SDL_GetError() << std::endl;
+        }
+    }
+    worker(workerParameters);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (workers[i] != nullptr) {
+            SDL_WaitThread(workers[i], nullptr);
+        }
+    }
+}
+
+bool AIMovementGrid::setSampledHeight(glm::vec3 *position, float floatingHeight, float checkHeight,
+                                      const SampledColumns &sampledColumns) const {
+    int32_t x = (int32_t) std::lround(position->x - latticeOrigin.x);
+    int32_t z = (int32_t) std::lround(position->z - latticeOrigin.z);
+    if (x < sampledColumns.startX || x >= sampledColumns.endX || z < sampledColumns.startZ ||
+        z >= sampledColumns.endZ) {
+        return false;//out of world AABB, walk skips these anyway
+    }
+    const Tile &tile = sampledColumns.tiles[((x - sampledColumns.startX) / TILE_SIZE) * sampledColumns.tileCountZ +
+                                            (z - sampledColumns.startZ) / TILE_SIZE];
+    uint32_t column = (uint32_t) ((x - tile.startX) * (tile.endZ - tile.startZ) + (z - tile.startZ));
+    //heights are descending, first one below position is what a ray from position would hit
+    for (uint32_t k = tile.surfaceOffsets[column]; k < tile.surfaceOffsets[column + 1]; ++k) {
+        float height = tile.surfaceHeights[k];
+        if (height > position->y) {
+            continue;
+        }
+        if (height < position->y - checkHeight) {
+            return false;
+        }
+        position->y = height + floatingHeight;
+        return true;
+    }
+    return false;
+}
+
+uint32_t AIMovementGrid::generateParallel(glm::vec3 walkPoint, btDiscreteDynamicsWorld *staticWorld,
+                                          const glm::vec3 &min, const glm::vec3 &max, uint32_t threadCount) {
+    glm::vec3 rootPosition = walkPoint;
+    if (!setProperHeight(&rootPosition, floatingHeight, 0.0f, staticWorld)) {
+        std::cerr << "Root node has nothing underneath, grid generation failed. " << std::endl;
+        return AIMovementNode::NO_NEIGHBOUR;
+    }
+    //walk uses the same origin, so columns are on its lattice
+    latticeOrigin = rootPosition;
+
+    SampledColumns sampledColumns;
+    sampledColumns.startX = (int32_t) std::ceil(min.x - latticeOrigin.x);
+    sampledColumns.endX = (int32_t) std::floor(max.x - latticeOrigin.x) + 1;
+    sampledColumns.startZ = (int32_t) std::ceil(min.z - latticeOrigin.z);
+    sampledColumns.endZ = (int32_t) std::floor(max.z - latticeOrigin.z) + 1;
+    sampledColumns.tileCountZ = (sampledColumns.endZ - sampledColumns.startZ + TILE_SIZE - 1) / TILE_SIZE;
+    for (int32_t x = sampledColumns.startX; x < sampledColumns.endX; x += TILE_SIZE) {
+        for (int32_t z = sampledColumns.startZ; z < sampledColumns.endZ; z += TILE_SIZE) {
+            Tile tile;
+            tile.startX = x;
+            tile.startZ = z;
+            tile.endX = std::min(x + TILE_SIZE, sampledColumns.endX);
+            tile.endZ = std::min(z + TILE_SIZE, sampledColumns.endZ);
+            sampledColumns.tiles.push_back(tile);
+        }
+    }
+
+    SDL_atomic_t nextTile;
+    SDL_AtomicSet(&nextTile, 0);
+    TileWorkerParameters tileParameters;
+    tileParameters.grid = this;
+    tileParameters.staticWorld = staticWorld;
+    tileParameters.sampledColumns = &sampledColumns;
+    tileParameters.nextTile = &nextTile;
+    //walk rays start from a node, and go floatingHeight + 1 down. Nodes are in AABB, except root
+    tileParameters.fromHeight = std::max(max.y, rootPosition.y);
+    tileParameters.toHeight = min.y - floatingHeight - 1.0f;
+    runWorkers(&staticTileWorker, &tileParameters, std::min((size_t) threadCount, sampledColumns.tiles.size()));
+
+    uint32_t root = walkMonster(walkPoint, staticWorld, min, max, &sampledColumns);
+    if (root == AIMovementNode::NO_NEIGHBOUR || generatedNodes.size() < 2) {
+        return root;
+    }
+
+    //walk only created nodes reachable from root, so nothing else is checked
+    SDL_atomic_t nextBatch, testCount;
+    SDL_AtomicSet(&nextBatch, 0);
+    SDL_AtomicSet(&testCount, 0);
+    ClearanceWorkerParameters clearanceParameters;
+    clearanceParameters.grid = this;
+    clearanceParameters.staticWorld = staticWorld;
+    clearanceParameters.nextBatch = &nextBatch;
+    clearanceParameters.testCount = &testCount;
+    size_t batchCount = (generatedNodes.size() - 1 + CLEARANCE_BATCH_SIZE - 1) / CLEARANCE_BATCH_SIZE;
+    runWorkers(&staticClearanceWorker, &clearanceParameters, std::min((size_t) threadCount, batchCount));
+    isThereCollisionCounter += SDL_AtomicGet(&testCount);
+    return root;
+}
+
 AIMovementGrid::AIMovementGrid(glm::vec3 startPoint, btDiscreteDynamicsWorld *staticOnlyPhysicsWorld, glm::vec3 min,
-                               glm::vec3 max) {
+                               glm::vec3 max, uint32_t threadCount) {
     //sharedGhostObject->setCollisionShape(new btBoxShape(btVector3(1.0f,1.0f,1.0f)));
     //sharedGhostObject->setCollisionShape(new btCapsuleShape(1,1));
     ghostShape = new btCapsuleShape(capsuleRadius, capsuleHeight);
@@ -225,25 +571,361 @@ AIMovementGrid::AIMovementGrid(glm::vec3 startPoint, btDiscreteDynamicsWorld *st
             sharedGhostObject->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE);
     sharedGhostObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(startPoint)));
     std::cout << "Start generating AI walk grid" << std::endl;
-    root = walkMonster(startPoint, staticOnlyPhysicsWorld, min, max);
-    std::cout << "Finished generating AI walk grid, created " << visited.size() << " nodes, checked for collision "
+    long start = SDL_GetTicks();
+#if !BT_THREADSAFE
+    if (threadCount > 1) {
+        std::cerr << "Bullet is not built thread safe, AI walk grid will be generated on single thread." << std::endl;
+        threadCount = 1;
+    }
+#endif
+    if (threadCount > 1) {
+        rootIndex = generateParallel(startPoint, staticOnlyPhysicsWorld, min, max, threadCount);
+    } else {
+        rootIndex = walkMonster(startPoint, staticOnlyPhysicsWorld, min, max);
+    }
+    finalizeNodes();
+    buildSearchStructures();
+    long end = SDL_GetTicks();
+    std::cout << "Finished generating AI walk grid in " << end - start << "ms, created " << nodeCount << " nodes, checked for collision "
               << isThereCollisionCounter << " times." << std::endl;
     staticOnlyPhysicsWorld->removeCollisionObject(sharedGhostObject);
 }
 
+AIMovementGrid *AIMovementGrid::loadFromCache(const std::string &cacheFileName, uint64_t geometryHash) {
+    AIMovementGrid *grid = new AIMovementGrid();
+    if (!grid->cacheFile.open(cacheFileName)) {
+        delete grid;
+        return nullptr;
+    }
+    const uint8_t *data = grid->cacheFile.getData();
+    size_t size = grid->cacheFile.getSize();
+    if (size < sizeof(CacheFileHeader)) {
+        std::cerr << "AI grid cache " << cacheFileName << " is truncated, it will be regenerated." << std::endl;
+        delete grid;
+        return nullptr;
+    }
+    CacheFileHeader header;
+    memcpy(&header, data, sizeof(CacheFileHeader));
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.nodeSize != sizeof(AIMovementNode)) {
+        std::cerr << "AI grid cache " << cacheFileName << " has unknown format, it will be regenerated." << std::endl;
+        delete grid;
+        return nullptr;
+    }
+    if (header.geometryHash != geometryHash) {
+        std::cout << "AI grid cache " << cacheFileName << " is stale, it will be regenerated." << std::endl;
+        delete grid;
+        return nullptr;
+    }
+    if (size != sizeof(CacheFileHeader) + header.nodeCount * sizeof(AIMovementNode) ||
+        (header.nodeCount > 0 && header.rootIndex >= header.nodeCount)) {
+        std::cerr << "AI grid cache " << cacheFileName << " is corrupted, it will be regenerated." << std::endl;
+        delete grid;
+        return nullptr;
+    }
+    //header size is multiple of 8, so nodes are aligned properly in the mapping
+    grid->nodes = reinterpret_cast<const AIMovementNode *>(data + sizeof(CacheFileHeader));
+    grid->nodeCount = (uint32_t) header.nodeCount;
+    grid->rootIndex = header.nodeCount > 0 ? header.rootIndex : AIMovementNode::NO_NEIGHBOUR;
+    grid->buildSearchStructures();
+    std::cout << "Loaded AI walk grid from " << cacheFileName << " with " << grid->nodeCount << " nodes." << std::endl;
+    return grid;
+}
+
+bool AIMovementGrid::serializeToCache(const std::string &cacheFileName, uint64_t geometryHash) const {
+    std::ofstream cacheStream(cacheFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!cacheStream.is_open()) {
+        std::cerr << "AI grid cache " << cacheFileName << " can't be opened for writing." << std::endl;
+        return false;
+    }
+    CacheFileHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.nodeSize = sizeof(AIMovementNode);
+    header.rootIndex = rootIndex;
+    header.geometryHash = geometryHash;
+    header.nodeCount = nodeCount;
+    cacheStream.write(reinterpret_cast<const char *>(&header), sizeof(CacheFileHeader));
+    cacheStream.write(reinterpret_cast<const char *>(nodes), nodeCount * sizeof(AIMovementNode));
+    cacheStream.close();
+    if (cacheStream.fail()) {
+        std::cerr << "AI grid cache " << cacheFileName << " write failed." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+uint32_t AIMovementGrid::findNode(const glm::vec3 &position, uint32_t hintNode) {
+    if (rootIndex == AIMovementNode::NO_NEIGHBOUR) {
+        return AIMovementNode::NO_NEIGHBOUR;
+    }
+    uint32_t current = hintNode < nodeCount ? hintNode : rootIndex;
+    float currentDistance = glm::length(position - nodes[current].getPosition());
+    while (currentDistance >= GRID_SNAP_DISTANCE) {
+        uint32_t closest = AIMovementNode::NO_NEIGHBOUR;
+        float closestDistance = currentDistance;
+        for (int i = 0; i < 9; ++i) {
+            uint32_t neighbour = nodes[current].getNeighbour(i);
+            if (neighbour == AIMovementNode::NO_NEIGHBOUR || !isNodeWalkable(neighbour)) {
+                continue;
+            }
+            float distance = glm::length(position - nodes[neighbour].getPosition());
+            if (distance < closestDistance) {
+                closest = neighbour;
+                closestDistance = distance;
+            }
+        }
+        if (closest == AIMovementNode::NO_NEIGHBOUR) {
+            break;
+        }
+        current = closest;
+        currentDistance = closestDistance;
+    }
+    if (currentDistance < GRID_SNAP_DISTANCE) {
+        return current;
+    }
+    //greedy walk is blocked by an obstacle, only the columns around position can have a close enough node
+    return findNodeInLattice(position);
+}
+
+void AIMovementGrid::buildLatticeIndex() {
+    latticeColumnOffsets.clear();
+    latticeColumnNodes.clear();
+    latticeWidth = 0;
+    latticeDepth = 0;
+    if (rootIndex == AIMovementNode::NO_NEIGHBOUR) {
+        return;
+    }
+    //cached grids don't store the origin, but it is the root position for both generation methods
+    latticeOrigin = nodes[rootIndex].getPosition();
+    int32_t maxX = 0, maxZ = 0;
+    latticeMinX = 0;
+    latticeMinZ = 0;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const glm::vec3 &position = nodes[i].getPosition();
+        int32_t x = (int32_t) std::lround(position.x - latticeOrigin.x);
+        int32_t z = (int32_t) std::lround(position.z - latticeOrigin.z);
+        latticeMinX = std::min(latticeMinX, x);
+        latticeMinZ = std::min(latticeMinZ, z);
+        maxX = std::max(maxX, x);
+        maxZ = std::max(maxZ, z);
+    }
+    latticeWidth = maxX - latticeMinX + 1;
+    latticeDepth = maxZ - latticeMinZ + 1;
+
+    std::vector<uint32_t> nodeColumns(nodeCount);
+    latticeColumnOffsets.assign((size_t) latticeWidth * latticeDepth + 1, 0);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const glm::vec3 &position = nodes[i].getPosition();
+        int32_t x = (int32_t) std::lround(position.x - latticeOrigin.x) - latticeMinX;
+        int32_t z = (int32_t) std::lround(position.z - latticeOrigin.z) - latticeMinZ;
+        nodeColumns[i] = (uint32_t) (x * latticeDepth + z);
+        latticeColumnOffsets[nodeColumns[i] + 1]++;
+    }
+    for (size_t i = 0; i + 1 < latticeColumnOffsets.size(); ++i) {
+        latticeColumnOffsets[i + 1] += latticeColumnOffsets[i];
+    }
+    latticeColumnNodes.resize(nodeCount);
+    std::vector<uint32_t> fillPositions(latticeColumnOffsets.begin(), latticeColumnOffsets.end() - 1);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        latticeColumnNodes[fillPositions[nodeColumns[i]]++] = i;
+    }
+}
+
+uint32_t AIMovementGrid::findNodeInLattice(const glm::vec3 &position) const {
+    if (latticeWidth == 0) {
+        return AIMovementNode::NO_NEIGHBOUR;
+    }
+    int32_t centerX = (int32_t) std::lround(position.x - latticeOrigin.x) - latticeMinX;
+    int32_t centerZ = (int32_t) std::lround(position.z - latticeOrigin.z) - latticeMinZ;
+    uint32_t closest = AIMovementNode::NO_NEIGHBOUR;
+    float closestDistance = GRID_SNAP_DISTANCE;
+    //snap distance is less than 1, so only the closest column and its direct neighbours are checked
+    for (int32_t x = std::max(centerX - 1, 0); x <= std::min(centerX + 1, latticeWidth - 1); ++x) {
+        for (int32_t z = std::max(centerZ - 1, 0); z <= std::min(centerZ + 1, latticeDepth - 1); ++z) {
+            uint32_t column = (uint32_t) (x * latticeDepth + z);
+            for (uint32_t k = latticeColumnOffsets[column]; k < latticeColumnOffsets[column + 1]; ++k) {
+                uint32_t nodeIndex = latticeColumnNodes[k];
+                if (!isNodeWalkable(nodeIndex)) {
+                    continue;
+                }
+                float distance = glm::length(position - nodes[nodeIndex].getPosition());
+                if (distance < closestDistance) {
+                    closest = nodeIndex;
+                    closestDistance = distance;
+                }
+            }
+        }
+    }
+    return closest;
+}
+
+void AIMovementGrid::buildSearchStructures() {
+    blockedNodes.assign(nodeCount, 0);
+    buildLatticeIndex();
+
+    reverseLinkOffsets.assign(nodeCount + 1, 0);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            if (nodes[i].getNeighbour(j) != AIMovementNode::NO_NEIGHBOUR) {
+                reverseLinkOffsets[nodes[i].getNeighbour(j) + 1]++;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        reverseLinkOffsets[i + 1] += reverseLinkOffsets[i];
+    }
+    reverseLinks.resize(reverseLinkOffsets[nodeCount]);
+    std::vector<uint32_t> fillPositions(reverseLinkOffsets.begin(), reverseLinkOffsets.end() - 1);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        for (int j = 0; j < 9; ++j) {
+            uint32_t neighbour = nodes[i].getNeighbour(j);
+            if (neighbour != AIMovementNode::NO_NEIGHBOUR) {
+                reverseLinks[fillPositions[neighbour]++] = i;
+            }
+        }
+    }
+    flowFieldGoal = AIMovementNode::NO_NEIGHBOUR;
+
+    delete clusterGraph;
+    long start = SDL_GetTicks();
+    clusterGraph = new AIClusterGraph(this);
+    long end = SDL_GetTicks();
+    std::cout << "Built AI cluster graph in " << end - start << "ms, with " << clusterGraph->getAbstractNodeCount()
+              << " entrance nodes." << std::endl;
+}
+
+void AIMovementGrid::setAreaBlocked(const glm::vec3 &min, const glm::vec3 &max, bool isBlocked) {
+    if (latticeWidth == 0) {
+        return;
+    }
+    std::vector<uint32_t> changedNodes;
+    //only columns that overlap the AABB can have nodes in it
+    int32_t startX = std::max((int32_t) std::ceil(min.x - latticeOrigin.x - 0.5f) - latticeMinX, 0);
+    int32_t endX = std::min((int32_t) std::floor(max.x - latticeOrigin.x + 0.5f) - latticeMinX, latticeWidth - 1);
+    int32_t startZ = std::max((int32_t) std::ceil(min.z - latticeOrigin.z - 0.5f) - latticeMinZ, 0);
+    int32_t endZ = std::min((int32_t) std::floor(max.z - latticeOrigin.z + 0.5f) - latticeMinZ, latticeDepth - 1);
+    for (int32_t x = startX; x <= endX; ++x) {
+        for (int32_t z = startZ; z <= endZ; ++z) {
+            uint32_t column = (uint32_t) (x * latticeDepth + z);
+            for (uint32_t k = latticeColumnOffsets[column]; k < latticeColumnOffsets[column + 1]; ++k) {
+                uint32_t i = latticeColumnNodes[k];
+                const glm::vec3 &position = nodes[i].getPosition();
+                if (position.x < min.x || position.y < min.y || position.z < min.z ||
+                    position.x > max.x || position.y > max.y || position.z > max.z) {
+                    continue;
+                }
+                if (isBlocked) {
+                    blockedNodes[i]++;
+                    if (blockedNodes[i] == 1) {
+                        changedNodes.push_back(i);
+                    }
+                } else if (blockedNodes[i] > 0) {
+                    blockedNodes[i]--;
+                    if (blockedNodes[i] == 0) {
+                        changedNodes.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+    if (!changedNodes.empty()) {
+        blockingGeneration++;
+        clusterGraph->updateNodes(changedNodes);
+        flowFieldGoal = AIMovementNode::NO_NEIGHBOUR;//force recalculation
+    }
+}
+
+void AIMovementGrid::updateFlowField(uint32_t goalNode) {
+    if (goalNode == flowFieldGoal) {
+        return;
+    }
+    flowFieldGoal = goalNode;
+    flowNextNodes.assign(nodeCount, AIMovementNode::NO_NEIGHBOUR);
+    if (goalNode >= nodeCount) {
+        return;
+    }
+    //same scratch and heap with A*, priority is cost since there is no heuristic
+    prepareSearch();
+    searchStamps[goalNode] = searchGeneration;
+    searchParents[goalNode] = AIMovementNode::NO_NEIGHBOUR;
+    searchCosts[goalNode] = 0;
+    searchPriorities[goalNode] = 0;
+    heapPush(goalNode);
+    while (!openHeap.empty()) {
+        uint32_t currentIndex = heapPopMin();
+        const glm::vec3 &currentPosition = nodes[currentIndex].getPosition();
+        for (uint32_t k = reverseLinkOffsets[currentIndex]; k < reverseLinkOffsets[currentIndex + 1]; ++k) {
+            uint32_t fromNode = reverseLinks[k];
+            if (!isNodeWalkable(fromNode)) {
+                continue;
+            }
+            bool isSeen = isNodeSeen(fromNode);
+            if (isSeen && heapPositions[fromNode] == CLOSED_NODE) {
+                continue;
+            }
+            float cost = searchCosts[currentIndex] + glm::length(nodes[fromNode].getPosition() - currentPosition);
+            if (isSeen && cost >= searchCosts[fromNode]) {
+                continue;
+            }
+            searchParents[fromNode] = currentIndex;
+            searchCosts[fromNode] = cost;
+            searchPriorities[fromNode] = cost;
+            if (isSeen) {
+                heapSiftUp(heapPositions[fromNode]);
+            } else {
+                searchStamps[fromNode] = searchGeneration;
+                heapPush(fromNode);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        if (isNodeSeen(i)) {
+            flowNextNodes[i] = searchParents[i];
+        }
+    }
+}
+
+bool AIMovementGrid::findPath(uint32_t startNode, uint32_t goalNode, std::vector<glm::vec3> *route) {
+    route->clear();
+    if (startNode >= nodeCount || goalNode >= nodeCount) {
+        return false;
+    }
+    if (startNode == goalNode) {
+        return true;
+    }
+    if (clusterGraph->getNodeCluster(startNode) == clusterGraph->getNodeCluster(goalNode)) {
+        return aStarPath(startNode, nodes[goalNode].getPosition(), route) != AIMovementNode::NO_NEIGHBOUR;
+    }
+
+    std::vector<uint32_t> waypoints;
+    if (!clusterGraph->findAbstractPath(startNode, goalNode, &waypoints)) {
+        return false;
+    }
+    //only first segment is needed for next step, rest is refined on later requests when actor gets there
+    std::vector<glm::vec3> firstSegment;
+    if (aStarPath(startNode, nodes[waypoints[1]].getPosition(), &firstSegment) == AIMovementNode::NO_NEIGHBOUR) {
+        return false;
+    }
+    for (size_t i = waypoints.size() - 1; i > 1; --i) {
+        route->push_back(nodes[waypoints[i]].getPosition());
+    }
+    route->insert(route->end(), firstSegment.begin(), firstSegment.end());
+    return true;
+}
+
 bool
 AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, int actorId, std::vector<glm::vec3> *route) {
 
     //first search for from node.
-    const AIMovementNode *fromAINode = nullptr;
+    uint32_t fromAINode = AIMovementNode::NO_NEIGHBOUR;
     if (actorLastNodeMap.find(actorId) != actorLastNodeMap.end()) {
         //if we already processed this actor before, use the last position of that actor we know
         fromAINode = actorLastNodeMap[actorId];
     } else {
         //if we never processed this actor, use root node for search start.
-        fromAINode = root;
+        fromAINode = rootIndex;
     }
-    if (fromAINode == nullptr) {
+    if (fromAINode == AIMovementNode::NO_NEIGHBOUR) {
         std::cerr << "Old from node turned out to be NULL. This shouldn't have happened" << std::endl;
         return false;
     }
@@ -251,7 +933,7 @@ AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, int actor
     //search where the actor is
     fromAINode = aStarPath(fromAINode, from, route);
 
-    if (fromAINode == nullptr) {
+    if (fromAINode == AIMovementNode::NO_NEIGHBOUR) {
         std::cerr << "new from node can't be found, this means snap distance is too small." << std::endl;
         return false;
     }
@@ -259,9 +941,9 @@ AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, int actor
     //save actor position to use on later calls
     actorLastNodeMap[actorId] = fromAINode;
 
-    const AIMovementNode *finalNode = aStarPath(fromAINode, to, route);
+    uint32_t finalNode = aStarPath(fromAINode, to, route);
 
-    if (finalNode == nullptr) {
+    if (finalNode == AIMovementNode::NO_NEIGHBOUR) {
         std::cerr << "Destination can't be reached, most likely player moved to somewhere AI can't." << std::endl;
         return false;
     } else {
@@ -271,12 +953,16 @@ AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, int actor
 
 bool AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, std::vector<glm::vec3> *route) {
     //first start by finding the from point. We should  cache these from values at some point, so we don't a* twice all the time
-    const AIMovementNode *fromAINode;
+    uint32_t fromAINode;
+
+    if (rootIndex == AIMovementNode::NO_NEIGHBOUR) {
+        return false;
+    }
 
     long start = SDL_GetTicks();
 
-    fromAINode = aStarPath(root, from, route);
-    if (fromAINode == nullptr) {
+    fromAINode = aStarPath(rootIndex, from, route);
+    if (fromAINode == AIMovementNode::NO_NEIGHBOUR) {
         return false;
     }
 
@@ -290,25 +976,26 @@ bool AIMovementGrid::coursePath(const glm::vec3 &from, const glm::vec3 &to, std:
 }
 
 void AIMovementGrid::debugDraw(BulletDebugDrawer *debugDrawer) const {
-    std::vector<AIMovementNode *>::const_iterator it;
     glm::vec3 toColor, fromColor;
-    for (it = visited.begin(); it != visited.end(); it++) {
+    for (uint32_t i = 0; i < nodeCount; i++) {
+        const AIMovementNode &node = nodes[i];
         int neighbourCount = 5; //if not an edge, just draw first 4, the last 4 should be rendered by the neighbours
-        if ((*it)->isIsMovable()) {
+        if (node.isIsMovable()) {
             fromColor = glm::vec3(1, 1, 1);
         } else {
             fromColor = glm::vec3(1, 0, 0);
             neighbourCount = 9; //if on an edge, neighbours will not be able to draw rest, draw all.
         }
         for (int j = 0; j < neighbourCount; ++j) {
-            if ((*it)->getNeighbour(j) != nullptr) {
-                if ((*it)->getNeighbour(j)->isIsMovable()) {
+            uint32_t neighbour = node.getNeighbour(j);
+            if (neighbour != AIMovementNode::NO_NEIGHBOUR) {
+                if (nodes[neighbour].isIsMovable()) {
                     toColor = glm::vec3(1, 1, 1);
                 } else {
                     toColor = glm::vec3(1, 0, 0);
                 }
-                debugDrawer->drawLine(GLMConverter::GLMToBlt((*it)->getPosition()),
-                                      GLMConverter::GLMToBlt((*it)->getNeighbour(j)->getPosition()),
+                debugDrawer->drawLine(GLMConverter::GLMToBlt(node.getPosition()),
+                                      GLMConverter::GLMToBlt(nodes[neighbour].getPosition()),
                                       GLMConverter::GLMToBlt(fromColor), GLMConverter::GLMToBlt(toColor));
             }
         }
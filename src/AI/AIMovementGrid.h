@@ -14,10 +14,16 @@
 #include <vector>
 #include <queue>
 #include <unordered_set>
+#include <unordered_map>
+#include <string>
 #include <map>
+#include <cmath>
+#include <SDL_atomic.h>
 
 #include "AIMovementNode.h"
+#include "AIClusterGraph.h"
 #include "../Utils/GLMConverter.h"
+#include "../Utils/MemoryMappedFile.h"
 #include "../Utils/GLMUtils.h"
 #include "../BulletDebugDrawer.h"
 
@@ -26,61 +32,333 @@
 
 class AIMovementGrid {
 
-    struct AINodeWithPriority {
-        const AIMovementNode *node;
-        float priority;
+public:
+    struct PathSearchStats {
+        uint64_t queryCount = 0;
+        uint64_t nodesExpanded = 0;
+        uint64_t microseconds = 0;
+    };
 
-        AINodeWithPriority(const AIMovementNode *node, float priority) : node(node), priority(priority) {}
+private:
+    /**
+     * Path search scratch. Arrays are indexed by node, and reused between searches. A node entry is only valid
+     * if its stamp is equal to current search generation, so nothing is cleared between searches.
+     */
+    static const uint32_t CLOSED_NODE = 0xFFFFFFFF;
+    std::vector<uint32_t> searchStamps;
+    std::vector<uint32_t> searchParents;
+    std::vector<float> searchCosts;//g
+    std::vector<float> searchPriorities;//f = g + h
+    std::vector<uint32_t> heapPositions;//position in openHeap, or CLOSED_NODE
+    std::vector<uint32_t> openHeap;
+    uint32_t searchGeneration = 0;
+    PathSearchStats pathSearchStats;
 
-        bool operator>(const AINodeWithPriority &aiRight) const {
-            return priority > aiRight.priority;
-        }
-    };
+    void prepareSearch();
+
+    bool isNodeSeen(uint32_t nodeIndex) const {
+        return searchStamps[nodeIndex] == searchGeneration;
+    }
+
+    void heapSiftUp(uint32_t heapPosition);
+
+    void heapSiftDown(uint32_t heapPosition);
+
+    void heapPush(uint32_t nodeIndex);
+
+    uint32_t heapPopMin();
 
     bool inline isPositionCloseEnough(const glm::vec3 &position1, const glm::vec3 &position2) const {
         return (glm::length(position1 - position2) < GRID_SNAP_DISTANCE);
     }
 
-    AIMovementNode *root = nullptr;
-    btCollisionShape *ghostShape;
+    /**
+     * Header of the cache file. Nodes follow the header directly, so file can be used without parsing.
+     */
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t nodeSize;
+        uint32_t rootIndex;
+        uint64_t geometryHash;
+        uint64_t nodeCount;
+    };
+
+    static const uint32_t CACHE_MAGIC = 0x44524741;//"AGRD"
+    static const uint32_t CACHE_VERSION = 2;
+
+    uint32_t rootIndex = AIMovementNode::NO_NEIGHBOUR;
+    btCollisionShape *ghostShape = nullptr;
     btPairCachingGhostObject *sharedGhostObject = new btPairCachingGhostObject();
     btCollisionWorld::ClosestRayResultCallback *rayCallback = new btCollisionWorld::ClosestRayResultCallback(
             btVector3(0, 0, 0), btVector3(0, 0, 0));
     btManifoldArray sharedManifoldArray;
-    std::map<int, const AIMovementNode *> actorLastNodeMap;
+    std::map<int, uint32_t> actorLastNodeMap;
 
     int isThereCollisionCounter = 0;//this is only meaninful for debug
     float capsuleHeight = 0.5f;
     float capsuleRadius = 0.5f;//FIXME these should be configurable
     bool isThereCollision(btDiscreteDynamicsWorld *staticWorld);
 
-    std::vector<AIMovementNode *> visited;
+    /**
+     * Filled while generating. After generation, or after loading from cache, nodes are accessed by
+     * nodes pointer, which points either this vector, or the memory mapped cache file.
+     */
+    std::vector<AIMovementNode> generatedNodes;
+    MemoryMappedFile cacheFile;
+    const AIMovementNode *nodes = nullptr;
+    uint32_t nodeCount = 0;
+
+    /**
+     * Nodes are placed on a 1 meter lattice starting from the root, so x and z offsets from root are integers.
+     * They are used as key, nodes with same x and z but different heights share the key. Only used while generating.
+     */
+    std::unordered_multimap<uint64_t, uint32_t> nodeHashMap;
+    glm::vec3 latticeOrigin;
+
+    uint64_t getLatticeKey(const glm::vec3 &position) const {
+        int32_t x = (int32_t) std::lround(position.x - latticeOrigin.x);
+        int32_t z = (int32_t) std::lround(position.z - latticeOrigin.z);
+        return (((uint64_t) (uint32_t) x) << 32) | ((uint64_t) (uint32_t) z);
+    }
+
+    /**
+     * Returns index instead of pointer, because vector might reallocate on next creation.
+     */
+    uint32_t createNode(const glm::vec3 &position) {
+        uint32_t index = (uint32_t) generatedNodes.size();
+        generatedNodes.emplace_back(position);
+        nodeHashMap.insert(std::make_pair(getLatticeKey(position), index));
+        return index;
+    }
 
-    AIMovementNode *isAlreadyVisited(const AIMovementNode *node);
+    /**
+     * Number of dynamic obstacles blocking each node. Nodes themselves might be in read only memory, so it is
+     * kept separately.
+     */
+    std::vector<uint16_t> blockedNodes;
+    uint32_t blockingGeneration = 0;//changes each time a node is blocked or unblocked
+    AIClusterGraph *clusterGraph = nullptr;
 
-    AIMovementNode *
-    walkMonster(glm::vec3 walkPoint, btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min, const glm::vec3 &max);
+    /**
+     * Lattice index of final nodes, built from node positions so cached grids have it too. Columns cover the
+     * lattice bounds of nodes densely, nodes of a column are in latticeColumnNodes between its offset and next one.
+     */
+    int32_t latticeMinX = 0;
+    int32_t latticeMinZ = 0;
+    int32_t latticeWidth = 0;
+    int32_t latticeDepth = 0;
+    std::vector<uint32_t> latticeColumnOffsets;
+    std::vector<uint32_t> latticeColumnNodes;
+
+    void buildLatticeIndex();
+
+    /**
+     * @return closest walkable node in snap distance, searching only the columns around position
+     */
+    uint32_t findNodeInLattice(const glm::vec3 &position) const;
+
+    /**
+     * Flow field is a Dijkstra from goal over links in reverse. For each node it keeps the next node towards goal.
+     * Reverse links are kept in compressed form, links of node i are between offsets i and i + 1.
+     */
+    std::vector<uint32_t> reverseLinkOffsets;
+    std::vector<uint32_t> reverseLinks;
+    std::vector<uint32_t> flowNextNodes;
+    uint32_t flowFieldGoal = AIMovementNode::NO_NEIGHBOUR;
+
+    void finalizeNodes() {
+        nodes = generatedNodes.data();
+        nodeCount = (uint32_t) generatedNodes.size();
+        nodeHashMap.clear();
+    }
+
+    void buildSearchStructures();
+
+    uint32_t isAlreadyVisited(const glm::vec3 &position) const;
+
+    /**
+     * Parallel generation samples every lattice column of the world AABB first. Columns are grouped in tiles, and
+     * worker threads take tiles until none left. Each column keeps heights of all surfaces the ray hit, in
+     * descending order, so walk can find what its own ray would hit without a ray test.
+     */
+    static const int32_t TILE_SIZE = 16;
+
+    struct Tile {
+        int32_t startX, startZ;
+        int32_t endX, endZ;//exclusive
+        std::vector<uint32_t> surfaceOffsets;//surfaces of a column are between its offset and next one
+        std::vector<float> surfaceHeights;
+    };
+
+    struct SampledColumns {
+        int32_t startX, startZ;
+        int32_t endX, endZ;//exclusive
+        int32_t tileCountZ;
+        std::vector<Tile> tiles;
+    };
+
+    struct TileWorkerParameters {
+        AIMovementGrid *grid;
+        btDiscreteDynamicsWorld *staticWorld;
+        SampledColumns *sampledColumns;
+        SDL_atomic_t *nextTile;
+        float fromHeight;
+        float toHeight;
+    };
+
+    /**
+     * Walk from sampled columns doesn't check clearance, nodes are checked in batches by worker threads after it.
+     */
+    static const uint32_t CLEARANCE_BATCH_SIZE = 256;
+
+    struct ClearanceWorkerParameters {
+        AIMovementGrid *grid;
+        btDiscreteDynamicsWorld *staticWorld;
+        SDL_atomic_t *nextBatch;
+        SDL_atomic_t *testCount;
+    };
 
-    const AIMovementNode *
-    aStarPath(const AIMovementNode *start, const glm::vec3 &destination, std::vector<glm::vec3> *route);
+    /**
+     * @param sampledColumns if set, neighbour heights are found from sampled columns instead of ray tests, and
+     * clearance of nodes other than root is not checked
+     */
+    uint32_t
+    walkMonster(glm::vec3 walkPoint, btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min, const glm::vec3 &max,
+                const SampledColumns *sampledColumns = nullptr);
+
+    uint32_t aStarPath(uint32_t start, const glm::vec3 &destination, std::vector<glm::vec3> *route);
+
+    void sampleTile(Tile &tile, btDiscreteDynamicsWorld *staticWorld, float fromHeight, float toHeight) const;
+
+    static int staticTileWorker(void *workerParameters);
+
+    static int staticClearanceWorker(void *workerParameters);
+
+    /**
+     * Runs worker on threadCount threads, calling thread is one of them. Returns after all of them finish.
+     */
+    static void runWorkers(int (*worker)(void *), void *workerParameters, size_t threadCount);
+
+    /**
+     * Same as setProperHeight, but finds the surface from sampled columns.
+     */
+    bool setSampledHeight(glm::vec3 *position, float floatingHeight, float checkHeight,
+                          const SampledColumns &sampledColumns) const;
+
+    uint32_t generateParallel(glm::vec3 walkPoint, btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min,
+                              const glm::vec3 &max, uint32_t threadCount);
+
+    AIMovementGrid() = default;//used by cache loading
 
-    std::vector<const AIMovementNode *> calculatedNodes;
 
 public:
     static constexpr float floatingHeight = 2.0f;
 
-    AIMovementGrid(glm::vec3 startPoint, btDiscreteDynamicsWorld *staticOnlyPhysicsWorld, glm::vec3 min, glm::vec3 max);
+    /**
+     * @param threadCount if bigger than 1, ray tests and clearance checks of generation run on that many threads.
+     * Requires Bullet built with BT_THREADSAFE, falls back to single threaded walk otherwise.
+     */
+    AIMovementGrid(glm::vec3 startPoint, btDiscreteDynamicsWorld *staticOnlyPhysicsWorld, glm::vec3 min, glm::vec3 max,
+                   uint32_t threadCount = 1);
 
     ~AIMovementGrid() {
+        delete clusterGraph;
         delete rayCallback;
         delete sharedGhostObject;
         delete ghostShape;
-        for (unsigned int i = 0; i < visited.size(); ++i) {
-            delete visited[i];
+    }
+
+    /**
+     * Loads the grid from a cache file written by serializeToCache. If file doesn't exist, or it was written for
+     * different static geometry, returns nullptr so grid can be generated.
+     */
+    static AIMovementGrid *loadFromCache(const std::string &cacheFileName, uint64_t geometryHash);
+
+    bool serializeToCache(const std::string &cacheFileName, uint64_t geometryHash) const;
+
+    uint32_t getNodeCount() const {
+        return nodeCount;
+    }
+
+    const AIMovementNode &getNode(uint32_t nodeIndex) const {
+        return nodes[nodeIndex];
+    }
+
+    uint32_t getRootIndex() const {
+        return rootIndex;
+    }
+
+    bool isNodeWalkable(uint32_t nodeIndex) const {
+        return nodes[nodeIndex].isIsMovable() && blockedNodes[nodeIndex] == 0;
+    }
+
+    /**
+     * Nodes that have a link to nodeIndex are in [begin, end).
+     */
+    const uint32_t *getReverseLinksBegin(uint32_t nodeIndex) const {
+        return reverseLinks.data() + reverseLinkOffsets[nodeIndex];
+    }
+
+    const uint32_t *getReverseLinksEnd(uint32_t nodeIndex) const {
+        return reverseLinks.data() + reverseLinkOffsets[nodeIndex + 1];
+    }
+
+    /**
+     * Blocks or unblocks nodes in the AABB, for dynamic obstacles. Blocks are counted, so overlapping obstacles
+     * work as long as each unblock uses the same AABB as its block. Nodes are found by the lattice index, so cost
+     * depends on the AABB size, not the grid size. Only affected clusters of the hierarchical graph are rebuilt.
+     */
+    void setAreaBlocked(const glm::vec3 &min, const glm::vec3 &max, bool isBlocked);
+
+    /**
+     * Routes calculated with a different generation might pass through blocked nodes.
+     */
+    uint32_t getBlockingGeneration() const {
+        return blockingGeneration;
+    }
+
+    /**
+     * Recalculates the flow field if goal is changed. Cost is independent from how many actors use the field.
+     */
+    void updateFlowField(uint32_t goalNode);
+
+    /**
+     * @return next node towards flow field goal, AIMovementNode::NO_NEIGHBOUR if node is the goal or can't reach it
+     */
+    uint32_t getFlowNextNode(uint32_t nodeIndex) const {
+        if (nodeIndex >= flowNextNodes.size()) {
+            return AIMovementNode::NO_NEIGHBOUR;
         }
+        return flowNextNodes[nodeIndex];
+    }
+
+    uint32_t getFlowFieldGoal() const {
+        return flowFieldGoal;
+    }
 
+    const PathSearchStats &getPathSearchStats() const {
+        return pathSearchStats;
     }
 
+    void printPathSearchStats() const;
+
+    /**
+     * Finds the node at position by walking greedily from hint node, falls back to lattice index if walk gets stuck.
+     * If hint is not a valid node, root is used.
+     *
+     * @return node index, or AIMovementNode::NO_NEIGHBOUR if position is not on grid
+     */
+    uint32_t findNode(const glm::vec3 &position, uint32_t hintNode);
+
+    /**
+     * If start and goal are in different clusters, path is searched on the cluster graph first, and only the part
+     * until first entrance is refined on the grid. Rest of the route is entrance positions.
+     *
+     * Route is reversed, last element is the first step. It is empty if start and goal are same.
+     */
+    bool findPath(uint32_t startNode, uint32_t goalNode, std::vector<glm::vec3> *route);
+
     bool coursePath(const glm::vec3 &from, const glm::vec3 &to, int actorId, std::vector<glm::vec3> *route);
 
     bool coursePath(const glm::vec3 &from, const glm::vec3 &to, std::vector<glm::vec3> *route);
@@ -7,7 +7,12 @@
 
 
 #include <glm/vec3.hpp>
+#include <cstdint>
 
+/**
+ * Nodes are kept in a contiguous array, and neighbours are indices to that array. This way the grid
+ * can be written to disk and used directly from a memory mapped file.
+ */
 class AIMovementNode {
     glm::vec3 position;
 
@@ -20,32 +25,37 @@ class AIMovementNode {
      *     -x   , na   ,    +x
      *     -x +z,    +z, +z +x
      */
-    AIMovementNode *neighbours[9] = {0};
+    uint32_t neighbours[9];
 
-    bool isMovable = false;
+    uint32_t isMovable = 0;//not bool, so layout has no padding on disk
 
 public:
+    static const uint32_t NO_NEIGHBOUR = 0xFFFFFFFF;
 
-    explicit AIMovementNode(glm::vec3 position) : position(position) {}
+    explicit AIMovementNode(glm::vec3 position) : position(position) {
+        for (int i = 0; i < 9; ++i) {
+            neighbours[i] = NO_NEIGHBOUR;
+        }
+    }
 
     void setIsMovable(bool isMovable) {
-        AIMovementNode::isMovable = isMovable;
+        AIMovementNode::isMovable = isMovable ? 1 : 0;
     }
 
-    void setNeighbour(int index, AIMovementNode *neighbour) {
-        neighbours[index] = neighbour;
+    void setNeighbour(int index, uint32_t neighbourIndex) {
+        neighbours[index] = neighbourIndex;
     }
 
     const glm::vec3 &getPosition() const {
         return position;
     }
 
-    AIMovementNode *getNeighbour(int i) const {
-        return (neighbours[i]);
+    uint32_t getNeighbour(int i) const {
+        return neighbours[i];
     }
 
     bool isIsMovable() const {
-        return isMovable;
+        return isMovable != 0;
     }
 };
 
@@ -0,0 +1,636 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "AINavMesh.h"
+#include "AIMovementGrid.h"
+
+#include "../Utils/GLMConverter.h"
+#include "../Utils/MemoryMappedFile.h"
+#include "../Utils/BinaryStream.h"
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <cmath>
+#include <functional>
+#include <SDL_timer.h>
+
+constexpr float AINavMesh::cellSize;
+constexpr float AINavMesh::maxStepHeight;
+constexpr float AINavMesh::maxPolygonHeightRange;
+const uint32_t AINavMesh::NO_POLYGON;
+const uint32_t AINavMesh::CACHE_MAGIC;
+const uint32_t AINavMesh::CACHE_VERSION;
+
+/**
+ * Same check with AIMovementGrid, any penetration means the span is blocked.
+ */
+struct NavMeshClearanceCallback : public btCollisionWorld::ContactResultCallback {
+    bool hasPenetration = false;
+
+    btScalar addSingleResult(btManifoldPoint &cp, const btCollisionObjectWrapper *colObj0Wrap, int partId0,
+                             int index0, const btCollisionObjectWrapper *colObj1Wrap, int partId1,
+                             int index1) override {
+        if (cp.getDistance() < 0.f) {
+            hasPenetration = true;
+        }
+        return 0;
+    }
+};
+
+/**
+ * Twice the signed area of triangle on x-z plane, used by funnel.
+ */
+static float triangleArea2(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+    float abx = b.x - a.x;
+    float abz = b.z - a.z;
+    float acx = c.x - a.x;
+    float acz = c.z - a.z;
+    return acx * abz - abx * acz;
+}
+
+static bool isSamePoint(const glm::vec3 &a, const glm::vec3 &b) {
+    return glm::length(a - b) < 0.001f;
+}
+
+AINavMesh::AINavMesh(btDiscreteDynamicsWorld *staticOnlyPhysicsWorld, const glm::vec3 &min, const glm::vec3 &max) {
+    std::cout << "Start generating AI navigation mesh" << std::endl;
+    long start = SDL_GetTicks();
+    voxelize(staticOnlyPhysicsWorld, min, max);
+    buildPolygons();
+    buildPortals();
+    long end = SDL_GetTicks();
+    std::cout << "Finished generating AI navigation mesh in " << end - start << "ms, created " << polygons.size()
+              << " polygons using " << getMemoryUsage() << " bytes." << std::endl;
+}
+
+AINavMesh::~AINavMesh() {
+    if (queryCount > 0) {
+        std::cout << "AI navigation mesh: " << queryCount << " queries, " << queryMicroseconds / queryCount
+                  << " us per query on average." << std::endl;
+    }
+}
+
+AINavMesh *AINavMesh::loadFromCache(const std::string &cacheFileName, uint64_t geometryHash) {
+    MemoryMappedFile cacheFile;
+    if (!cacheFile.open(cacheFileName)) {
+        return nullptr;
+    }
+    //columns and polygons are variable sized, so unlike the grid they are copied out of the mapping
+    BinaryReader reader(cacheFile.getData(), cacheFile.getSize());
+    CacheFileHeader header = reader.read<CacheFileHeader>();
+    if (reader.isFailed()) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " is truncated, it will be regenerated." << std::endl;
+        return nullptr;
+    }
+    if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " has unknown format, it will be regenerated." << std::endl;
+        return nullptr;
+    }
+    if (header.geometryHash != geometryHash) {
+        std::cout << "AI navigation mesh cache " << cacheFileName << " is stale, it will be regenerated." << std::endl;
+        return nullptr;
+    }
+    //sizes are checked before allocating anything, so a corrupted header can't cause huge allocations
+    if (header.width < 0 || header.depth < 0 ||
+        cacheFile.getSize() != sizeof(CacheFileHeader) + (uint64_t) header.width * header.depth * sizeof(uint32_t) +
+                               header.spanCount * sizeof(Span) + header.polygonCount * sizeof(CachedPolygon) +
+                               header.portalCount * sizeof(Portal)) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " is corrupted, it will be regenerated." << std::endl;
+        return nullptr;
+    }
+
+    AINavMesh *navMesh = new AINavMesh();
+    navMesh->origin = glm::vec3(header.originX, 0, header.originZ);
+    navMesh->width = header.width;
+    navMesh->depth = header.depth;
+    std::vector<uint32_t> spanCounts((size_t) navMesh->width * navMesh->depth);
+    reader.readBytes(spanCounts.data(), spanCounts.size() * sizeof(uint32_t));
+    navMesh->columns.resize(spanCounts.size());
+    uint64_t spanTotal = 0;
+    for (size_t i = 0; i < spanCounts.size() && !reader.isFailed(); ++i) {
+        spanTotal += spanCounts[i];
+        if (spanTotal > header.spanCount) {
+            break;
+        }
+        navMesh->columns[i].resize(spanCounts[i]);
+        reader.readBytes(navMesh->columns[i].data(), spanCounts[i] * sizeof(Span));
+    }
+    uint64_t portalTotal = 0;
+    if (spanTotal == header.spanCount) {
+        navMesh->polygons.resize(header.polygonCount);
+        for (size_t i = 0; i < navMesh->polygons.size() && !reader.isFailed(); ++i) {
+            CachedPolygon cachedPolygon = reader.read<CachedPolygon>();
+            portalTotal += cachedPolygon.portalCount;
+            if (reader.isFailed() || portalTotal > header.portalCount) {
+                break;
+            }
+            NavPolygon &polygon = navMesh->polygons[i];
+            polygon.min = cachedPolygon.min;
+            polygon.max = cachedPolygon.max;
+            polygon.height = cachedPolygon.height;
+            polygon.portals.resize(cachedPolygon.portalCount);
+            reader.readBytes(polygon.portals.data(), cachedPolygon.portalCount * sizeof(Portal));
+        }
+    }
+    //every polygon index read from the file must be valid, search doesn't check them
+    bool isValid = !reader.isFailed() && spanTotal == header.spanCount && portalTotal == header.portalCount;
+    for (size_t i = 0; isValid && i < navMesh->columns.size(); ++i) {
+        for (size_t j = 0; j < navMesh->columns[i].size(); ++j) {
+            if (navMesh->columns[i][j].polygon >= navMesh->polygons.size()) {
+                isValid = false;
+            }
+        }
+    }
+    for (size_t i = 0; isValid && i < navMesh->polygons.size(); ++i) {
+        for (size_t j = 0; j < navMesh->polygons[i].portals.size(); ++j) {
+            if (navMesh->polygons[i].portals[j].neighbour >= navMesh->polygons.size()) {
+                isValid = false;
+            }
+        }
+    }
+    if (!isValid) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " is corrupted, it will be regenerated." << std::endl;
+        delete navMesh;
+        return nullptr;
+    }
+    std::cout << "Loaded AI navigation mesh from " << cacheFileName << " with " << navMesh->polygons.size()
+              << " polygons." << std::endl;
+    return navMesh;
+}
+
+bool AINavMesh::serializeToCache(const std::string &cacheFileName, uint64_t geometryHash) const {
+    std::ofstream cacheStream(cacheFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!cacheStream.is_open()) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " can't be opened for writing." << std::endl;
+        return false;
+    }
+    CacheFileHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.width = width;
+    header.depth = depth;
+    header.geometryHash = geometryHash;
+    header.originX = origin.x;
+    header.originZ = origin.z;
+    header.spanCount = 0;
+    header.polygonCount = polygons.size();
+    header.portalCount = 0;
+    std::vector<uint32_t> spanCounts(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        spanCounts[i] = (uint32_t) columns[i].size();
+        header.spanCount += columns[i].size();
+    }
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        header.portalCount += polygons[i].portals.size();
+    }
+    cacheStream.write(reinterpret_cast<const char *>(&header), sizeof(CacheFileHeader));
+    cacheStream.write(reinterpret_cast<const char *>(spanCounts.data()), spanCounts.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < columns.size(); ++i) {
+        cacheStream.write(reinterpret_cast<const char *>(columns[i].data()), columns[i].size() * sizeof(Span));
+    }
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        CachedPolygon cachedPolygon;
+        cachedPolygon.min = polygons[i].min;
+        cachedPolygon.max = polygons[i].max;
+        cachedPolygon.height = polygons[i].height;
+        cachedPolygon.portalCount = (uint32_t) polygons[i].portals.size();
+        cacheStream.write(reinterpret_cast<const char *>(&cachedPolygon), sizeof(CachedPolygon));
+        cacheStream.write(reinterpret_cast<const char *>(polygons[i].portals.data()),
+                          polygons[i].portals.size() * sizeof(Portal));
+    }
+    cacheStream.close();
+    if (cacheStream.fail()) {
+        std::cerr << "AI navigation mesh cache " << cacheFileName << " write failed." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AINavMesh::voxelize(btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min, const glm::vec3 &max) {
+    origin = glm::vec3(min.x, 0, min.z);
+    width = std::max(0, (int32_t) std::ceil((max.x - min.x) / cellSize));
+    depth = std::max(0, (int32_t) std::ceil((max.z - min.z) / cellSize));
+    columns.assign((size_t) width * depth, std::vector<Span>());
+
+    btCapsuleShape clearanceShape(capsuleRadius, capsuleHeight);
+    btCollisionObject clearanceObject;
+    clearanceObject.setCollisionShape(&clearanceShape);
+
+    std::vector<float> floorHeights;
+    for (int32_t z = 0; z < depth; ++z) {
+        for (int32_t x = 0; x < width; ++x) {
+            float centerX = origin.x + (x + 0.5f) * cellSize;
+            float centerZ = origin.z + (z + 0.5f) * cellSize;
+            btVector3 from(centerX, max.y, centerZ);
+            btVector3 to(centerX, min.y - AIMovementGrid::floatingHeight, centerZ);
+            btCollisionWorld::AllHitsRayResultCallback rayResults(from, to);
+            staticWorld->rayTest(from, to, rayResults);
+
+            floorHeights.clear();
+            for (int k = 0; k < rayResults.m_hitPointWorld.size(); ++k) {
+                if (rayResults.m_hitNormalWorld[k].getY() < 0.7f) {
+                    continue;//walls, ceilings and slopes steeper than ~45 degrees
+                }
+                floorHeights.push_back(rayResults.m_hitPointWorld[k].getY());
+            }
+            std::sort(floorHeights.begin(), floorHeights.end(), std::greater<float>());
+
+            std::vector<Span> &column = getColumn(x, z);
+            for (size_t k = 0; k < floorHeights.size(); ++k) {
+                if (!column.empty() && column.back().floorHeight - floorHeights[k] < 0.1f) {
+                    continue;//same floor reported by multiple shapes
+                }
+                glm::vec3 position(centerX, floorHeights[k] + AIMovementGrid::floatingHeight, centerZ);
+                clearanceObject.setWorldTransform(
+                        btTransform(btQuaternion::getIdentity(), GLMConverter::GLMToBlt(position)));
+                NavMeshClearanceCallback clearanceResult;
+                clearanceResult.m_collisionFilterGroup = btBroadphaseProxy::SensorTrigger;
+                clearanceResult.m_collisionFilterMask = btBroadphaseProxy::AllFilter & ~btBroadphaseProxy::SensorTrigger;
+                staticWorld->contactTest(&clearanceObject, clearanceResult);
+                if (clearanceResult.hasPenetration) {
+                    continue;
+                }
+                Span span;
+                span.floorHeight = floorHeights[k];
+                span.polygon = NO_POLYGON;
+                column.push_back(span);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the unassigned span that can be stepped on from height, -1 if there is none.
+ */
+int32_t AINavMesh::findConnectedSpan(int32_t x, int32_t z, float height) const {
+    const std::vector<Span> &column = getColumn(x, z);
+    int32_t found = -1;
+    float foundDifference = maxStepHeight;
+    for (size_t i = 0; i < column.size(); ++i) {
+        float difference = std::fabs(column[i].floorHeight - height);
+        if (column[i].polygon == NO_POLYGON && difference <= foundDifference) {
+            found = (int32_t) i;
+            foundDifference = difference;
+        }
+    }
+    return found;
+}
+
+void AINavMesh::buildPolygons() {
+    std::vector<std::vector<int32_t>> rows;
+    for (int32_t z = 0; z < depth; ++z) {
+        for (int32_t x = 0; x < width; ++x) {
+            for (size_t spanIndex = 0; spanIndex < getColumn(x, z).size(); ++spanIndex) {
+                if (getColumn(x, z)[spanIndex].polygon != NO_POLYGON) {
+                    continue;
+                }
+                float minHeight = getColumn(x, z)[spanIndex].floorHeight;
+                float maxHeight = minHeight;
+                rows.clear();
+                rows.push_back(std::vector<int32_t>(1, (int32_t) spanIndex));
+
+                //grow on x as much as possible
+                int32_t endX = x;
+                while (endX + 1 < width) {
+                    float previousHeight = getColumn(endX, z)[rows[0].back()].floorHeight;
+                    int32_t connected = findConnectedSpan(endX + 1, z, previousHeight);
+                    if (connected < 0) {
+                        break;
+                    }
+                    float height = getColumn(endX + 1, z)[connected].floorHeight;
+                    if (std::max(maxHeight, height) - std::min(minHeight, height) > maxPolygonHeightRange) {
+                        break;
+                    }
+                    minHeight = std::min(minHeight, height);
+                    maxHeight = std::max(maxHeight, height);
+                    rows[0].push_back(connected);
+                    endX++;
+                }
+
+                //then grow on z, a row is added only if all of it is connected
+                for (int32_t rowZ = z + 1; rowZ < depth; ++rowZ) {
+                    std::vector<int32_t> newRow;
+                    float rowMinHeight = minHeight;
+                    float rowMaxHeight = maxHeight;
+                    for (int32_t rowX = x; rowX <= endX; ++rowX) {
+                        float previousHeight = getColumn(rowX, rowZ - 1)[rows.back()[rowX - x]].floorHeight;
+                        int32_t connected = findConnectedSpan(rowX, rowZ, previousHeight);
+                        if (connected < 0) {
+                            break;
+                        }
+                        float height = getColumn(rowX, rowZ)[connected].floorHeight;
+                        if (rowX > x &&
+                            std::fabs(height - getColumn(rowX - 1, rowZ)[newRow.back()].floorHeight) > maxStepHeight) {
+                            break;
+                        }
+                        if (std::max(rowMaxHeight, height) - std::min(rowMinHeight, height) > maxPolygonHeightRange) {
+                            break;
+                        }
+                        rowMinHeight = std::min(rowMinHeight, height);
+                        rowMaxHeight = std::max(rowMaxHeight, height);
+                        newRow.push_back(connected);
+                    }
+                    if (newRow.size() != rows[0].size()) {
+                        break;
+                    }
+                    minHeight = rowMinHeight;
+                    maxHeight = rowMaxHeight;
+                    rows.push_back(newRow);
+                }
+
+                uint32_t polygonIndex = (uint32_t) polygons.size();
+                NavPolygon polygon;
+                polygon.min = glm::vec2(origin.x + x * cellSize, origin.z + z * cellSize);
+                polygon.max = glm::vec2(origin.x + (endX + 1) * cellSize, origin.z + (z + rows.size()) * cellSize);
+                float heightSum = 0;
+                for (size_t rowIndex = 0; rowIndex < rows.size(); ++rowIndex) {
+                    for (size_t i = 0; i < rows[rowIndex].size(); ++i) {
+                        Span &span = getColumn(x + (int32_t) i, z + (int32_t) rowIndex)[rows[rowIndex][i]];
+                        span.polygon = polygonIndex;
+                        heightSum += span.floorHeight;
+                    }
+                }
+                polygon.height = heightSum / (rows.size() * rows[0].size());
+                polygons.push_back(polygon);
+            }
+        }
+    }
+}
+
+void AINavMesh::addPortalEdge(std::map<std::pair<uint32_t, uint32_t>, std::vector<PortalEdge>> &edges,
+                              uint32_t first, uint32_t second, const glm::vec3 &start, const glm::vec3 &end) {
+    std::vector<PortalEdge> &pairEdges = edges[std::make_pair(std::min(first, second), std::max(first, second))];
+    //cell edges are added in increasing coordinate order, so a contiguous one continues an edge from its end
+    for (size_t i = 0; i < pairEdges.size(); ++i) {
+        if (std::fabs(pairEdges[i].end.x - start.x) < 0.001f && std::fabs(pairEdges[i].end.z - start.z) < 0.001f) {
+            pairEdges[i].end = end;
+            return;
+        }
+    }
+    PortalEdge edge;
+    edge.start = start;
+    edge.end = end;
+    pairEdges.push_back(edge);
+}
+
+void AINavMesh::buildPortals() {
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<PortalEdge>> edges;
+    for (int32_t z = 0; z < depth; ++z) {
+        for (int32_t x = 0; x < width; ++x) {
+            const std::vector<Span> &column = getColumn(x, z);
+            for (size_t i = 0; i < column.size(); ++i) {
+                uint32_t polygon = column[i].polygon;
+                if (x + 1 < width) {
+                    const std::vector<Span> &neighbourColumn = getColumn(x + 1, z);
+                    for (size_t j = 0; j < neighbourColumn.size(); ++j) {
+                        if (neighbourColumn[j].polygon == polygon ||
+                            std::fabs(neighbourColumn[j].floorHeight - column[i].floorHeight) > maxStepHeight) {
+                            continue;
+                        }
+                        float edgeX = origin.x + (x + 1) * cellSize;
+                        float height = (column[i].floorHeight + neighbourColumn[j].floorHeight) / 2.0f;
+                        addPortalEdge(edges, polygon, neighbourColumn[j].polygon,
+                                      glm::vec3(edgeX, height, origin.z + z * cellSize),
+                                      glm::vec3(edgeX, height, origin.z + (z + 1) * cellSize));
+                    }
+                }
+                if (z + 1 < depth) {
+                    const std::vector<Span> &neighbourColumn = getColumn(x, z + 1);
+                    for (size_t j = 0; j < neighbourColumn.size(); ++j) {
+                        if (neighbourColumn[j].polygon == polygon ||
+                            std::fabs(neighbourColumn[j].floorHeight - column[i].floorHeight) > maxStepHeight) {
+                            continue;
+                        }
+                        float edgeZ = origin.z + (z + 1) * cellSize;
+                        float height = (column[i].floorHeight + neighbourColumn[j].floorHeight) / 2.0f;
+                        addPortalEdge(edges, polygon, neighbourColumn[j].polygon,
+                                      glm::vec3(origin.x + x * cellSize, height, edgeZ),
+                                      glm::vec3(origin.x + (x + 1) * cellSize, height, edgeZ));
+                    }
+                }
+            }
+        }
+    }
+    for (auto it = edges.begin(); it != edges.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            Portal portal;
+            portal.start = it->second[i].start;
+            portal.end = it->second[i].end;
+            portal.neighbour = it->first.second;
+            polygons[it->first.first].portals.push_back(portal);
+            portal.neighbour = it->first.first;
+            polygons[it->first.second].portals.push_back(portal);
+        }
+    }
+}
+
+uint32_t AINavMesh::findPolygon(const glm::vec3 &floorPosition) const {
+    int32_t x = (int32_t) std::floor((floorPosition.x - origin.x) / cellSize);
+    int32_t z = (int32_t) std::floor((floorPosition.z - origin.z) / cellSize);
+    if (x < 0 || z < 0 || x >= width || z >= depth) {
+        return NO_POLYGON;
+    }
+    //closest floor under the position
+    const std::vector<Span> &column = getColumn(x, z);
+    for (size_t i = 0; i < column.size(); ++i) {
+        if (column[i].floorHeight <= floorPosition.y + maxStepHeight) {
+            return column[i].polygon;
+        }
+    }
+    return NO_POLYGON;
+}
+
+bool AINavMesh::searchPolygons(uint32_t startPolygon, uint32_t goalPolygon, const glm::vec3 &goal,
+                               std::vector<uint32_t> &polygonPath, std::vector<uint32_t> &portalPath) {
+    if (searchStamps.size() != polygons.size()) {
+        searchStamps.assign(polygons.size(), 0);
+        closedStamps.assign(polygons.size(), 0);
+        searchCosts.resize(polygons.size());
+        searchParents.resize(polygons.size());
+        searchParentPortals.resize(polygons.size());
+        searchGeneration = 0;
+    }
+    searchGeneration++;
+    if (searchGeneration == 0) {
+        std::fill(searchStamps.begin(), searchStamps.end(), 0);
+        std::fill(closedStamps.begin(), closedStamps.end(), 0);
+        searchGeneration = 1;
+    }
+
+    typedef std::pair<float, uint32_t> PriorityPolygon;
+    std::priority_queue<PriorityPolygon, std::vector<PriorityPolygon>, std::greater<PriorityPolygon>> frontier;
+    searchStamps[startPolygon] = searchGeneration;
+    searchCosts[startPolygon] = 0;
+    searchParents[startPolygon] = NO_POLYGON;
+    frontier.push(std::make_pair(0.0f, startPolygon));
+    bool isFound = false;
+    while (!frontier.empty()) {
+        PriorityPolygon current = frontier.top();
+        frontier.pop();
+        if (closedStamps[current.second] == searchGeneration) {
+            continue;//stale entry, polygon is pushed again with a lower cost and expanded already
+        }
+        closedStamps[current.second] = searchGeneration;
+        if (current.second == goalPolygon) {
+            isFound = true;
+            break;
+        }
+        const NavPolygon &polygon = polygons[current.second];
+        glm::vec3 center = polygon.getCenter();
+        for (size_t i = 0; i < polygon.portals.size(); ++i) {
+            uint32_t neighbour = polygon.portals[i].neighbour;
+            if (closedStamps[neighbour] == searchGeneration) {
+                continue;//straight line heuristic is consistent, closed polygons can't get cheaper
+            }
+            //going through portal middle is closer to real cost than center to center
+            glm::vec3 portalMiddle = (polygon.portals[i].start + polygon.portals[i].end) / 2.0f;
+            float cost = searchCosts[current.second] + glm::length(portalMiddle - center) +
+                         glm::length(polygons[neighbour].getCenter() - portalMiddle);
+            if (searchStamps[neighbour] == searchGeneration && cost >= searchCosts[neighbour]) {
+                continue;
+            }
+            searchStamps[neighbour] = searchGeneration;
+            searchCosts[neighbour] = cost;
+            searchParents[neighbour] = current.second;
+            searchParentPortals[neighbour] = (uint32_t) i;
+            frontier.push(std::make_pair(cost + glm::length(goal - polygons[neighbour].getCenter()), neighbour));
+        }
+    }
+    if (!isFound) {
+        return false;
+    }
+    polygonPath.clear();
+    portalPath.clear();
+    for (uint32_t polygon = goalPolygon; polygon != NO_POLYGON; polygon = searchParents[polygon]) {
+        polygonPath.push_back(polygon);
+        if (searchParents[polygon] != NO_POLYGON) {
+            portalPath.push_back(searchParentPortals[polygon]);
+        }
+    }
+    std::reverse(polygonPath.begin(), polygonPath.end());
+    std::reverse(portalPath.begin(), portalPath.end());
+    return true;
+}
+
+/**
+ * Simple stupid funnel algorithm on x-z plane.
+ */
+void AINavMesh::funnel(const glm::vec3 &start, const glm::vec3 &goal, const std::vector<uint32_t> &polygonPath,
+                       const std::vector<uint32_t> &portalPath, std::vector<glm::vec3> &points) const {
+    std::vector<glm::vec3> lefts, rights;
+    lefts.push_back(start);
+    rights.push_back(start);
+    for (size_t i = 0; i + 1 < polygonPath.size(); ++i) {
+        const NavPolygon &polygon = polygons[polygonPath[i]];
+        //polygons might share more than one portal, so the one search used is taken
+        const Portal &portal = polygon.portals[portalPath[i]];
+        glm::vec3 direction = polygons[polygonPath[i + 1]].getCenter() - polygon.getCenter();
+        glm::vec3 toStart = portal.start - (portal.start + portal.end) / 2.0f;
+        if (direction.x * toStart.z - direction.z * toStart.x > 0) {
+            lefts.push_back(portal.start);
+            rights.push_back(portal.end);
+        } else {
+            lefts.push_back(portal.end);
+            rights.push_back(portal.start);
+        }
+    }
+    lefts.push_back(goal);
+    rights.push_back(goal);
+
+    points.clear();
+    points.push_back(start);
+    glm::vec3 apex = start, left = start, right = start;
+    size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+    for (size_t i = 1; i < lefts.size(); ++i) {
+        //tighten right side
+        if (triangleArea2(apex, right, rights[i]) <= 0.0f) {
+            if (isSamePoint(apex, right) || triangleArea2(apex, left, rights[i]) > 0.0f) {
+                right = rights[i];
+                rightIndex = i;
+            } else {
+                //right crossed left, left is a corner
+                points.push_back(left);
+                apex = left;
+                apexIndex = leftIndex;
+                right = apex;
+                rightIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+        //tighten left side
+        if (triangleArea2(apex, left, lefts[i]) >= 0.0f) {
+            if (isSamePoint(apex, left) || triangleArea2(apex, right, lefts[i]) < 0.0f) {
+                left = lefts[i];
+                leftIndex = i;
+            } else {
+                points.push_back(right);
+                apex = right;
+                apexIndex = rightIndex;
+                left = apex;
+                leftIndex = apexIndex;
+                i = apexIndex;
+                continue;
+            }
+        }
+    }
+    if (!isSamePoint(points.back(), goal)) {
+        points.push_back(goal);
+    }
+}
+
+bool AINavMesh::coursePath(const glm::vec3 &from, const glm::vec3 &to, int actorId, std::vector<glm::vec3> *route) {
+    Uint64 searchStartTime = SDL_GetPerformanceCounter();
+    glm::vec3 floatingOffset(0, AIMovementGrid::floatingHeight, 0);
+    glm::vec3 fromFloor = from - floatingOffset;
+    glm::vec3 toFloor = to - floatingOffset;
+
+    uint32_t startPolygon = findPolygon(fromFloor);
+    if (startPolygon == NO_POLYGON) {
+        //actors might be pushed off the mesh a little, use where it was last time
+        auto lastPolygon = actorLastPolygonMap.find(actorId);
+        if (lastPolygon == actorLastPolygonMap.end()) {
+            std::cerr << "Actor " << actorId << " is not on navigation mesh." << std::endl;
+            return false;
+        }
+        startPolygon = lastPolygon->second;
+    } else {
+        actorLastPolygonMap[actorId] = startPolygon;
+    }
+    uint32_t goalPolygon = findPolygon(toFloor);
+    if (goalPolygon == NO_POLYGON) {
+        return false;
+    }
+
+    std::vector<uint32_t> polygonPath;
+    std::vector<uint32_t> portalPath;
+    if (!searchPolygons(startPolygon, goalPolygon, toFloor, polygonPath, portalPath)) {
+        return false;
+    }
+    std::vector<glm::vec3> points;
+    funnel(fromFloor, toFloor, polygonPath, portalPath, points);
+
+    route->clear();
+    for (size_t i = points.size() - 1; i > 0; --i) {
+        route->push_back(points[i] + floatingOffset);
+    }
+
+    queryCount++;
+    queryMicroseconds += ((SDL_GetPerformanceCounter() - searchStartTime) * 1000000) / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+size_t AINavMesh::getMemoryUsage() const {
+    size_t usage = sizeof(AINavMesh);
+    usage += columns.capacity() * sizeof(std::vector<Span>);
+    for (size_t i = 0; i < columns.size(); ++i) {
+        usage += columns[i].capacity() * sizeof(Span);
+    }
+    usage += polygons.capacity() * sizeof(NavPolygon);
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        usage += polygons[i].portals.capacity() * sizeof(Portal);
+    }
+    return usage;
+}
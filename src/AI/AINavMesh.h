@@ -0,0 +1,173 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_AINAVMESH_H
+#define LIMONENGINE_AINAVMESH_H
+
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+
+/**
+ * Navigation mesh alternative to AIMovementGrid.
+ *
+ * Static world is voxelized into columns of cellSize, each column keeps the walkable floor spans found by a
+ * downward ray, clearance of each span is checked with the same capsule the grid uses. Connected spans with
+ * similar heights are merged into axis aligned rectangles, which are the convex polygons of the mesh.
+ * Polygons are connected by portals, path is searched over polygons and smoothed with funnel algorithm.
+ *
+ * Positions given and returned are floatingHeight above floor, same as the grid, so it can be used in place of
+ * AIMovementGrid::coursePath.
+ */
+class AINavMesh {
+public:
+    static constexpr float cellSize = 0.5f;
+    static constexpr float maxStepHeight = 0.5f;
+    static constexpr float maxPolygonHeightRange = 1.0f;
+
+private:
+    static const uint32_t NO_POLYGON = 0xFFFFFFFF;
+
+    struct Span {
+        float floorHeight;
+        uint32_t polygon;
+    };
+
+    struct Portal {
+        uint32_t neighbour;
+        glm::vec3 start;
+        glm::vec3 end;
+    };
+
+    struct NavPolygon {
+        glm::vec2 min;//x-z
+        glm::vec2 max;
+        float height;
+        std::vector<Portal> portals;
+
+        glm::vec3 getCenter() const {
+            return glm::vec3((min.x + max.x) / 2.0f, height, (min.y + max.y) / 2.0f);
+        }
+    };
+
+    /**
+     * Header of the cache file. Span counts of columns, spans, polygons and portals follow the header in order.
+     */
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        int32_t width;
+        int32_t depth;
+        uint64_t geometryHash;
+        float originX;
+        float originZ;
+        uint64_t spanCount;
+        uint64_t polygonCount;
+        uint64_t portalCount;
+    };
+
+    struct CachedPolygon {
+        glm::vec2 min;
+        glm::vec2 max;
+        float height;
+        uint32_t portalCount;
+    };
+
+    static const uint32_t CACHE_MAGIC = 0x56414E41;//"ANAV"
+    static const uint32_t CACHE_VERSION = 2;
+
+    /**
+     * Contiguous part of the boundary shared by two polygons. Boundary might have gaps where heights differ more
+     * than step height, so a polygon pair can have more than one.
+     */
+    struct PortalEdge {
+        glm::vec3 start;
+        glm::vec3 end;
+    };
+
+    glm::vec3 origin;
+    int32_t width = 0;
+    int32_t depth = 0;
+    std::vector<std::vector<Span>> columns;
+    std::vector<NavPolygon> polygons;
+    std::map<int, uint32_t> actorLastPolygonMap;
+
+    //search scratch, reused between queries
+    std::vector<float> searchCosts;
+    std::vector<uint32_t> searchParents;
+    std::vector<uint32_t> searchParentPortals;//portal of parent polygon used to reach the polygon
+    std::vector<uint32_t> searchStamps;
+    std::vector<uint32_t> closedStamps;
+    uint32_t searchGeneration = 0;
+
+    float capsuleHeight = 0.5f;
+    float capsuleRadius = 0.5f;//same with grid
+
+    uint64_t queryCount = 0;
+    uint64_t queryMicroseconds = 0;
+
+    std::vector<Span> &getColumn(int32_t x, int32_t z) {
+        return columns[z * width + x];
+    }
+
+    const std::vector<Span> &getColumn(int32_t x, int32_t z) const {
+        return columns[z * width + x];
+    }
+
+    AINavMesh() = default;
+
+    void voxelize(btDiscreteDynamicsWorld *staticWorld, const glm::vec3 &min, const glm::vec3 &max);
+
+    int32_t findConnectedSpan(int32_t x, int32_t z, float height) const;
+
+    void buildPolygons();
+
+    void addPortalEdge(std::map<std::pair<uint32_t, uint32_t>, std::vector<PortalEdge>> &edges, uint32_t first,
+                       uint32_t second, const glm::vec3 &start, const glm::vec3 &end);
+
+    void buildPortals();
+
+    uint32_t findPolygon(const glm::vec3 &floorPosition) const;
+
+    /**
+     * @param portalPath filled with the portal index of each path polygon, that leads to next polygon in path
+     */
+    bool searchPolygons(uint32_t startPolygon, uint32_t goalPolygon, const glm::vec3 &goal,
+                        std::vector<uint32_t> &polygonPath, std::vector<uint32_t> &portalPath);
+
+    void funnel(const glm::vec3 &start, const glm::vec3 &goal, const std::vector<uint32_t> &polygonPath,
+                const std::vector<uint32_t> &portalPath, std::vector<glm::vec3> &points) const;
+
+public:
+    AINavMesh(btDiscreteDynamicsWorld *staticOnlyPhysicsWorld, const glm::vec3 &min, const glm::vec3 &max);
+
+    ~AINavMesh();
+
+    /**
+     * Loads the navigation mesh from a cache file written by serializeToCache. If file doesn't exist, or it was
+     * written for different static geometry, returns nullptr so navigation mesh can be generated.
+     */
+    static AINavMesh *loadFromCache(const std::string &cacheFileName, uint64_t geometryHash);
+
+    bool serializeToCache(const std::string &cacheFileName, uint64_t geometryHash) const;
+
+    /**
+     * Same contract with AIMovementGrid::coursePath, route is reversed, last element is the first step.
+     */
+    bool coursePath(const glm::vec3 &from, const glm::vec3 &to, int actorId, std::vector<glm::vec3> *route);
+
+    size_t getPolygonCount() const {
+        return polygons.size();
+    }
+
+    size_t getMemoryUsage() const;
+};
+
+
+#endif //LIMONENGINE_AINAVMESH_H
@@ -23,6 +23,8 @@ class Actor {
 protected:
     uint32_t worldID;
     Model* model = nullptr;
+    glm::vec3 desiredMovement = glm::vec3(0, 0, 0);//set by play, applied after crowd avoidance
+    glm::vec3 lastMovement = glm::vec3(0, 0, 0);
 public:
 
     Actor(uint32_t id): worldID(id) {}
@@ -42,6 +44,10 @@ public:
         return model;
     }
 
+    const btCollisionObject* getCollisionObject() const {
+        return model->getRigidBody();
+    }
+
     glm::vec3 getPosition(){
         return GLMConverter::BltToGLM(this->model->getRigidBody()->getCenterOfMassPosition());
     }
@@ -62,6 +68,25 @@ public:
         return vprime;
     }
 
+    const glm::vec3 &getDesiredMovement() const {
+        return desiredMovement;
+    }
+
+    const glm::vec3 &getLastMovement() const {
+        return lastMovement;
+    }
+
+    /**
+     * Moves the actor, movement is the desired movement adjusted to avoid other actors.
+     */
+    void applyMovement(const glm::vec3 &movement) {
+        if(movement != glm::vec3(0, 0, 0)) {
+            model->getTransformation()->addTranslate(movement);
+        }
+        lastMovement = movement;
+        desiredMovement = glm::vec3(0, 0, 0);
+    }
+
     virtual void IMGuiEditorView() {};
 
     virtual ~Actor() {};
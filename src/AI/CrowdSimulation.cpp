@@ -0,0 +1,249 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "CrowdSimulation.h"
+#include "../Utils/WorkerPool.h"
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <SDL_timer.h>
+
+const uint32_t CrowdSimulation::CANDIDATE_DIRECTION_COUNT;
+const uint32_t CrowdSimulation::MAX_NEIGHBOURS;
+
+CrowdSimulation::CrowdSimulation(uint32_t threadCount) : threadCount(threadCount) {
+    if (this->threadCount == 0) {
+        this->threadCount = 1;
+    }
+    if (this->threadCount > 1) {
+        workerPool = new WorkerPool(this->threadCount, "crowdWorker");
+        this->threadCount = workerPool->getThreadCount();
+    }
+}
+
+CrowdSimulation::~CrowdSimulation() {
+    delete workerPool;
+    if (stepCount > 0) {
+        std::cout << "Crowd simulation: " << stepCount << " steps, " << stepMicroseconds / stepCount
+                  << " us per step on average, at most " << maximumAgentCount << " agents." << std::endl;
+    }
+}
+
+uint32_t CrowdSimulation::addAgent(const glm::vec3 &position, const glm::vec3 &velocity,
+                                   const glm::vec3 &preferredVelocity, float radius) {
+    Agent agent;
+    agent.position = position;
+    agent.velocity = velocity;
+    agent.preferredVelocity = preferredVelocity;
+    agent.radius = radius;
+    agent.newVelocity = preferredVelocity;
+    agents.push_back(agent);
+    return agents.size() - 1;
+}
+
+uint32_t CrowdSimulation::getBucket(int32_t cellX, int32_t cellZ) const {
+    return (((uint32_t) cellX * 73856093u) ^ ((uint32_t) cellZ * 19349663u)) & bucketMask;
+}
+
+void CrowdSimulation::buildSpatialHash() {
+    uint32_t bucketCount = 16;
+    while (bucketCount < agents.size() * 2) {
+        bucketCount *= 2;
+    }
+    bucketMask = bucketCount - 1;
+    bucketStarts.assign(bucketCount + 1, 0);
+    agentBuckets.resize(agents.size());
+    sortedAgents.resize(agents.size());
+
+    //counting sort by bucket
+    for (size_t i = 0; i < agents.size(); ++i) {
+        agentBuckets[i] = getBucket((int32_t) std::floor(agents[i].position.x / neighbourDistance),
+                                    (int32_t) std::floor(agents[i].position.z / neighbourDistance));
+        bucketStarts[agentBuckets[i] + 1]++;
+    }
+    for (uint32_t i = 1; i <= bucketCount; ++i) {
+        bucketStarts[i] += bucketStarts[i - 1];
+    }
+    for (size_t i = 0; i < agents.size(); ++i) {
+        sortedAgents[bucketStarts[agentBuckets[i]]++] = (uint32_t) i;
+    }
+    //filling moved each start to next buckets start, shift them back
+    for (uint32_t i = bucketCount; i > 0; --i) {
+        bucketStarts[i] = bucketStarts[i - 1];
+    }
+    bucketStarts[0] = 0;
+}
+
+/**
+ * Fills the closest MAX_NEIGHBOURS agents, sorted by distance.
+ */
+uint32_t CrowdSimulation::findNeighbours(uint32_t agentIndex, uint32_t *neighbours) const {
+    const Agent &agent = agents[agentIndex];
+    int32_t cellX = (int32_t) std::floor(agent.position.x / neighbourDistance);
+    int32_t cellZ = (int32_t) std::floor(agent.position.z / neighbourDistance);
+    float distances[MAX_NEIGHBOURS];
+    uint32_t neighbourCount = 0;
+    uint32_t visitedBuckets[9];
+    uint32_t visitedCount = 0;
+    for (int32_t z = cellZ - 1; z <= cellZ + 1; ++z) {
+        for (int32_t x = cellX - 1; x <= cellX + 1; ++x) {
+            uint32_t bucket = getBucket(x, z);
+            //different cells might share a bucket, it shouldn't be checked twice
+            if (std::find(visitedBuckets, visitedBuckets + visitedCount, bucket) != visitedBuckets + visitedCount) {
+                continue;
+            }
+            visitedBuckets[visitedCount++] = bucket;
+            for (uint32_t i = bucketStarts[bucket]; i < bucketStarts[bucket + 1]; ++i) {
+                uint32_t other = sortedAgents[i];
+                if (other == agentIndex) {
+                    continue;
+                }
+                glm::vec3 difference = agents[other].position - agent.position;
+                if (std::fabs(difference.y) > maxHeightDifference) {
+                    continue;
+                }
+                float distance = std::sqrt(difference.x * difference.x + difference.z * difference.z);
+                if (distance > neighbourDistance) {
+                    continue;
+                }
+                if (neighbourCount == MAX_NEIGHBOURS && distance >= distances[MAX_NEIGHBOURS - 1]) {
+                    continue;
+                }
+                //insert sorted, dropping the furthest if full
+                uint32_t position = std::min(neighbourCount, MAX_NEIGHBOURS - 1);
+                while (position > 0 && distances[position - 1] > distance) {
+                    distances[position] = distances[position - 1];
+                    neighbours[position] = neighbours[position - 1];
+                    position--;
+                }
+                distances[position] = distance;
+                neighbours[position] = other;
+                if (neighbourCount < MAX_NEIGHBOURS) {
+                    neighbourCount++;
+                }
+            }
+        }
+    }
+    return neighbourCount;
+}
+
+/**
+ * Time until agent collides with neighbour, if agent takes candidate velocity. Moving neighbours are expected to
+ * take half of the avoidance, so reciprocal velocity obstacle is used for them.
+ */
+float CrowdSimulation::timeToCollision(const Agent &agent, const Agent &neighbour, const glm::vec2 &candidate) const {
+    glm::vec2 relativePosition(neighbour.position.x - agent.position.x, neighbour.position.z - agent.position.z);
+    glm::vec2 agentVelocity(agent.velocity.x, agent.velocity.z);
+    glm::vec2 neighbourVelocity(neighbour.velocity.x, neighbour.velocity.z);
+    glm::vec2 neighbourPreferred(neighbour.preferredVelocity.x, neighbour.preferredVelocity.z);
+
+    glm::vec2 relativeVelocity;
+    if (glm::dot(neighbourPreferred, neighbourPreferred) > 0.0f) {
+        relativeVelocity = 2.0f * candidate - agentVelocity - neighbourVelocity;
+    } else {
+        relativeVelocity = candidate - neighbourVelocity;
+    }
+
+    float combinedRadius = agent.radius + neighbour.radius;
+    float c = glm::dot(relativePosition, relativePosition) - combinedRadius * combinedRadius;
+    float b = glm::dot(relativePosition, relativeVelocity);
+    if (c < 0.0f) {
+        //already overlapping, only moving apart is allowed
+        return b > 0.0f ? 0.0f : std::numeric_limits<float>::infinity();
+    }
+    float a = glm::dot(relativeVelocity, relativeVelocity);
+    if (a < 1e-8f || b <= 0.0f) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float time = (b - std::sqrt(discriminant)) / a;
+    if (time > timeHorizon) {
+        return std::numeric_limits<float>::infinity();
+    }
+    return time;
+}
+
+void CrowdSimulation::solveRange(size_t startIndex, size_t endIndex) {
+    uint32_t neighbours[MAX_NEIGHBOURS];
+    for (size_t i = startIndex; i < endIndex; ++i) {
+        Agent &agent = agents[i];
+        uint32_t neighbourCount = findNeighbours((uint32_t) i, neighbours);
+        if (neighbourCount == 0) {
+            agent.newVelocity = agent.preferredVelocity;
+            continue;
+        }
+        glm::vec2 preferred(agent.preferredVelocity.x, agent.preferredVelocity.z);
+        float maxSpeed = std::max(glm::length(preferred), glm::length(glm::vec2(agent.velocity.x, agent.velocity.z)));
+
+        glm::vec2 bestCandidate = preferred;
+        float bestPenalty = std::numeric_limits<float>::max();
+        //preferred and stopping first, then full and half speed on each direction
+        uint32_t candidateCount = 2 + 2 * CANDIDATE_DIRECTION_COUNT;
+        //directions are rotated per agent, so symmetric agents don't pick symmetric velocities
+        float angleOffset = i * 0.618f;
+        for (uint32_t k = 0; k < candidateCount; ++k) {
+            glm::vec2 candidate;
+            if (k == 0) {
+                candidate = preferred;
+            } else if (k == 1) {
+                candidate = glm::vec2(0, 0);
+            } else {
+                uint32_t direction = (k - 2) % CANDIDATE_DIRECTION_COUNT;
+                float speed = (k - 2) < CANDIDATE_DIRECTION_COUNT ? maxSpeed : maxSpeed * 0.5f;
+                float angle = angleOffset + direction * (2.0f * 3.14159265f / CANDIDATE_DIRECTION_COUNT);
+                candidate = glm::vec2(std::cos(angle), std::sin(angle)) * speed;
+            }
+            float minimumTime = std::numeric_limits<float>::infinity();
+            for (uint32_t j = 0; j < neighbourCount && minimumTime > 0.0f; ++j) {
+                minimumTime = std::min(minimumTime, timeToCollision(agent, agents[neighbours[j]], candidate));
+            }
+            float penalty = glm::length(candidate - preferred);
+            if (minimumTime != std::numeric_limits<float>::infinity()) {
+                penalty += collisionPenaltyWeight / std::max(minimumTime, 0.001f);
+            }
+            if (penalty < bestPenalty) {
+                bestPenalty = penalty;
+                bestCandidate = candidate;
+            }
+        }
+        agent.newVelocity = glm::vec3(bestCandidate.x, agent.preferredVelocity.y, bestCandidate.y);
+    }
+}
+
+void CrowdSimulation::staticWorkerJob(void *crowdSimulation, uint32_t jobIndex) {
+    CrowdSimulation *simulation = static_cast<CrowdSimulation *>(crowdSimulation);
+    const WorkerParameters &parameters = simulation->workerParameters[jobIndex];
+    simulation->solveRange(parameters.startIndex, parameters.endIndex);
+}
+
+void CrowdSimulation::step() {
+    if (agents.empty()) {
+        return;
+    }
+    Uint64 stepStartTime = SDL_GetPerformanceCounter();
+    maximumAgentCount = std::max(maximumAgentCount, agents.size());
+    buildSpatialHash();
+
+    size_t usedThreadCount = std::min((size_t) threadCount, agents.size() / minimumAgentsPerThread);
+    if (usedThreadCount <= 1) {
+        solveRange(0, agents.size());
+    } else {
+        //one range per thread, main thread works on them too
+        workerParameters.resize(usedThreadCount);
+        size_t agentsPerThread = agents.size() / usedThreadCount;
+        for (size_t i = 0; i < usedThreadCount; ++i) {
+            workerParameters[i].startIndex = i * agentsPerThread;
+            workerParameters[i].endIndex = (i == usedThreadCount - 1) ? agents.size() : workerParameters[i].startIndex + agentsPerThread;
+        }
+        workerPool->run(&staticWorkerJob, this, (uint32_t) usedThreadCount);
+    }
+
+    stepCount++;
+    stepMicroseconds += ((SDL_GetPerformanceCounter() - stepStartTime) * 1000000) / SDL_GetPerformanceFrequency();
+}
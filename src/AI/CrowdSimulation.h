@@ -0,0 +1,108 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_CROWDSIMULATION_H
+#define LIMONENGINE_CROWDSIMULATION_H
+
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class WorkerPool;
+
+/**
+ * Local avoidance between actors, using reciprocal velocity obstacles.
+ *
+ * Each tick agents are added with their current and preferred movement, then step calculates a movement for each
+ * agent that avoids the others. Neighbours are found by a spatial hash that is rebuilt on every step, and each agent
+ * picks the candidate velocity with the lowest penalty, penalty being distance to preferred velocity plus inverse of
+ * time to collision. Only x-z plane is considered, y of preferred movement is kept as is.
+ *
+ * Agents only read shared data while solving, so agents are split to worker threads, which are kept between steps.
+ *
+ * Velocities are movement per tick, since actors move by a translate each tick.
+ */
+class CrowdSimulation {
+public:
+    struct Agent {
+        glm::vec3 position;
+        glm::vec3 velocity;
+        glm::vec3 preferredVelocity;
+        float radius;
+        glm::vec3 newVelocity;
+    };
+
+private:
+    struct WorkerParameters {
+        size_t startIndex;
+        size_t endIndex;
+    };
+
+    static const uint32_t CANDIDATE_DIRECTION_COUNT = 16;
+    static const uint32_t MAX_NEIGHBOURS = 10;
+
+    float neighbourDistance = 4.0f;//also the cell size of spatial hash
+    float maxHeightDifference = 2.0f;//agents on different floors are not neighbours
+    float timeHorizon = 30.0f;//in ticks
+    float collisionPenaltyWeight = 0.5f;
+
+    std::vector<Agent> agents;
+    //spatial hash, agents sorted by bucket. Agents of bucket b are sortedAgents[bucketStarts[b], bucketStarts[b+1])
+    std::vector<uint32_t> bucketStarts;
+    std::vector<uint32_t> sortedAgents;
+    std::vector<uint32_t> agentBuckets;
+    uint32_t bucketMask = 0;
+
+    uint32_t threadCount;
+    size_t minimumAgentsPerThread = 64;
+    WorkerPool *workerPool = nullptr;
+    std::vector<WorkerParameters> workerParameters;
+
+    uint64_t stepCount = 0;
+    uint64_t stepMicroseconds = 0;
+    size_t maximumAgentCount = 0;
+
+    uint32_t getBucket(int32_t cellX, int32_t cellZ) const;
+
+    void buildSpatialHash();
+
+    uint32_t findNeighbours(uint32_t agentIndex, uint32_t *neighbours) const;
+
+    float timeToCollision(const Agent &agent, const Agent &neighbour, const glm::vec2 &candidate) const;
+
+    void solveRange(size_t startIndex, size_t endIndex);
+
+    static void staticWorkerJob(void *crowdSimulation, uint32_t jobIndex);
+
+public:
+    explicit CrowdSimulation(uint32_t threadCount);
+
+    CrowdSimulation(const CrowdSimulation &) = delete;
+    CrowdSimulation &operator=(const CrowdSimulation &) = delete;
+
+    ~CrowdSimulation();
+
+    /**
+     * @return handle to get the result after step
+     */
+    uint32_t addAgent(const glm::vec3 &position, const glm::vec3 &velocity, const glm::vec3 &preferredVelocity,
+                      float radius);
+
+    void step();
+
+    const glm::vec3 &getNewVelocity(uint32_t handle) const {
+        return agents[handle].newVelocity;
+    }
+
+    /**
+     * Removes agents, but keeps the memory for next tick.
+     */
+    void clear() {
+        agents.clear();
+    }
+};
+
+
+#endif //LIMONENGINE_CROWDSIMULATION_H
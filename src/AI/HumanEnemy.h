@@ -48,8 +48,8 @@ public:
                 //actor might not be for current implementation.
                 lastWalkDirection = information.toPlayerRoute;
             }
-            glm::vec3 moveDirection = 0.1f * lastWalkDirection;
-            model->getTransformation()->addTranslate(moveDirection);
+            //applied by world after other actors are avoided
+            desiredMovement = 0.1f * lastWalkDirection;
             if(information.isPlayerLeft) {
                 if(information.cosineBetweenPlayerForSide < 0.95) {
                     glm::quat rotateLeft(1.0f, 0.0f, 0.015f, 0.0f);
@@ -0,0 +1,120 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "PathRequestScheduler.h"
+#include "AIMovementGrid.h"
+#include "AINavMesh.h"
+
+#include <SDL_timer.h>
+
+void PathRequestScheduler::submitRequest(uint32_t actorID, const glm::vec3 &from, const glm::vec3 &to) {
+    ActorPathState &state = actorStates[actorID];
+    if (!state.hasResult && !state.isWaiting) {
+        //first request of the actor, start searching from root
+        state.startNode = AIMovementNode::NO_NEIGHBOUR;
+        state.goalNode = AIMovementNode::NO_NEIGHBOUR;
+    }
+    state.from = from;
+    state.to = to;
+    if (!state.isWaiting) {
+        state.isWaiting = true;
+        waitingActors.push_back(actorID);
+    }
+}
+
+void PathRequestScheduler::processRequest(uint32_t actorID, ActorPathState &state) {
+    //last nodes are used as hint, actors and player move a few nodes between requests at most
+    uint32_t startNode = grid->findNode(state.from, state.startNode);
+    uint32_t goalNode = grid->findNode(state.to, state.goalNode);
+    stats.processedCount++;
+    if (state.hasResult && startNode == state.startNode && goalNode == state.goalNode &&
+        state.blockingGeneration == grid->getBlockingGeneration()) {
+        stats.cacheHitCount++;
+        return;
+    }
+    state.hasResult = true;
+    state.startNode = startNode;
+    state.goalNode = goalNode;
+    state.blockingGeneration = grid->getBlockingGeneration();
+    if (navMesh != nullptr) {
+        //navigation mesh has its own fallback for actors that are pushed off the mesh
+        state.result.isFound = navMesh->coursePath(state.from, state.to, actorID, &state.result.route);
+        return;
+    }
+    if (startNode == AIMovementNode::NO_NEIGHBOUR || goalNode == AIMovementNode::NO_NEIGHBOUR) {
+        state.result.isFound = false;
+        state.result.route.clear();
+        return;
+    }
+    state.result.isFound = grid->findPath(startNode, goalNode, &state.result.route);
+}
+
+void PathRequestScheduler::processRequests(uint32_t microsecondBudget) {
+    Uint64 budgetInCounts = (((Uint64) microsecondBudget) * SDL_GetPerformanceFrequency()) / 1000000;
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    while (!waitingActors.empty()) {
+        uint32_t actorID = waitingActors.front();
+        waitingActors.pop_front();
+        auto stateIt = actorStates.find(actorID);
+        if (stateIt == actorStates.end() || !stateIt->second.isWaiting) {
+            continue;//actor removed
+        }
+        stateIt->second.isWaiting = false;
+        processRequest(actorID, stateIt->second);
+        if (SDL_GetPerformanceCounter() - startTime >= budgetInCounts) {
+            break;
+        }
+    }
+    if (!waitingActors.empty()) {
+        stats.deferredTickCount++;
+    }
+}
+
+const PathRequestScheduler::PathResult *PathRequestScheduler::getResult(uint32_t actorID) const {
+    auto stateIt = actorStates.find(actorID);
+    if (stateIt == actorStates.end() || !stateIt->second.hasResult) {
+        return nullptr;
+    }
+    return &(stateIt->second.result);
+}
+
+bool PathRequestScheduler::isWaiting(uint32_t actorID) const {
+    auto stateIt = actorStates.find(actorID);
+    return stateIt != actorStates.end() && stateIt->second.isWaiting;
+}
+
+void PathRequestScheduler::removeActor(uint32_t actorID) {
+    //waiting queue is not searched, entry is skipped when it is processed
+    actorStates.erase(actorID);
+}
+
+void PathRequestScheduler::updateFlowFieldGoal(const glm::vec3 &goal) {
+    flowGoalNode = grid->findNode(goal, flowGoalNode);
+    grid->updateFlowField(flowGoalNode);
+}
+
+const PathRequestScheduler::PathResult *
+PathRequestScheduler::getFlowFieldResult(uint32_t actorID, const glm::vec3 &from) {
+    ActorPathState &state = actorStates[actorID];
+    if (!state.hasResult) {
+        state.startNode = AIMovementNode::NO_NEIGHBOUR;
+    }
+    state.hasResult = true;
+    state.startNode = grid->findNode(from, state.startNode);
+    state.goalNode = flowGoalNode;
+    state.blockingGeneration = grid->getBlockingGeneration();
+    state.result.route.clear();
+    if (state.startNode == AIMovementNode::NO_NEIGHBOUR || flowGoalNode == AIMovementNode::NO_NEIGHBOUR) {
+        state.result.isFound = false;
+        return &(state.result);
+    }
+    uint32_t nextNode = grid->getFlowNextNode(state.startNode);
+    if (nextNode == AIMovementNode::NO_NEIGHBOUR) {
+        state.result.isFound = state.startNode == flowGoalNode;//already there, empty route
+        return &(state.result);
+    }
+    state.result.isFound = true;
+    state.result.route.push_back(grid->getNode(nextNode).getPosition());
+    return &(state.result);
+}
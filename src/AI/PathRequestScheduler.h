@@ -0,0 +1,114 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_PATHREQUESTSCHEDULER_H
+#define LIMONENGINE_PATHREQUESTSCHEDULER_H
+
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+class AIMovementGrid;
+class AINavMesh;
+
+/**
+ * Actors submit path requests, and requests are processed in order, until per tick time budget is used.
+ * Result of an actor is kept until a newer one is calculated, so actors use the last known route while
+ * their new request waits. Each actor has at most one waiting request, submitting again updates it.
+ *
+ * Start and goal are snapped to grid nodes before search, and if they are same with the last search of
+ * the actor, last route is reused without searching. Routes are not reused if grid nodes are blocked or
+ * unblocked since they were calculated.
+ *
+ * If navigation mesh is set, requests are searched on it instead of the grid. Grid nodes are still used to
+ * detect if the last route can be reused.
+ *
+ * If all actors go to same goal, flow field can be used instead of requests. Then route of an actor only
+ * contains the next step, and it is read from the grid flow field without any search.
+ */
+class PathRequestScheduler {
+public:
+    struct PathResult {
+        bool isFound = false;
+        std::vector<glm::vec3> route;//reversed, last element is the next step
+    };
+
+    struct SchedulerStats {
+        uint64_t processedCount = 0;
+        uint64_t cacheHitCount = 0;
+        uint64_t deferredTickCount = 0;//ticks that ended with waiting requests
+    };
+
+private:
+    struct ActorPathState {
+        glm::vec3 from;
+        glm::vec3 to;
+        bool isWaiting = false;
+        bool hasResult = false;
+        uint32_t startNode;
+        uint32_t goalNode;
+        uint32_t blockingGeneration;//grid blocking generation result is calculated with
+        PathResult result;
+    };
+
+    AIMovementGrid *grid;
+    AINavMesh *navMesh = nullptr;
+    std::deque<uint32_t> waitingActors;
+    std::unordered_map<uint32_t, ActorPathState> actorStates;
+    SchedulerStats stats;
+    uint32_t flowGoalNode = 0xFFFFFFFF;
+
+    void processRequest(uint32_t actorID, ActorPathState &state);
+
+public:
+    explicit PathRequestScheduler(AIMovementGrid *grid) : grid(grid) {}
+
+    void setNavMesh(AINavMesh *navMesh) {
+        this->navMesh = navMesh;
+    }
+
+    void submitRequest(uint32_t actorID, const glm::vec3 &from, const glm::vec3 &to);
+
+    /**
+     * Processes waiting requests until budget is used. At least one request is processed each call, so
+     * every request is processed eventually even if budget is too small.
+     */
+    void processRequests(uint32_t microsecondBudget);
+
+    /**
+     * @return last calculated result of the actor, nullptr if there is none yet
+     */
+    const PathResult *getResult(uint32_t actorID) const;
+
+    /**
+     * @return true if actor has a request that is not processed yet
+     */
+    bool isWaiting(uint32_t actorID) const;
+
+    void removeActor(uint32_t actorID);
+
+    /**
+     * Updates the shared flow field goal, field is only recalculated if goal moved to another node.
+     */
+    void updateFlowFieldGoal(const glm::vec3 &goal);
+
+    /**
+     * Returns the next step of the actor on flow field. Result is calculated immediately, it doesn't wait for processing.
+     */
+    const PathResult *getFlowFieldResult(uint32_t actorID, const glm::vec3 &from);
+
+    size_t getWaitingRequestCount() const {
+        return waitingActors.size();
+    }
+
+    const SchedulerStats &getStats() const {
+        return stats;
+    }
+};
+
+
+#endif //LIMONENGINE_PATHREQUESTSCHEDULER_H
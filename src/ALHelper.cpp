@@ -79,16 +79,10 @@ int ALHelper::soundManager() {
                             std::cerr << "Loop audio buffer data failed!" << alGetString(error) << std::endl;
                         }
 
-                        temp->sampleCountToPlay = temp->asset->getSampleCount();
-                        temp->nextDataToBuffer = temp->asset->getSoundData();
+                        rewindSound(temp);
 
                         for (uint32_t i = 0; i < NUM_BUFFERS; ++i) {
-                            uint32_t currentPlaySize = std::min((uint64_t) temp->sampleCountToPlay,
-                                                                (uint64_t) BUFFER_ELEMENT_COUNT);
-                            temp->sampleCountToPlay = temp->sampleCountToPlay - currentPlaySize;
-                            alBufferData(temp->buffers[i], temp->format, temp->nextDataToBuffer,
-                                         currentPlaySize * sizeof(int16_t), temp->asset->getSampleRate());
-                            temp->nextDataToBuffer = temp->nextDataToBuffer + currentPlaySize;
+                            bufferNextData(temp, temp->buffers[i]);
                             if ((error = alGetError()) != AL_NO_ERROR) {
                                 std::cerr << "Loop audio buffer data failed!" << alGetString(error) << std::endl;
                             }
@@ -151,14 +145,19 @@ bool ALHelper::startPlay(std::unique_ptr<PlayingSound> &sound) {
 
     sound->format = to_al_format(sound->asset->getChannels(), 16);
 
-    sound->nextDataToBuffer = sound->asset->getSoundData();
-    sound->sampleCountToPlay = sound->asset->getSampleCount();
-    for (uint32_t i = 0; i < NUM_BUFFERS; ++i) {
-        uint32_t currentPlaySize = std::min((uint64_t)sound->sampleCountToPlay, (uint64_t)BUFFER_ELEMENT_COUNT);
-        sound->sampleCountToPlay = sound->sampleCountToPlay - currentPlaySize;
+    if (sound->asset->isStreamed()) {
+        //each playing instance decodes on its own, so same asset can be played multiple times
+        sound->stream = std::unique_ptr<SoundStream>(new SoundStream(sound->asset));
+        if (!sound->stream->isOpen()) {
+            std::cerr << "Sound stream can't be opened, not playing." << std::endl;
+            return false;
+        }
+        sound->streamBuffer.resize(BUFFER_ELEMENT_COUNT);
+    }
 
-        alBufferData(sound->buffers[i], sound->format, sound->nextDataToBuffer, currentPlaySize * sizeof(int16_t), sound->asset->getSampleRate());
-        sound->nextDataToBuffer = sound->nextDataToBuffer + currentPlaySize;
+    rewindSound(sound);
+    for (uint32_t i = 0; i < NUM_BUFFERS; ++i) {
+        bufferNextData(sound, sound->buffers[i]);
         ALenum error;
         if ((error = alGetError()) != AL_NO_ERROR) {
             std::cerr << "Audio buffer data failed with error " << alGetString(error) << std::endl;
@@ -196,16 +195,11 @@ bool ALHelper::refreshBuffers(std::unique_ptr<ALHelper::PlayingSound> &sound) {
 //            Read the next chunk of decoded data from the stream
 //            Pop the oldest queued buffer from the source, fill it with the new data, then requeue it
             alSourceUnqueueBuffers(sound->source, 1, &buffer);
-            uint32_t currentPlaySize = std::min((uint64_t) sound->sampleCountToPlay, (uint64_t) BUFFER_ELEMENT_COUNT);
-            sound->sampleCountToPlay = sound->sampleCountToPlay - currentPlaySize;
-            if(currentPlaySize > 0) {
-                alBufferData(buffer, sound->format, sound->nextDataToBuffer, currentPlaySize * sizeof(int16_t),
-                             sound->asset->getSampleRate());
+            if(bufferNextData(sound, buffer) > 0) {
                 if ((error = alGetError()) != AL_NO_ERROR) {
                     std::cerr << "Error buffering alGenBuffers : " << alGetString(error) << std::endl;
                     return 1;
                 }
-                sound->nextDataToBuffer = sound->nextDataToBuffer + currentPlaySize;
                 alSourceQueueBuffers(sound->source, 1, &buffer);
                 if ((error = alGetError()) != AL_NO_ERROR) {
                     std::cerr << "Error source buffering : %s" << alGetString(error) << std::endl;
@@ -217,6 +211,37 @@ bool ALHelper::refreshBuffers(std::unique_ptr<ALHelper::PlayingSound> &sound) {
     return true;
 }
 
+void ALHelper::rewindSound(std::unique_ptr<PlayingSound> &sound) {
+    sound->sampleCountToPlay = sound->asset->getSampleCount();
+    sound->nextDataToBuffer = sound->asset->getSoundData();
+    if (sound->stream != nullptr && !sound->stream->rewind()) {
+        std::cerr << "Sound stream rewind failed!" << std::endl;
+        sound->sampleCountToPlay = 0;
+    }
+}
+
+uint32_t ALHelper::bufferNextData(std::unique_ptr<PlayingSound> &sound, ALuint buffer) {
+    uint32_t currentPlaySize = std::min((uint64_t) sound->sampleCountToPlay, (uint64_t) BUFFER_ELEMENT_COUNT);
+    const int16_t *data = sound->nextDataToBuffer;
+    if (sound->stream != nullptr && currentPlaySize > 0) {
+        //decoder might return less than header promised if file is truncated
+        currentPlaySize = (uint32_t) sound->stream->read(sound->streamBuffer.data(), currentPlaySize);
+        data = sound->streamBuffer.data();
+        if (currentPlaySize == 0) {
+            sound->sampleCountToPlay = 0;
+        }
+    }
+    sound->sampleCountToPlay = sound->sampleCountToPlay - currentPlaySize;
+    //alBufferData copies the data, so stream buffer can be reused right away
+    alBufferData(buffer, sound->format, data, currentPlaySize * sizeof(int16_t), sound->asset->getSampleRate());
+    if (sound->stream == nullptr) {
+        sound->nextDataToBuffer = sound->nextDataToBuffer + currentPlaySize;
+    }
+    return currentPlaySize;
+}
+
+ALHelper::PlayingSound::PlayingSound(uint32_t id) : soundID(id) {}
+
 bool ALHelper::PlayingSound::isFinished() {
     ALint source_state;
     alGetSourcei(source, AL_SOURCE_STATE, &source_state);
@@ -20,6 +20,7 @@
 #include <SDL_thread.h>
 
 class SoundAsset;
+class SoundStream;
 
 #define NUM_BUFFERS 3
 #define BUFFER_ELEMENT_COUNT 8192
@@ -35,11 +36,13 @@ class ALHelper {
         ALenum format;
         ALuint buffers[NUM_BUFFERS];
         const int16_t *nextDataToBuffer;
+        std::unique_ptr<SoundStream> stream;//only for streamed assets, decodes into streamBuffer
+        std::vector<int16_t> streamBuffer;
         bool looped;
         glm::vec3 position = glm::vec3(0,0,0);
         bool isPositionRelative = true;
         bool isFinished();
-        PlayingSound(uint32_t id): soundID(id) {};
+        explicit PlayingSound(uint32_t id);
 
         ~PlayingSound();
     };
@@ -87,6 +90,14 @@ class ALHelper {
 
     bool refreshBuffers(std::unique_ptr<PlayingSound> &sound);//this method updates some of the values of parameter
 
+    void rewindSound(std::unique_ptr<PlayingSound> &sound);
+
+    /**
+     * Fills the buffer with next chunk of the sound, decoding it first if the sound is streamed.
+     * @return number of samples buffered, 0 if sound is finished
+     */
+    uint32_t bufferNextData(std::unique_ptr<PlayingSound> &sound, ALuint buffer);
+
     uint32_t getNextRequestID(){
         return soundRequestID++;
     }
@@ -7,6 +7,7 @@
 #include <iostream>
 #include "AnimationAssimp.h"
 #include "AnimationNode.h"
+#include "../../Utils/BinaryStream.h"
 
 
 
@@ -68,3 +69,35 @@ AnimationAssimp::AnimationAssimp(aiAnimation *assimpAnimation) {
 
     //validate
 }
+
+AnimationAssimp::AnimationAssimp(BinaryReader &reader) {
+    duration = reader.read<float>();
+    ticksPerSecond = reader.read<float>();
+    uint32_t nodeCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < nodeCount && !reader.isFailed(); ++i) {
+        std::string nodeName = reader.readString();
+        AnimationNode *node = new AnimationNode();
+        reader.readVector(node->translates);
+        reader.readVector(node->translateTimes);
+        reader.readVector(node->scales);
+        reader.readVector(node->scaleTimes);
+        reader.readVector(node->rotations);
+        reader.readVector(node->rotationTimes);
+        nodes[nodeName] = node;
+    }
+}
+
+void AnimationAssimp::serialize(BinaryWriter &writer) const {
+    writer.write(duration);
+    writer.write(ticksPerSecond);
+    writer.write((uint32_t) nodes.size());
+    for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+        writer.writeString(it->first);
+        writer.writeVector(it->second->translates);
+        writer.writeVector(it->second->translateTimes);
+        writer.writeVector(it->second->scales);
+        writer.writeVector(it->second->scaleTimes);
+        writer.writeVector(it->second->rotations);
+        writer.writeVector(it->second->rotationTimes);
+    }
+}
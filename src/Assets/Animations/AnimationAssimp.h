@@ -13,6 +13,8 @@
 #include <tinyxml2.h>
 
 class AnimationNode;
+class BinaryWriter;
+class BinaryReader;
 
 class AnimationAssimp {
     float ticksPerSecond;
@@ -23,6 +25,13 @@ class AnimationAssimp {
 public:
     AnimationAssimp(aiAnimation *assimpAnimation);
 
+    /**
+     * Loads from cooked model data, check reader for failure after.
+     */
+    explicit AnimationAssimp(BinaryReader &reader);
+
+    void serialize(BinaryWriter &writer) const;
+
     glm::mat4 calculateTransform(const std::string& nodeName, float time, bool &isFound) const;
 
     float getTicksPerSecond() const {
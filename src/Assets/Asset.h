@@ -7,11 +7,18 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 
 class AssetManager;//avoid cyclic include
 
 class Asset {
+public:
+    enum class LoadState { NOT_LOADED, CPU_LOADED, LOADED };
+
+private:
+    friend class AssetManager;//only asset manager changes load state
+    LoadState loadState = LoadState::NOT_LOADED;
 
 protected:
     AssetManager* assetManager;
@@ -32,6 +39,47 @@ public:
         return assetID;
     }
 
+    bool isLoaded() const {
+        return loadState == LoadState::LOADED;
+    }
+
+    /**
+     * Loading that doesn't need GL context, like file read and decode. For async loads this runs on a loader thread,
+     * so it must not make GL calls or change asset manager state. Reading options and GL capability queries are allowed,
+     * they are set before loader threads start and don't change after. Assets that don't split their loading do all
+     * of it in constructor.
+     */
+    virtual void loadCPUPart() {};
+
+    /**
+     * GL object creation, always runs on main thread after loadCPUPart.
+     */
+    virtual void loadGPUPart() {};
+
+    /**
+     * Textures that are needed by loadGPUPart. Async loads request them before uploading, so they are decoded
+     * on loader threads too. Only valid after loadCPUPart.
+     */
+    virtual std::vector<std::vector<std::string>> getTextureDependencies() const {
+        return std::vector<std::vector<std::string>>();
+    };
+
+    /**
+     * Used by asset cache budgets and stats, estimates are enough. Only valid after loading.
+     */
+    virtual uint64_t getCPUMemoryUsage() const {
+        return 0;
+    }
+
+    virtual uint64_t getGPUMemoryUsage() const {
+        return 0;
+    }
+
+    /**
+     * Stats are grouped by this.
+     */
+    virtual std::string getTypeName() const = 0;
+
     virtual ~Asset() {};
 };
 
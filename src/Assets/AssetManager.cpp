@@ -2,3 +2,306 @@
 // Created by engin on 27.07.2016.
 //
 
+#include "AssetManager.h"
+#include "TextureAsset.h"
+#include "TextureStreamer.h"
+#include "../Options.h"
+
+#include <algorithm>
+#include <SDL_timer.h>
+
+AssetManager::AssetManager(GLHelper *glHelper, ALHelper *alHelper, Options *options) :
+        glHelper(glHelper), alHelper(alHelper), options(options) {
+    cacheCPUBudget = ((uint64_t) options->getAssetCacheCPUBudgetMB()) * 1024 * 1024;
+    cacheGPUBudget = ((uint64_t) options->getAssetCacheGPUBudgetMB()) * 1024 * 1024;
+    if (options->isUseCompressedTextures() && options->isUseTextureStreaming()) {
+        if (options->isUseMaterialTextureArrays()) {
+            //texture arrays are copied from full textures once, so they can't be streamed
+            std::cout << "Material texture arrays are enabled, texture streaming is disabled." << std::endl;
+        } else {
+            textureStreamer = new TextureStreamer(((uint64_t) options->getTextureStreamingBudgetMB()) * 1024 * 1024);
+        }
+    }
+    loadMutex = SDL_CreateMutex();
+    loadCondition = SDL_CreateCond();
+    for (uint32_t i = 0; i < options->getAssetLoaderThreadCount(); ++i) {
+        SDL_Thread *thread = SDL_CreateThread(&staticLoaderWorker, "assetLoader", this);
+        if (thread == nullptr) {
+            std::cerr << "Asset loader thread creation failed. " << SDL_GetError() << std::endl;
+            continue;
+        }
+        loaderThreads.push_back(thread);
+    }
+    if (loaderThreads.empty()) {
+        std::cout << "No asset loader threads, async loads will be done synchronously." << std::endl;
+    }
+}
+
+int AssetManager::staticLoaderWorker(void *assetManager) {
+    static_cast<AssetManager *>(assetManager)->loaderWorker();
+    return 0;
+}
+
+void AssetManager::loaderWorker() {
+    SDL_LockMutex(loadMutex);
+    while (true) {
+        while (!stopLoaders && (cpuLoadQueue.empty() || uploadQueue.size() >= maximumUploadQueueSize)) {
+            SDL_CondWait(loadCondition, loadMutex);
+        }
+        if (stopLoaders) {
+            break;
+        }
+        Asset *asset = cpuLoadQueue.front();
+        cpuLoadQueue.pop_front();
+        SDL_UnlockMutex(loadMutex);
+
+        asset->loadCPUPart();
+
+        SDL_LockMutex(loadMutex);
+        uploadQueue.push_back(asset);
+        //main thread might be waiting for this asset
+        SDL_CondBroadcast(loadCondition);
+    }
+    SDL_UnlockMutex(loadMutex);
+}
+
+void AssetManager::requestDependencies(Asset *asset) {
+    std::vector<std::vector<std::string>> dependencies = asset->getTextureDependencies();
+    for (size_t i = 0; i < dependencies.size(); ++i) {
+        //the reference is kept until asset is uploaded, so dependency is not freed before asset uses it
+        loadAssetAsync<TextureAsset>(dependencies[i]);
+        dependencyReferences[asset].push_back(dependencies[i]);
+    }
+}
+
+bool AssetManager::areDependenciesLoaded(Asset *asset) {
+    auto referenceIt = dependencyReferences.find(asset);
+    if (referenceIt == dependencyReferences.end()) {
+        return true;
+    }
+    for (size_t i = 0; i < referenceIt->second.size(); ++i) {
+        if (!assets.at(referenceIt->second[i]).asset->isLoaded()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetManager::uploadAsset(Asset *asset) {
+    auto referenceIt = dependencyReferences.find(asset);
+    if (referenceIt != dependencyReferences.end()) {
+        for (size_t i = 0; i < referenceIt->second.size(); ++i) {
+            Asset *dependency = assets.at(referenceIt->second[i]).asset;
+            if (!dependency->isLoaded()) {
+                finishLoading(dependency);
+            }
+        }
+    }
+
+    asset->loadGPUPart();
+    asset->loadState = Asset::LoadState::LOADED;
+
+    //asset holds its own references to dependencies now
+    referenceIt = dependencyReferences.find(asset);
+    if (referenceIt != dependencyReferences.end()) {
+        std::vector<std::vector<std::string>> references = referenceIt->second;
+        dependencyReferences.erase(referenceIt);
+        for (size_t i = 0; i < references.size(); ++i) {
+            freeAsset(references[i]);
+        }
+    }
+}
+
+void AssetManager::finishLoading(Asset *asset) {
+    if (asset->loadState == Asset::LoadState::LOADED) {
+        return;
+    }
+    if (asset->loadState == Asset::LoadState::NOT_LOADED) {
+        bool loadHere = false;
+        SDL_LockMutex(loadMutex);
+        while (true) {
+            auto queueIt = std::find(cpuLoadQueue.begin(), cpuLoadQueue.end(), asset);
+            if (queueIt != cpuLoadQueue.end()) {
+                //not started yet, doing it here is faster than waiting
+                cpuLoadQueue.erase(queueIt);
+                loadHere = true;
+                break;
+            }
+            queueIt = std::find(uploadQueue.begin(), uploadQueue.end(), asset);
+            if (queueIt != uploadQueue.end()) {
+                uploadQueue.erase(queueIt);
+                SDL_CondBroadcast(loadCondition);
+                break;
+            }
+            //a loader thread is working on it
+            SDL_CondWait(loadCondition, loadMutex);
+        }
+        SDL_UnlockMutex(loadMutex);
+        if (loadHere) {
+            asset->loadCPUPart();
+        }
+        asset->loadState = Asset::LoadState::CPU_LOADED;
+    } else {
+        auto waitingIt = std::find(dependencyWaitingAssets.begin(), dependencyWaitingAssets.end(), asset);
+        if (waitingIt != dependencyWaitingAssets.end()) {
+            dependencyWaitingAssets.erase(waitingIt);
+        }
+    }
+    uploadAsset(asset);
+}
+
+uint32_t AssetManager::processUploads(uint32_t microsecondBudget) {
+    Uint64 budgetInCounts = (((Uint64) microsecondBudget) * SDL_GetPerformanceFrequency()) / 1000000;
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    uint32_t uploadCount = 0;
+
+    for (size_t i = 0; i < dependencyWaitingAssets.size();) {
+        if (!areDependenciesLoaded(dependencyWaitingAssets[i])) {
+            ++i;
+            continue;
+        }
+        Asset *asset = dependencyWaitingAssets[i];
+        dependencyWaitingAssets.erase(dependencyWaitingAssets.begin() + i);
+        uploadAsset(asset);
+        uploadCount++;
+        if (SDL_GetPerformanceCounter() - startTime >= budgetInCounts) {
+            return uploadCount;
+        }
+    }
+
+    while (true) {
+        Asset *asset = nullptr;
+        SDL_LockMutex(loadMutex);
+        if (!uploadQueue.empty()) {
+            asset = uploadQueue.front();
+            uploadQueue.pop_front();
+            //there is space in upload queue now
+            SDL_CondBroadcast(loadCondition);
+        }
+        SDL_UnlockMutex(loadMutex);
+        if (asset == nullptr) {
+            break;
+        }
+        asset->loadState = Asset::LoadState::CPU_LOADED;
+        requestDependencies(asset);
+        if (!areDependenciesLoaded(asset)) {
+            dependencyWaitingAssets.push_back(asset);
+            continue;
+        }
+        uploadAsset(asset);
+        uploadCount++;
+        if (SDL_GetPerformanceCounter() - startTime >= budgetInCounts) {
+            break;
+        }
+    }
+    return uploadCount;
+}
+
+void AssetManager::takeFromCache(AssetEntry &entry) {
+    assetTypeStats[entry.asset->getTypeName()].hits++;
+    if (entry.referenceCount != 0) {
+        return;
+    }
+    cachedAssets.erase(entry.cacheIterator);
+    cachedCPUMemory -= entry.cachedCPUMemory;
+    cachedGPUMemory -= entry.cachedGPUMemory;
+}
+
+void AssetManager::freeAsset(const std::vector<std::string> files) {
+    if (isDeletingAssets) {
+        //assets freeing their dependencies while manager is deleted
+        return;
+    }
+    auto assetIt = assets.find(files);
+    if (assetIt == assets.end() || assetIt->second.referenceCount == 0) {
+        std::cerr << "Unloading an asset that was not loaded. skipping" << std::endl;
+        return;
+    }
+    //entry reference stays valid even if finishing the load adds new assets
+    AssetEntry &entry = assetIt->second;
+    entry.referenceCount--;
+    if (entry.referenceCount != 0) {
+        return;
+    }
+    if (!entry.asset->isLoaded()) {
+        //a loader thread might be using it
+        finishLoading(entry.asset);
+    }
+    if (cacheCPUBudget == 0 || cacheGPUBudget == 0) {
+        //caching is disabled. Removed before delete, because deleting might free other assets
+        Asset *assetToRemove = entry.asset;
+        assets.erase(files);
+        delete assetToRemove;
+        return;
+    }
+    entry.cachedCPUMemory = entry.asset->getCPUMemoryUsage();
+    entry.cachedGPUMemory = entry.asset->getGPUMemoryUsage();
+    cachedAssets.push_front(files);
+    entry.cacheIterator = cachedAssets.begin();
+    cachedCPUMemory += entry.cachedCPUMemory;
+    cachedGPUMemory += entry.cachedGPUMemory;
+    evictCachedAssets();
+}
+
+void AssetManager::evictCachedAssets() {
+    while (!cachedAssets.empty() && (cachedCPUMemory > cacheCPUBudget || cachedGPUMemory > cacheGPUBudget)) {
+        std::vector<std::string> files = cachedAssets.back();
+        cachedAssets.pop_back();
+        auto assetIt = assets.find(files);
+        Asset *assetToRemove = assetIt->second.asset;
+        cachedCPUMemory -= assetIt->second.cachedCPUMemory;
+        cachedGPUMemory -= assetIt->second.cachedGPUMemory;
+        assetTypeStats[assetToRemove->getTypeName()].evictions++;
+        //removed before delete, because deleting might free other assets and evict again
+        assets.erase(assetIt);
+        delete assetToRemove;
+    }
+}
+
+void AssetManager::printCacheStats() const {
+    std::map<std::string, std::pair<uint64_t, uint64_t>> residentMemory;
+    for (auto assetIt = assets.begin(); assetIt != assets.end(); ++assetIt) {
+        if (!assetIt->second.asset->isLoaded()) {
+            continue;
+        }
+        std::pair<uint64_t, uint64_t> &typeMemory = residentMemory[assetIt->second.asset->getTypeName()];
+        typeMemory.first += assetIt->second.asset->getCPUMemoryUsage();
+        typeMemory.second += assetIt->second.asset->getGPUMemoryUsage();
+    }
+    std::cout << "Asset cache: " << cachedAssets.size() << " cached assets, " << cachedCPUMemory / 1024 << " KB CPU, "
+              << cachedGPUMemory / 1024 << " KB GPU." << std::endl;
+    for (auto statIt = assetTypeStats.begin(); statIt != assetTypeStats.end(); ++statIt) {
+        std::pair<uint64_t, uint64_t> typeMemory;
+        auto memoryIt = residentMemory.find(statIt->first);
+        if (memoryIt != residentMemory.end()) {
+            typeMemory = memoryIt->second;
+        }
+        std::cout << "    " << statIt->first << ": " << statIt->second.hits << " hits, " << statIt->second.misses
+                  << " misses, " << statIt->second.evictions << " evictions, " << typeMemory.first / 1024
+                  << " KB CPU and " << typeMemory.second / 1024 << " KB GPU resident." << std::endl;
+    }
+}
+
+AssetManager::~AssetManager() {
+    SDL_LockMutex(loadMutex);
+    stopLoaders = true;
+    SDL_CondBroadcast(loadCondition);
+    SDL_UnlockMutex(loadMutex);
+    for (size_t i = 0; i < loaderThreads.size(); ++i) {
+        SDL_WaitThread(loaderThreads[i], nullptr);
+    }
+    SDL_DestroyCond(loadCondition);
+    SDL_DestroyMutex(loadMutex);
+
+    printCacheStats();
+    if (textureStreamer != nullptr) {
+        textureStreamer->printStats();
+    }
+    //free all the assets
+    isDeletingAssets = true;
+    for (auto it = assets.begin(); it != assets.end(); it++) {
+        delete it->second.asset;
+    }
+    //textures remove themselves from streamer, so it is deleted after them
+    delete textureStreamer;
+}
@@ -8,27 +8,117 @@
 
 #include <string>
 #include <map>
+#include <list>
+#include <deque>
 #include <utility>
+#include <unordered_map>
 #include <tinyxml2.h>
+#include <SDL_thread.h>
 
 #include "Asset.h"
 #include "../ALHelper.h"
+#include "../Utils/HashUtils.h"
 
 class GLHelper;
 class ALHelper;
+class Options;
+class TextureStreamer;
+template<class T> class AssetFuture;
 
+/**
+ * Assets can be loaded synchronously by loadAsset, or asynchronously by loadAssetAsync.
+ *
+ * Async loads run loadCPUPart of the asset on loader threads, then asset waits in upload queue. Upload queue is
+ * processed on main thread by processUploads, in the given time budget. Upload queue is bounded, loader threads wait
+ * if it is full, so decoded data doesn't pile up in memory while main thread is busy.
+ *
+ * If an asset that is loading async is requested by loadAsset, or freed, its loading is finished immediately.
+ *
+ * Assets that are freed by everything are not deleted immediately, they are cached so switching worlds doesn't reload
+ * the shared assets. When total size of cached assets exceed CPU or GPU budget, least recently freed ones are deleted.
+ * If either budget is 0, caching is disabled and freed assets are deleted immediately.
+ */
 class AssetManager {
     enum AssetTypes { Asset_type_MODEL, Asset_type_TEXTURE, Asset_type_SKYMAP, Asset_type_SOUND };
-    //second of the pair is how many times load requested. prework for unload
-    std::map<const std::vector<std::string>, std::pair<Asset *, uint32_t>> assets;
+
+    struct AssetFilesHash {
+        size_t operator()(const std::vector<std::string> &files) const {
+            uint64_t hash = HashUtils::FNV_OFFSET_BASIS;
+            for (size_t i = 0; i < files.size(); ++i) {
+                //separator, so {"ab", "c"} and {"a", "bc"} don't collide
+                hash = HashUtils::hashValue(files[i].length(), HashUtils::hashString(files[i], hash));
+            }
+            return (size_t) hash;
+        }
+    };
+
+    struct AssetEntry {
+        Asset *asset;
+        uint32_t referenceCount = 0;//how many times load requested and not freed
+        //rest is only valid when asset is cached, which means reference count is 0
+        uint64_t cachedCPUMemory = 0;
+        uint64_t cachedGPUMemory = 0;
+        std::list<std::vector<std::string>>::iterator cacheIterator;
+
+        explicit AssetEntry(Asset *asset = nullptr) : asset(asset) {}
+    };
+
+    struct AssetTypeStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    std::unordered_map<std::vector<std::string>, AssetEntry, AssetFilesHash> assets;
     uint32_t nextAssetIndex = 1;
 
+    //assets that are not referenced, front is the most recently freed
+    std::list<std::vector<std::string>> cachedAssets;
+    uint64_t cacheCPUBudget;
+    uint64_t cacheGPUBudget;
+    uint64_t cachedCPUMemory = 0;
+    uint64_t cachedGPUMemory = 0;
+    std::map<std::string, AssetTypeStats> assetTypeStats;//ordered so stats print in same order
+    bool isDeletingAssets = false;
+
     std::map<std::string, AssetTypes> availableAssetsList;//this map should be ordered, or editor list order would be unpredictable
     GLHelper *glHelper;
     ALHelper *alHelper;
+    Options *options;
+    TextureStreamer *textureStreamer = nullptr;
+
+    //async loading, queues are shared with loader threads, and guarded by loadMutex
+    std::vector<SDL_Thread *> loaderThreads;
+    SDL_mutex *loadMutex;
+    SDL_cond *loadCondition;
+    std::deque<Asset *> cpuLoadQueue;
+    std::deque<Asset *> uploadQueue;
+    size_t maximumUploadQueueSize = 16;
+    bool stopLoaders = false;
+    //rest is only accessed by main thread
+    std::vector<Asset *> dependencyWaitingAssets;
+    std::unordered_map<Asset *, std::vector<std::vector<std::string>>> dependencyReferences;
+
+    static int staticLoaderWorker(void *assetManager);
+
+    void loaderWorker();
+
+    void requestDependencies(Asset *asset);
+
+    bool areDependenciesLoaded(Asset *asset);
+
+    void uploadAsset(Asset *asset);
+
+    /**
+     * If the asset is in cache, it is removed from cache since it is referenced again. Counts the hit.
+     */
+    void takeFromCache(AssetEntry &entry);
+
+    void evictCachedAssets();
+
 public:
 
-    explicit AssetManager(GLHelper *glHelper, ALHelper *alHelper) : glHelper(glHelper), alHelper(alHelper) {}
+    AssetManager(GLHelper *glHelper, ALHelper *alHelper, Options *options);
 
     /**
      * This should be done not from file but file system. Best way is switch to c++17, but not sure
@@ -65,29 +155,74 @@ public:
 
     template<class T>
     T *loadAsset(const std::vector<std::string> files) {
-        if (assets.count(files) == 0) {
-            assets[files] = std::make_pair(new T(this, nextAssetIndex, files), 0);
+        auto assetIt = assets.find(files);
+        if (assetIt == assets.end()) {
+            T *asset = new T(this, nextAssetIndex, files);
             nextAssetIndex++;
+            asset->loadCPUPart();
+            asset->loadGPUPart();
+            asset->loadState = Asset::LoadState::LOADED;
+            assets.insert(std::make_pair(files, AssetEntry(asset)));
+            assetTypeStats[asset->getTypeName()].misses++;
+        } else {
+            takeFromCache(assetIt->second);
+            if (!assetIt->second.asset->isLoaded()) {
+                //requested async before, but it is needed now
+                finishLoading(assetIt->second.asset);
+            }
         }
 
-        assets[files].second++;
-        return (T *) assets[files].first;
+        assets.at(files).referenceCount++;
+        return (T *) assets.at(files).asset;
     }
 
-    void freeAsset(const std::vector<std::string> files) {
-        if (assets.count(files) == 0) {
-            std::cerr << "Unloading an asset that was not loaded. skipping" << std::endl;
-            return;
-        }
-        assets[files].second--;
-        if (assets[files].second == 0) {
-            //last element that requested the load freed, delete the object
-            Asset *assetToRemove = assets[files].first;
-            delete assetToRemove;
-            assets.erase(files);
+    /**
+     * Same with loadAsset, but returns before asset is loaded. Returned future should be checked before use,
+     * and the asset should be freed by freeAsset same as loadAsset.
+     */
+    template<class T>
+    AssetFuture<T> loadAssetAsync(const std::vector<std::string> files) {
+        auto assetIt = assets.find(files);
+        if (assetIt == assets.end()) {
+            T *asset = new T(this, nextAssetIndex, files);
+            nextAssetIndex++;
+            assets.insert(std::make_pair(files, AssetEntry(asset)));
+            assetTypeStats[asset->getTypeName()].misses++;
+            SDL_LockMutex(loadMutex);
+            cpuLoadQueue.push_back(asset);
+            SDL_CondBroadcast(loadCondition);
+            SDL_UnlockMutex(loadMutex);
+            if (loaderThreads.empty()) {
+                finishLoading(asset);
+            }
+        } else {
+            takeFromCache(assetIt->second);
         }
+        AssetEntry &entry = assets.at(files);
+        entry.referenceCount++;
+        return AssetFuture<T>(this, (T *) entry.asset);
     }
 
+    /**
+     * Uploads assets that finished their CPU part. At least one asset is uploaded if there is any waiting, even if
+     * budget is too small.
+     *
+     * @return number of assets uploaded
+     */
+    uint32_t processUploads(uint32_t microsecondBudget);
+
+    /**
+     * Blocks until asset is loaded. Must be called from main thread.
+     */
+    void finishLoading(Asset *asset);
+
+    /**
+     * When nothing uses the asset anymore, it is kept in cache until cache budget is exceeded.
+     */
+    void freeAsset(const std::vector<std::string> files);
+
+    void printCacheStats() const;
+
     const std::map<std::string, AssetTypes>& getAvailableAssetsList() {
         return availableAssetsList;
     };
@@ -101,14 +236,52 @@ public:
         return alHelper;
     }
 
-    ~AssetManager() {
-        //free all the assets
-        for (std::map<const std::vector<std::string>, std::pair<Asset *, uint32_t>>::iterator it = assets.begin();
-             it != assets.end(); it++) {
-            delete it->second.first;
-        }
+    Options *getOptions() const {
+        return options;
+    }
+
+    /**
+     * If false, async loads are done synchronously.
+     */
+    bool hasLoaderThreads() const {
+        return !loaderThreads.empty();
+    }
+
+    /**
+     * @return nullptr if texture streaming is disabled
+     */
+    TextureStreamer *getTextureStreamer() const {
+        return textureStreamer;
     }
 
+    ~AssetManager();
+
+};
+
+/**
+ * Handle of an async load. Asset is not usable until isReady returns true, or get is called.
+ */
+template<class T>
+class AssetFuture {
+    AssetManager *assetManager;
+    T *asset;
+
+public:
+    AssetFuture(AssetManager *assetManager, T *asset) : assetManager(assetManager), asset(asset) {}
+
+    bool isReady() const {
+        return asset->isLoaded();
+    }
+
+    /**
+     * Blocks until asset is loaded if it is not ready yet.
+     */
+    T *get() const {
+        if (!asset->isLoaded()) {
+            assetManager->finishLoading(asset);
+        }
+        return asset;
+    }
 };
 
 
@@ -40,6 +40,7 @@ CubeMapAsset::CubeMapAsset(AssetManager *assetManager, uint32_t assetID, const s
                                             surfaces[0]->pixels, surfaces[1]->pixels,
                                             surfaces[2]->pixels, surfaces[3]->pixels,
                                             surfaces[4]->pixels, surfaces[5]->pixels);
+    gpuMemoryUsage = ((uint64_t) surfaces[0]->h) * surfaces[0]->w * 4 * 6;
     for (int i = 0; i < 6; i++) {
         delete surfaces[i];
     }
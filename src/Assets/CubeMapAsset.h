@@ -18,6 +18,7 @@ class CubeMapAsset : public Asset {
     std::string path;
     std::string names[6];
     GLuint cubeMapBufferID;
+    uint64_t gpuMemoryUsage;
 public:
     CubeMapAsset(AssetManager *assetManager, uint32_t assetID, const std::vector<std::string> &fileList);
 
@@ -29,6 +30,14 @@ public:
         return cubeMapBufferID;
     }
 
+    uint64_t getGPUMemoryUsage() const override {
+        return gpuMemoryUsage;
+    }
+
+    std::string getTypeName() const override {
+        return "CubeMap";
+    }
+
     std::vector<std::string> getNames() {
         //FIXME this shouldn't be required. Assets should have IDs too
         std::vector<std::string> result;
@@ -4,11 +4,17 @@
 
 #include "MeshAsset.h"
 #include "../GLHelper.h"
+#include "../Options.h"
+#include "../Utils/BinaryStream.h"
+#include "../Utils/VertexQuantizer.h"
+#include "../Utils/MeshOptimizer.h"
+#include "../Utils/MeshSimplifier.h"
 
 MeshAsset::MeshAsset(AssetManager *assetManager, const aiMesh *currentMesh, std::string name,
                      const Material *material, const BoneNode *meshSkeleton, const glm::mat4 &parentTransform,
                      const bool isPartOfAnimated)
-        : name(name), material(material), parentTransform(parentTransform), isPartOfAnimated(isPartOfAnimated) {
+        : assetManager(assetManager), name(name), material(material), parentTransform(parentTransform),
+          isPartOfAnimated(isPartOfAnimated) {
     triangleCount = currentMesh->mNumFaces;
     if (!currentMesh->HasPositions()) {
         throw "No position found"; //Not going to process if mesh is empty
@@ -19,18 +25,6 @@ MeshAsset::MeshAsset(AssetManager *assetManager, const aiMesh *currentMesh, std:
         throw "No triangle found";
     }
 
-    uint_fast32_t vbo;
-    assetManager->getGlHelper()->bufferVertexData(vertices, faces, vao, vbo, 2, ebo);
-    bufferObjects.push_back(vbo);
-
-    assetManager->getGlHelper()->bufferNormalData(normals, vao, vbo, 4);
-    bufferObjects.push_back(vbo);
-
-    if (!textureCoordinates.empty()) {
-        assetManager->getGlHelper()->bufferVertexTextureCoordinates(textureCoordinates, vao, vbo, 3);
-        bufferObjects.push_back(vbo);
-    }
-
     //If model is animated, but mesh has no bones, it is most likely we need to attach to the nearest parent.
 
     //loadBoneInformation
@@ -68,12 +62,6 @@ MeshAsset::MeshAsset(AssetManager *assetManager, const aiMesh *currentMesh, std:
 
         }
         std::cout << "Animation added for mesh" << std::endl;
-
-        assetManager->getGlHelper()->bufferExtraVertexData(boneIDs, vao, vbo, 5);
-        bufferObjects.push_back(vbo);
-
-        assetManager->getGlHelper()->bufferExtraVertexData(boneWeights, vao, vbo, 6);
-        bufferObjects.push_back(vbo);
     } else {
         if(isPartOfAnimated) {
             //what to do now? now we assign bone id of the node, and weight of 1.0
@@ -105,18 +93,266 @@ MeshAsset::MeshAsset(AssetManager *assetManager, const aiMesh *currentMesh, std:
             }
 
             std::cout << "Animation added for mesh" << std::endl;
+        } else {
+            this->bones = false;
+        }
+    }
+
+    if (assetManager->getOptions()->isOptimizeMeshes()) {
+        optimizeIndices();
+    }
+    if (assetManager->getOptions()->getMeshLodCount() > 0) {
+        generateLods(assetManager->getOptions()->getMeshLodCount());
+    }
+    //vertex order is final after optimization, so packing and hulls are done last
+    packVertices();
+    if (isPartOfAnimated) {
+        buildBoneHulls();
+    }
+}
 
-            assetManager->getGlHelper()->bufferExtraVertexData(boneIDs, vao, vbo, 5);
-            bufferObjects.push_back(vbo);
+MeshAsset::MeshAsset(AssetManager *assetManager, BinaryReader &reader, const Material *material,
+                     const BoneNode *meshSkeleton)
+        : assetManager(assetManager), material(material), parentTransform(reader.read<glm::mat4>()),
+          isPartOfAnimated(reader.read<uint8_t>() != 0) {
+    name = reader.readString();
+    triangleCount = reader.read<uint32_t>();
+    bones = reader.read<uint8_t>() != 0;
+    reader.readVector(vertices);
+    reader.readVector(normals);
+    reader.readVector(faces);
+    reader.readVector(textureCoordinates);
+    reader.readVector(boneIDs);
+    reader.readVector(boneWeights);
+    uint32_t attachedBoneCount = reader.read<uint32_t>();
+    std::vector<uint32_t> attachedVertices;
+    for (uint32_t i = 0; i < attachedBoneCount && !reader.isFailed(); ++i) {
+        uint32_t boneID = reader.read<uint32_t>();
+        reader.readVector(attachedVertices);
+        boneAttachedMeshes[boneID].assign(attachedVertices.begin(), attachedVertices.end());
+    }
+    uint32_t lodCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < lodCount && !reader.isFailed(); ++i) {
+        lodFaces.emplace_back();
+        reader.readVector(lodFaces.back());
+    }
+    positionOffset = reader.read<glm::vec3>();
+    positionScale = reader.read<glm::vec3>();
+    reader.readVector(packedVertices);
+    reader.readVector(packedSkinnedVertices);
+    uint32_t hullCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < hullCount && !reader.isFailed(); ++i) {
+        uint32_t boneID = reader.read<uint32_t>();
+        reader.readVector(boneHulls[boneID]);
+    }
+    if (packedVertices.size() + packedSkinnedVertices.size() != vertices.size()) {
+        throw "Cooked mesh vertex count mismatch";
+    }
+    if (reader.isFailed()) {
+        throw "Cooked mesh data is corrupted";
+    }
+    vertexCount = vertices.size();
+    if (bones) {
+        this->skeleton = meshSkeleton;
+        fillBoneMap(this->skeleton);
+    }
+}
 
-            assetManager->getGlHelper()->bufferExtraVertexData(boneWeights, vao, vbo, 6);
-            bufferObjects.push_back(vbo);
+MeshAsset::~MeshAsset() {
+    for (unsigned int i = 0; i < shapeCopies.size(); ++i) {
+        delete shapeCopies[i];
+    }
+    //meshes that are never uploaded have no GL objects, they might be deleted by loader threads
+    GLHelper *glHelper = assetManager->getGlHelper();
+    for (size_t i = 0; i < bufferObjects.size(); ++i) {
+        glHelper->freeBuffer(bufferObjects[i]);
+    }
+    if (ebo != 0) {
+        glHelper->freeBuffer(ebo);
+    }
+    for (size_t i = 0; i < lodEbos.size(); ++i) {
+        glHelper->freeBuffer(lodEbos[i]);
+    }
+    if (vao != 0) {
+        glHelper->freeVAO(vao);
+    }
+}
 
+void MeshAsset::serialize(BinaryWriter &writer) const {
+    //parent transform and animated flag are first, since they are const and read in initializer list
+    writer.write(parentTransform);
+    writer.write((uint8_t) isPartOfAnimated);
+    writer.writeString(name);
+    writer.write((uint32_t) triangleCount);
+    writer.write((uint8_t) bones);
+    writer.writeVector(vertices);
+    writer.writeVector(normals);
+    writer.writeVector(faces);
+    writer.writeVector(textureCoordinates);
+    writer.writeVector(boneIDs);
+    writer.writeVector(boneWeights);
+    writer.write((uint32_t) boneAttachedMeshes.size());
+    for (auto it = boneAttachedMeshes.begin(); it != boneAttachedMeshes.end(); ++it) {
+        writer.write((uint32_t) it->first);
+        //uint_fast32_t size depends on platform, so it is written as 32 bit
+        std::vector<uint32_t> attachedVertices(it->second.begin(), it->second.end());
+        writer.writeVector(attachedVertices);
+    }
+    writer.write((uint32_t) lodFaces.size());
+    for (size_t i = 0; i < lodFaces.size(); ++i) {
+        writer.writeVector(lodFaces[i]);
+    }
+    //packed stream is what GPU gets, so loading a cooked mesh doesn't touch vertices one by one
+    writer.write(positionOffset);
+    writer.write(positionScale);
+    writer.writeVector(packedVertices);
+    writer.writeVector(packedSkinnedVertices);
+    writer.write((uint32_t) boneHulls.size());
+    for (auto it = boneHulls.begin(); it != boneHulls.end(); ++it) {
+        writer.write((uint32_t) it->first);
+        writer.writeVector(it->second);
+    }
+}
 
-        } else {
-            this->bones = false;
+void MeshAsset::packVertices() {
+    VertexQuantizer::calculatePositionRange(vertices, positionOffset, positionScale);
+    if (bones) {
+        packedSkinnedVertices = VertexQuantizer::packSkinned(vertices, normals, textureCoordinates, boneIDs, boneWeights,
+                                                             positionOffset, positionScale);
+    } else {
+        packedVertices = VertexQuantizer::pack(vertices, normals, textureCoordinates, positionOffset, positionScale);
+    }
+}
+
+void MeshAsset::buildBoneHulls() {
+    for (auto it = boneAttachedMeshes.begin(); it != boneAttachedMeshes.end(); it++) {
+        btConvexHullShape hullshape;
+        for (unsigned int index = 0; index < it->second.size(); index++) {
+            hullshape.addPoint(GLMConverter::GLMToBlt(vertices[it->second[index]]));
+        }
+        btShapeHull hull(&hullshape);
+        hull.buildHull(hullshape.getMargin());
+        std::vector<glm::vec3> &hullPoints = boneHulls[it->first];
+        for (int i = 0; i < hull.numVertices(); ++i) {
+            hullPoints.push_back(GLMConverter::BltToGLM(hull.getVertexPointer()[i]));
+        }
+    }
+}
+
+void MeshAsset::uploadToGPU() {
+    uint_fast32_t vbo;
+    if (packedVertices.empty() && packedSkinnedVertices.empty()) {
+        packVertices();//freed by an earlier upload
+    }
+    gpuDataSize = packedVertices.size() * sizeof(VertexQuantizer::PackedVertex) +
+                  packedSkinnedVertices.size() * sizeof(VertexQuantizer::PackedSkinnedVertex);
+    indexType = assetManager->getGlHelper()->bufferPackedVertexData(packedVertices, packedSkinnedVertices, faces,
+                                                                    vao, vbo, ebo);
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    gpuDataSize += faces.size() * 3 * indexSize;
+    //lod levels use the same vertices, only index buffers are different
+    for (size_t i = 0; i < lodFaces.size(); ++i) {
+        lodEbos.push_back(assetManager->getGlHelper()->bufferIndexData(lodFaces[i], indexType));
+        gpuDataSize += lodFaces[i].size() * 3 * indexSize;
+    }
+    bufferObjects.push_back(vbo);
+    //GPU has the only copy that is used
+    std::vector<VertexQuantizer::PackedVertex>().swap(packedVertices);
+    std::vector<VertexQuantizer::PackedSkinnedVertex>().swap(packedSkinnedVertices);
+}
+
+template<class T>
+static void remapVertexData(std::vector<T> &data, const std::vector<uint32_t> &remap) {
+    if (data.empty()) {
+        return;
+    }
+    std::vector<T> remapped(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        remapped[remap[i]] = data[i];
+    }
+    data.swap(remapped);
+}
+
+/**
+ * Reorders faces and vertices for GPU caches. It is done at import, cooked models are saved in optimized order.
+ */
+void MeshAsset::optimizeIndices() {
+    std::vector<uint32_t> indices(faces.size() * 3);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        indices[i * 3] = faces[i][0];
+        indices[i * 3 + 1] = faces[i][1];
+        indices[i * 3 + 2] = faces[i][2];
+    }
+    uint32_t currentVertexCount = (uint32_t) vertices.size();
+    MeshOptimizer::CacheStatistics before = MeshOptimizer::analyzeVertexCache(indices, currentVertexCount);
+
+    MeshOptimizer::optimizeVertexCache(indices, currentVertexCount);
+    MeshOptimizer::optimizeOverdraw(indices, vertices);
+    std::vector<uint32_t> remap = MeshOptimizer::optimizeVertexFetch(indices, currentVertexCount);
+
+    MeshOptimizer::CacheStatistics after = MeshOptimizer::analyzeVertexCache(indices, currentVertexCount);
+
+    for (size_t i = 0; i < faces.size(); ++i) {
+        faces[i] = glm::mediump_uvec3(indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2]);
+    }
+    remapVertexData(vertices, remap);
+    remapVertexData(normals, remap);
+    remapVertexData(textureCoordinates, remap);
+    remapVertexData(boneIDs, remap);
+    remapVertexData(boneWeights, remap);
+    for (auto it = boneAttachedMeshes.begin(); it != boneAttachedMeshes.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            it->second[i] = remap[it->second[i]];
+        }
+    }
+    //faces that are not triangles are skipped by setTriangles, so this might be less than face count of assimp
+    triangleCount = faces.size();
+
+    std::cout << "Mesh " << name << " optimized, ACMR " << before.acmr << " -> " << after.acmr << ", ATVR "
+              << before.atvr << " -> " << after.atvr << " (FIFO cache of " << MeshOptimizer::ANALYSIS_CACHE_SIZE
+              << ")" << std::endl;
+}
+
+/**
+ * Each level is simplified from the previous one to about half of its triangles. Error limit doubles every level,
+ * generation stops early if a level can't be simplified enough without passing the limit.
+ */
+void MeshAsset::generateLods(uint32_t lodCount) {
+    if (vertices.empty() || faces.empty()) {
+        return;
+    }
+    glm::vec3 minimum = vertices[0], maximum = vertices[0];
+    for (size_t i = 1; i < vertices.size(); ++i) {
+        minimum = glm::min(minimum, vertices[i]);
+        maximum = glm::max(maximum, vertices[i]);
+    }
+    float extent = glm::length(maximum - minimum);
+
+    std::vector<uint32_t> indices(faces.size() * 3);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        indices[i * 3] = faces[i][0];
+        indices[i * 3 + 1] = faces[i][1];
+        indices[i * 3 + 2] = faces[i][2];
+    }
+    std::cout << "Mesh " << name << " lod triangle counts: " << faces.size();
+    for (uint32_t lod = 1; lod <= lodCount; ++lod) {
+        float allowedDistance = extent * 0.005f * (1 << lod);
+        std::vector<uint32_t> simplified = MeshSimplifier::simplify(indices, vertices, indices.size() / 2,
+                                                                    allowedDistance * allowedDistance);
+        if (simplified.empty() || simplified.size() > indices.size() * 9 / 10) {
+            break;
+        }
+        if (assetManager->getOptions()->isOptimizeMeshes()) {
+            MeshOptimizer::optimizeVertexCache(simplified, (uint32_t) vertices.size());
+        }
+        lodFaces.emplace_back(simplified.size() / 3);
+        for (size_t i = 0; i < lodFaces.back().size(); ++i) {
+            lodFaces.back()[i] = glm::mediump_uvec3(simplified[i * 3], simplified[i * 3 + 1], simplified[i * 3 + 2]);
         }
+        std::cout << ", " << lodFaces.back().size();
+        indices.swap(simplified);
     }
+    std::cout << std::endl;
 }
 
 bool MeshAsset::setTriangles(const aiMesh *currentMesh) {
@@ -235,18 +471,13 @@ btTriangleMesh *MeshAsset::getBulletMesh(std::map<uint_fast32_t, btConvexHullSha
         //in this case, we don't use faces directly, instead we use per bone vertex information.
         std::map<uint_fast32_t, std::vector<uint_fast32_t >>::iterator it;
         for (it = boneAttachedMeshes.begin(); it != boneAttachedMeshes.end(); it++) {
+            //hull points are built at import, or read from cooked file
             btConvexHullShape *hullshape = new btConvexHullShape();
-            for (unsigned int index = 0; index < it->second.size(); index++) {
-                hullshape->addPoint(GLMConverter::GLMToBlt(vertices[it->second[index]]));
+            const std::vector<glm::vec3> &hullPoints = boneHulls[it->first];
+            for (size_t index = 0; index < hullPoints.size(); index++) {
+                hullshape->addPoint(GLMConverter::GLMToBlt(hullPoints[index]), false);
             }
-            btShapeHull *hull = new btShapeHull(hullshape);
-            btScalar margin = hullshape->getMargin();
-            hull->buildHull(margin);
-            delete hullshape;
-            hullshape = nullptr;
-
-            hullshape = new btConvexHullShape((const btScalar *) hull->getVertexPointer(),
-                                              hull->numVertices());
+            hullshape->recalcLocalAabb();
             //FIXME clear memory leak here, no one deletes this shapes.
             (*hullMap)[it->first] = hullshape;
             (*parentTransformMap)[it->first].setFromOpenGLMatrix(glm::value_ptr(parentTransform));
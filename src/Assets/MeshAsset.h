@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <assimp/scene.h>
@@ -14,22 +15,29 @@
 #include <glm/glm.hpp>
 
 #include "../Utils/GLMConverter.h"
+#include "../Utils/VertexQuantizer.h"
 #include "AssetManager.h"
 #include "../Material.h"
 #include "BoneNode.h"
 
+class BinaryWriter;
+class BinaryReader;
 
 class MeshAsset {
-    uint_fast32_t vao, ebo;
+    AssetManager *assetManager;
+    uint_fast32_t vao = 0, ebo = 0;
     uint_fast32_t triangleCount, vertexCount;
 
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec3> normals;
     std::vector<glm::mediump_uvec3> faces;
+    std::vector<std::vector<glm::mediump_uvec3>> lodFaces;//simplified faces for lod 1 and up, same vertices
     std::vector<glm::vec2> textureCoordinates;
     std::string name;
 
     std::map<uint_fast32_t, std::vector<uint_fast32_t >> boneAttachedMeshes;
+    //convex hull points of vertices attached to each bone, built once and cooked, so loading doesn't build hulls
+    std::map<uint_fast32_t, std::vector<glm::vec3>> boneHulls;
 
     const BoneNode *skeleton;
     std::map<std::string, uint_fast32_t> boneIdMap;
@@ -47,8 +55,26 @@ class MeshAsset {
     std::vector<btTriangleMesh *> shapeCopies;
 
     std::vector<uint_fast32_t> bufferObjects;
+    //packed positions are decoded as offset + scale * packed
+    glm::vec3 positionOffset = glm::vec3(0, 0, 0);
+    glm::vec3 positionScale = glm::vec3(1, 1, 1);
+    uint64_t gpuDataSize = 0;
+    uint32_t indexType = 0;//GL type of indices, set by uploadToGPU
+    std::vector<uint_fast32_t> lodEbos;
+    //interleaved vertex stream prepared on CPU side, and cooked as is. Freed after upload
+    std::vector<VertexQuantizer::PackedVertex> packedVertices;
+    std::vector<VertexQuantizer::PackedSkinnedVertex> packedSkinnedVertices;
+
     bool setTriangles(const aiMesh *currentMesh);
 
+    void packVertices();
+
+    void buildBoneHulls();
+
+    void optimizeIndices();
+
+    void generateLods(uint32_t lodCount);
+
     void normalizeTextureCoordinates(glm::vec2 &textureCoordinates) const;
 
 public:
@@ -56,12 +82,86 @@ public:
                   const Material *material, const BoneNode *meshSkeleton, const glm::mat4 &parentTransform,
                   const bool isPartOfAnimated);
 
+    /**
+     * Loads from cooked model data, reader should be at the position serialize started writing.
+     */
+    MeshAsset(AssetManager *assetManager, BinaryReader &reader, const Material *material, const BoneNode *meshSkeleton);
+
+    void serialize(BinaryWriter &writer) const;
+
+    /**
+     * Creates GL buffers, must be called on main thread. Constructor only prepares CPU side data,
+     * so it can be run on asset loader threads.
+     */
+    void uploadToGPU();
+
     uint_fast32_t getTriangleCount() const { return triangleCount; }
 
+    /**
+     * Lod 0 is the full detail mesh, requests for levels that don't exist return the lowest detail level.
+     */
+    uint_fast32_t getTriangleCount(uint32_t lod) const {
+        if (lod == 0 || lodFaces.empty()) {
+            return triangleCount;
+        }
+        return lodFaces[std::min((size_t) lod, lodFaces.size()) - 1].size();
+    }
+
+    uint32_t getLodCount() const { return lodFaces.size() + 1; }
+
+    const std::vector<glm::mediump_uvec3> &getFaces(uint32_t lod) const {
+        if (lod == 0 || lodFaces.empty()) {
+            return faces;
+        }
+        return lodFaces[std::min((size_t) lod, lodFaces.size()) - 1];
+    }
+
+    const std::vector<glm::vec3> &getVertices() const { return vertices; }
+
+    const std::vector<glm::vec3> &getNormals() const { return normals; }
+
+    const std::vector<glm::vec2> &getTextureCoordinates() const { return textureCoordinates; }
+
+    const glm::vec3 &getPositionOffset() const { return positionOffset; }
+
+    const glm::vec3 &getPositionScale() const { return positionScale; }
+
+    /**
+     * Size of vertex and index data kept on CPU.
+     */
+    uint64_t getDataSize() const {
+        uint64_t lodFaceCount = 0;
+        for (size_t i = 0; i < lodFaces.size(); ++i) {
+            lodFaceCount += lodFaces[i].size();
+        }
+        return vertices.size() * sizeof(glm::vec3) + normals.size() * sizeof(glm::vec3) +
+               (faces.size() + lodFaceCount) * sizeof(glm::mediump_uvec3) +
+               textureCoordinates.size() * sizeof(glm::vec2) +
+               boneIDs.size() * sizeof(glm::lowp_uvec4) + boneWeights.size() * sizeof(glm::vec4) +
+               packedVertices.size() * sizeof(VertexQuantizer::PackedVertex) +
+               packedSkinnedVertices.size() * sizeof(VertexQuantizer::PackedSkinnedVertex);
+    }
+
+    /**
+     * Size of packed vertex and index data, only valid after upload.
+     */
+    uint64_t getGPUDataSize() const {
+        return gpuDataSize;
+    }
+
     uint_fast32_t getVao() const { return vao; }
 
     uint_fast32_t getEbo() const { return ebo; }
 
+    uint_fast32_t getEbo(uint32_t lod) const {
+        if (lod == 0 || lodEbos.empty()) {
+            return ebo;
+        }
+        return lodEbos[std::min((size_t) lod, lodEbos.size()) - 1];
+    }
+
+    uint32_t getIndexType() const { return indexType; }
+
     btTriangleMesh *getBulletMesh(std::map<uint_fast32_t, btConvexHullShape *> *hullMap,
                                   std::map<uint_fast32_t, btTransform> *parentTransformMap);
 
@@ -73,12 +173,7 @@ public:
 
     bool hasBones() const;
 
-    ~MeshAsset() {
-        for (unsigned int i = 0; i < shapeCopies.size(); ++i) {
-            delete shapeCopies[i];
-        }
-
-    }
+    ~MeshAsset();
 
     void fillBoneMap(const BoneNode *boneNode);
 
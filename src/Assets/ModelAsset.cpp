@@ -3,11 +3,22 @@
 //
 
 #include <set>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <sys/stat.h>
+#include <SDL_timer.h>
 #include "ModelAsset.h"
 #include "../glm/gtx/matrix_decompose.hpp"
 #include "../Utils/GLMUtils.h"
 #include "Animations/AnimationAssimp.h"
 #include "../GLHelper.h"
+#include "../Options.h"
+#include "../Utils/BinaryStream.h"
+#include "../Utils/MemoryMappedFile.h"
+
+const uint32_t ModelAsset::COOKED_MAGIC;
+const uint32_t ModelAsset::COOKED_VERSION;
 
 ModelAsset::ModelAsset(AssetManager *assetManager, uint32_t assetID, const std::vector<std::string> &fileList)
         : Asset(assetManager, assetID,
@@ -22,6 +33,50 @@ ModelAsset::ModelAsset(AssetManager *assetManager, uint32_t assetID, const std::
     if (fileList.size() > 1) {
         std::cerr << "multiple files are sent to Model constructor, extra elements ignored." << std::endl;
     }
+}
+
+/**
+ * Models are loaded from cooked file next to source if it is up to date. Otherwise they are imported by Assimp,
+ * and cooked file is written for next load.
+ */
+void ModelAsset::loadCPUPart() {
+    bool isCookingEnabled = assetManager->getOptions()->isUseCookedModels();
+    std::string cookedFileName = name + ".limonmodel";
+    CookedFileHeader header;
+    header.magic = COOKED_MAGIC;
+    header.version = COOKED_VERSION;
+    header.sourceSize = 0;
+    header.sourceModifiedTime = 0;
+    header.meshLodCount = assetManager->getOptions()->getMeshLodCount();
+    header.optimizeMeshes = assetManager->getOptions()->isOptimizeMeshes() ? 1 : 0;
+    struct stat sourceStat;
+    bool isSourceFound = stat(name.c_str(), &sourceStat) == 0;
+    if (isSourceFound) {
+        header.sourceSize = (uint64_t) sourceStat.st_size;
+        header.sourceModifiedTime = (int64_t) sourceStat.st_mtime;
+    }
+
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    if (isCookingEnabled) {
+        if (loadFromCookedFile(cookedFileName, header)) {
+            std::cout << "Model " << name << " loaded from cooked file in "
+                      << ((SDL_GetPerformanceCounter() - startTime) * 1000) / SDL_GetPerformanceFrequency() << "ms." << std::endl;
+            return;
+        }
+        clearCPUData();
+    }
+
+    loadFromSource();
+    std::cout << "Model " << name << " imported from source in "
+              << ((SDL_GetPerformanceCounter() - startTime) * 1000) / SDL_GetPerformanceFrequency() << "ms." << std::endl;
+    if (isCookingEnabled && isSourceFound) {
+        if (!writeCookedFile(cookedFileName, header)) {
+            std::cerr << "Model " << name << " couldn't be cooked, it will be imported again on next load." << std::endl;
+        }
+    }
+}
+
+void ModelAsset::loadFromSource() {
     std::cout << "ASSIMP::Loading::" << name << std::endl;
     const aiScene *scene;
     Assimp::Importer import;
@@ -64,6 +119,373 @@ ModelAsset::ModelAsset(AssetManager *assetManager, uint32_t assetID, const std::
     //Implicit call to import.FreeScene(), and removal of scene.
 }
 
+void ModelAsset::loadGPUPart() {
+    for (auto materialIt = materialMap.begin(); materialIt != materialMap.end(); ++materialIt) {
+        Material *material = materialIt->second;
+        const MaterialTextures &textures = materialTextureNames[material->getName()];
+        material->setMaterialIndex(assetManager->getGlHelper()->getNextMaterialIndex());
+        if (!textures.ambient.empty()) {
+            material->setAmbientTexture(textures.ambient);
+            std::cout << "set ambient texture " << textures.ambient << std::endl;
+        }
+        if (!textures.diffuse.empty()) {
+            material->setDiffuseTexture(textures.diffuse);
+            std::cout << "set diffuse texture " << textures.diffuse << std::endl;
+        }
+        if (!textures.specular.empty()) {
+            material->setSpecularTexture(textures.specular);
+            std::cout << "set specular texture " << textures.specular << std::endl;
+        }
+        if (!textures.opacity.empty()) {
+            material->setOpacityTexture(textures.opacity);
+            std::cout << "set opacity texture " << textures.opacity << std::endl;
+        }
+
+        uint32_t maps = 0;
+        if(material->hasAmbientMap()) {
+            maps +=8;
+        }
+        if(material->hasDiffuseMap()) {
+            maps +=4;
+        }
+        if(material->hasSpecularMap()) {
+            maps +=2;
+        }
+        if(material->hasOpacityMap()) {
+            maps +=1;
+        }
+        material->setMaps(maps);
+    }
+
+    if (assetManager->getOptions()->isUseMaterialTextureArrays()) {
+        packTextureArrays();
+    }
+    for (auto materialIt = materialMap.begin(); materialIt != materialMap.end(); ++materialIt) {
+        assetManager->getGlHelper()->setMaterial(materialIt->second);
+    }
+
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        meshes[i]->uploadToGPU();
+    }
+    for (auto meshIt = simplifiedMeshes.begin(); meshIt != simplifiedMeshes.end(); ++meshIt) {
+        meshIt->second->uploadToGPU();
+    }
+}
+
+static TextureAsset *getMapTexture(const Material *material, uint32_t mapIndex) {
+    switch (mapIndex) {
+        case 0: return material->hasAmbientMap() ? material->getAmbientTexture() : nullptr;
+        case 1: return material->hasDiffuseMap() ? material->getDiffuseTexture() : nullptr;
+        case 2: return material->hasSpecularMap() ? material->getSpecularTexture() : nullptr;
+        default: return material->hasOpacityMap() ? material->getOpacityTexture() : nullptr;
+    }
+}
+
+/**
+ * Packs textures of each map type to a texture array, so meshes with different materials don't need texture binds
+ * between them. Only textures with same size and format can share an array, so the biggest such group is packed, and
+ * the other textures are still bound per mesh. Specular maps are not packed, since shaders don't sample them.
+ */
+void ModelAsset::packTextureArrays() {
+    GLHelper *glHelper = assetManager->getGlHelper();
+    if (!glHelper->isTextureArrayPackingSupported()) {
+        std::cout << "Texture array packing is not supported, model " << name << " textures are not packed." << std::endl;
+        return;
+    }
+    std::vector<glm::ivec4> materialLayers(materialMap.size(), glm::ivec4(-1, -1, -1, -1));
+    for (uint32_t mapIndex = 0; mapIndex < 4; ++mapIndex) {
+        if (mapIndex == 2) {
+            continue;
+        }
+        //width, height, format
+        std::map<std::tuple<uint32_t, uint32_t, uint32_t>, std::vector<TextureAsset *>> textureGroups;
+        for (auto materialIt = materialMap.begin(); materialIt != materialMap.end(); ++materialIt) {
+            TextureAsset *texture = getMapTexture(materialIt->second, mapIndex);
+            if (texture == nullptr) {
+                continue;
+            }
+            std::vector<TextureAsset *> &group = textureGroups[std::make_tuple(texture->getWidth(), texture->getHeight(),
+                                                                               texture->getGLInternalFormat())];
+            if (std::find(group.begin(), group.end(), texture) == group.end()) {
+                group.push_back(texture);
+            }
+        }
+        const std::vector<TextureAsset *> *biggestGroup = nullptr;
+        for (auto groupIt = textureGroups.begin(); groupIt != textureGroups.end(); ++groupIt) {
+            if (biggestGroup == nullptr || groupIt->second.size() > biggestGroup->size()) {
+                biggestGroup = &groupIt->second;
+            }
+        }
+        //a single texture doesn't save any binds
+        if (biggestGroup == nullptr || biggestGroup->size() < 2) {
+            continue;
+        }
+        std::vector<GLuint> textureIDs;
+        for (size_t i = 0; i < biggestGroup->size(); ++i) {
+            textureIDs.push_back((*biggestGroup)[i]->getID());
+        }
+        TextureAsset *sampleTexture = (*biggestGroup)[0];
+        textureArrays[mapIndex] = glHelper->createTextureArray(textureIDs, sampleTexture->getHeight(),
+                                                               sampleTexture->getWidth(),
+                                                               sampleTexture->getGLInternalFormat());
+        if (textureArrays[mapIndex] == 0) {
+            std::cerr << "Texture array creation failed for model " << name << ", textures are not packed." << std::endl;
+            continue;
+        }
+        size_t materialIndex = 0;
+        for (auto materialIt = materialMap.begin(); materialIt != materialMap.end(); ++materialIt, ++materialIndex) {
+            TextureAsset *texture = getMapTexture(materialIt->second, mapIndex);
+            auto layerIt = std::find(biggestGroup->begin(), biggestGroup->end(), texture);
+            if (texture != nullptr && layerIt != biggestGroup->end()) {
+                materialLayers[materialIndex][mapIndex] = (int32_t) (layerIt - biggestGroup->begin());
+            }
+        }
+        std::cout << "Model " << name << " packed " << biggestGroup->size() << " textures to a texture array." << std::endl;
+    }
+    size_t materialIndex = 0;
+    for (auto materialIt = materialMap.begin(); materialIt != materialMap.end(); ++materialIt, ++materialIndex) {
+        materialIt->second->setTextureLayers(materialLayers[materialIndex]);
+    }
+}
+
+void ModelAsset::freeTextureArrays() {
+    for (uint32_t i = 0; i < 4; ++i) {
+        if (textureArrays[i] != 0) {
+            assetManager->getGlHelper()->deleteTexture(textureArrays[i]);
+            textureArrays[i] = 0;
+        }
+    }
+}
+
+void ModelAsset::serializeNodeTree(BinaryWriter &writer, const BoneNode *boneNode) const {
+    writer.writeString(boneNode->name);
+    writer.write((uint32_t) boneNode->boneID);
+    writer.write(boneNode->transformation);
+    writer.write((uint32_t) boneNode->children.size());
+    for (size_t i = 0; i < boneNode->children.size(); ++i) {
+        serializeNodeTree(writer, boneNode->children[i]);
+    }
+}
+
+BoneNode *ModelAsset::deserializeNodeTree(BinaryReader &reader) {
+    BoneNode *currentNode = new BoneNode();
+    currentNode->name = reader.readString();
+    currentNode->boneID = reader.read<uint32_t>();
+    currentNode->transformation = reader.read<glm::mat4>();
+    uint32_t childCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < childCount && !reader.isFailed(); ++i) {
+        currentNode->children.push_back(deserializeNodeTree(reader));
+    }
+    return currentNode;
+}
+
+bool ModelAsset::writeCookedFile(const std::string &cookedFileName, const CookedFileHeader &header) const {
+    BinaryWriter writer;
+    writer.write(header);
+    writer.write(globalInverseTransform);
+    writer.write((uint8_t) hasAnimation);
+    writer.write((uint32_t) boneIDCounter);
+    writer.write(boundingBoxMin);
+    writer.write(boundingBoxMax);
+    writer.write(centerOffset);
+    serializeNodeTree(writer, rootNode);
+
+    writer.write((uint32_t) meshOffsetmap.size());
+    for (auto it = meshOffsetmap.begin(); it != meshOffsetmap.end(); ++it) {
+        writer.writeString(it->first);
+        writer.write(it->second);
+    }
+
+    writer.write((uint32_t) materialMap.size());
+    for (auto it = materialMap.begin(); it != materialMap.end(); ++it) {
+        const Material *material = it->second;
+        const MaterialTextures &textures = materialTextureNames.at(material->getName());
+        writer.writeString(material->getName());
+        writer.write(material->getAmbientColor());
+        writer.write(material->getDiffuseColor());
+        writer.write(material->getSpecularColor());
+        writer.write(material->getSpecularExponent());
+        writer.writeString(textures.ambient);
+        writer.writeString(textures.diffuse);
+        writer.writeString(textures.specular);
+        writer.writeString(textures.opacity);
+    }
+
+    writer.write((uint32_t) (meshes.size() + simplifiedMeshes.size()));
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        writer.writeString(meshes[i]->getMaterial()->getName());
+        writer.write((uint8_t) 0);
+        meshes[i]->serialize(writer);
+    }
+    for (auto it = simplifiedMeshes.begin(); it != simplifiedMeshes.end(); ++it) {
+        writer.writeString(it->second->getMaterial()->getName());
+        writer.write((uint8_t) 1);
+        it->second->serialize(writer);
+    }
+
+    writer.write((uint32_t) animations.size());
+    for (auto it = animations.begin(); it != animations.end(); ++it) {
+        writer.writeString(it->first);
+        it->second->serialize(writer);
+    }
+    return writer.writeToFile(cookedFileName);
+}
+
+bool ModelAsset::loadFromCookedFile(const std::string &cookedFileName, const CookedFileHeader &expectedHeader) {
+    MemoryMappedFile cookedFile;
+    if (!cookedFile.open(cookedFileName)) {
+        return false;
+    }
+    BinaryReader reader(cookedFile.getData(), cookedFile.getSize());
+    CookedFileHeader header = reader.read<CookedFileHeader>();
+    if (reader.isFailed() || header.magic != COOKED_MAGIC || header.version != COOKED_VERSION) {
+        std::cerr << "Cooked model " << cookedFileName << " is not valid, importing from source." << std::endl;
+        return false;
+    }
+    //if source is not shipped, cooked file is used as is
+    if (expectedHeader.sourceSize != 0 &&
+        (header.sourceSize != expectedHeader.sourceSize || header.sourceModifiedTime != expectedHeader.sourceModifiedTime)) {
+        std::cout << "Cooked model " << cookedFileName << " is outdated, importing from source." << std::endl;
+        return false;
+    }
+    if (expectedHeader.sourceSize != 0 &&
+        (header.meshLodCount != expectedHeader.meshLodCount || header.optimizeMeshes != expectedHeader.optimizeMeshes)) {
+        std::cout << "Cooked model " << cookedFileName << " was cooked with different mesh options, importing from source." << std::endl;
+        return false;
+    }
+
+    globalInverseTransform = reader.read<glm::mat4>();
+    hasAnimation = reader.read<uint8_t>() != 0;
+    boneIDCounter = reader.read<uint32_t>();
+    boundingBoxMin = reader.read<glm::vec3>();
+    boundingBoxMax = reader.read<glm::vec3>();
+    centerOffset = reader.read<glm::vec3>();
+    rootNode = deserializeNodeTree(reader);
+
+    uint32_t offsetCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < offsetCount && !reader.isFailed(); ++i) {
+        std::string offsetName = reader.readString();
+        meshOffsetmap[offsetName] = reader.read<glm::mat4>();
+    }
+
+    uint32_t materialCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < materialCount && !reader.isFailed(); ++i) {
+        std::string materialName = reader.readString();
+        Material *material = new Material(assetManager, materialName, 0);
+        material->setAmbientColor(reader.read<glm::vec3>());
+        material->setDiffuseColor(reader.read<glm::vec3>());
+        material->setSpecularColor(reader.read<glm::vec3>());
+        material->setSpecularExponent(reader.read<float>());
+        MaterialTextures &textures = materialTextureNames[materialName];
+        textures.ambient = reader.readString();
+        textures.diffuse = reader.readString();
+        textures.specular = reader.readString();
+        textures.opacity = reader.readString();
+        materialMap[materialName] = material;
+    }
+
+    uint32_t meshCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < meshCount && !reader.isFailed(); ++i) {
+        std::string materialName = reader.readString();
+        bool isSimplified = reader.read<uint8_t>() != 0;
+        if (materialMap.find(materialName) == materialMap.end()) {
+            std::cerr << "Cooked model " << cookedFileName << " has a mesh with unknown material." << std::endl;
+            return false;
+        }
+        MeshAsset *mesh;
+        try {
+            mesh = new MeshAsset(assetManager, reader, materialMap[materialName], rootNode);
+        } catch (...) {
+            std::cerr << "Cooked model " << cookedFileName << " has corrupted mesh data." << std::endl;
+            return false;
+        }
+        if (isSimplified) {
+            simplifiedMeshes[mesh->getName()] = mesh;
+        } else {
+            meshes.push_back(mesh);
+        }
+    }
+
+    uint32_t animationCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < animationCount && !reader.isFailed(); ++i) {
+        std::string animationName = reader.readString();
+        animations[animationName] = new AnimationAssimp(reader);
+    }
+
+    if (reader.isFailed() || !reader.isAtEnd()) {
+        std::cerr << "Cooked model " << cookedFileName << " is corrupted, importing from source." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ModelAsset::clearCPUData() {
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        delete meshes[i];
+    }
+    meshes.clear();
+    for (auto it = simplifiedMeshes.begin(); it != simplifiedMeshes.end(); ++it) {
+        delete it->second;
+    }
+    simplifiedMeshes.clear();
+    for (auto it = materialMap.begin(); it != materialMap.end(); ++it) {
+        delete it->second;
+    }
+    materialMap.clear();
+    materialTextureNames.clear();
+    for (auto it = animations.begin(); it != animations.end(); ++it) {
+        delete it->second;
+    }
+    animations.clear();
+    meshOffsetmap.clear();
+    //FIXME bone nodes are not freed, same as destructor
+    rootNode = nullptr;
+    boneIDCounter = 0;
+    hasAnimation = false;
+}
+
+std::vector<std::vector<std::string>> ModelAsset::getTextureDependencies() const {
+    std::vector<std::vector<std::string>> dependencies;
+    for (auto textureIt = materialTextureNames.begin(); textureIt != materialTextureNames.end(); ++textureIt) {
+        const MaterialTextures &textures = textureIt->second;
+        if (!textures.ambient.empty()) {
+            dependencies.push_back({textures.ambient});
+        }
+        if (!textures.diffuse.empty()) {
+            dependencies.push_back({textures.diffuse});
+        }
+        if (!textures.specular.empty()) {
+            dependencies.push_back({textures.specular});
+        }
+        if (!textures.opacity.empty()) {
+            dependencies.push_back({textures.opacity});
+        }
+    }
+    return dependencies;
+}
+
+uint64_t ModelAsset::getCPUMemoryUsage() const {
+    uint64_t memoryUsage = 0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        memoryUsage += meshes[i]->getDataSize();
+    }
+    for (auto it = simplifiedMeshes.begin(); it != simplifiedMeshes.end(); ++it) {
+        memoryUsage += it->second->getDataSize();
+    }
+    return memoryUsage;
+}
+
+uint64_t ModelAsset::getGPUMemoryUsage() const {
+    uint64_t memoryUsage = 0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        memoryUsage += meshes[i]->getGPUDataSize();
+    }
+    for (auto it = simplifiedMeshes.begin(); it != simplifiedMeshes.end(); ++it) {
+        memoryUsage += it->second->getGPUDataSize();
+    }
+    return memoryUsage;
+}
+
 
 Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialIndex) {
     // create material uniform buffer
@@ -79,7 +501,9 @@ Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialI
     Material *newMaterial;
     if (materialMap.find(property.C_Str()) == materialMap.end()) {//search for the name
         //if the material is not loaded before
-        newMaterial = new Material(assetManager, property.C_Str(), assetManager->getGlHelper()->getNextMaterialIndex());
+        //material index is set on GPU part, this might be running on a loader thread
+        newMaterial = new Material(assetManager, property.C_Str(), 0);
+        MaterialTextures &textures = materialTextureNames[property.C_Str()];
         aiColor3D color(0.f, 0.f, 0.f);
         float transferFloat;
 
@@ -109,8 +533,7 @@ Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialI
 
         if ((currentMaterial->GetTextureCount(aiTextureType_AMBIENT) > 0)) {
             if (AI_SUCCESS == currentMaterial->GetTexture(aiTextureType_AMBIENT, 0, &property)) {
-                newMaterial->setAmbientTexture(property.C_Str());
-                std::cout << "set ambient texture " << property.C_Str() << std::endl;
+                textures.ambient = property.C_Str();
             } else {
                 std::cerr << "The model contained ambient texture information, but texture loading failed. \n" <<
                           "TextureAsset path: [" << property.C_Str() << "]" << std::endl;
@@ -118,8 +541,7 @@ Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialI
         }
         if ((currentMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)) {
             if (AI_SUCCESS == currentMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &property)) {
-                newMaterial->setDiffuseTexture(property.C_Str());
-                std::cout << "set diffuse texture " << property.C_Str() << std::endl;
+                textures.diffuse = property.C_Str();
             } else {
                 std::cerr << "The model contained diffuse texture information, but texture loading failed. \n" <<
                           "TextureAsset path: [" << property.C_Str() << "]" << std::endl;
@@ -128,8 +550,7 @@ Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialI
 
         if ((currentMaterial->GetTextureCount(aiTextureType_SPECULAR) > 0)) {
             if (AI_SUCCESS == currentMaterial->GetTexture(aiTextureType_SPECULAR, 0, &property)) {
-                newMaterial->setSpecularTexture(property.C_Str());
-                std::cout << "set specular texture " << property.C_Str() << std::endl;
+                textures.specular = property.C_Str();
             } else {
                 std::cerr << "The model contained specular texture information, but texture loading failed. \n" <<
                           "TextureAsset path: [" << property.C_Str() << "]" << std::endl;
@@ -138,31 +559,13 @@ Material *ModelAsset::loadMaterials(const aiScene *scene, unsigned int materialI
 
         if ((currentMaterial->GetTextureCount(aiTextureType_OPACITY) > 0)) {
             if (AI_SUCCESS == currentMaterial->GetTexture(aiTextureType_OPACITY, 0, &property)) {
-                newMaterial->setOpacityTexture(property.C_Str());
-                std::cout << "set opacity texture " << property.C_Str() << std::endl;
+                textures.opacity = property.C_Str();
             } else {
                 std::cerr << "The model contained opacity texture information, but texture loading failed. \n" <<
                           "TextureAsset path: [" << property.C_Str() << "]" << std::endl;
             }
         }
 
-        uint32_t maps = 0;
-        if(newMaterial->hasAmbientMap()) {
-            maps +=8;
-        }
-        if(newMaterial->hasDiffuseMap()) {
-            maps +=4;
-        }
-        if(newMaterial->hasSpecularMap()) {
-            maps +=2;
-        }
-        if(newMaterial->hasOpacityMap()) {
-            maps +=1;
-        }
-        newMaterial->setMaps(maps);
-
-        assetManager->getGlHelper()->setMaterial(newMaterial);
-
         materialMap[newMaterial->getName()] = newMaterial;
     } else {
         newMaterial = materialMap[property.C_Str()];
@@ -210,7 +613,7 @@ void ModelAsset::createMeshes(const aiScene *scene, aiNode *aiNode, glm::mat4 pa
                       << std::endl;
         } else {
 
-            if (meshMaterial->hasOpacityMap()) {
+            if (!materialTextureNames[meshMaterial->getName()].opacity.empty()) {
                 meshes.push_back(mesh);
             } else {
                 meshes.insert(meshes.begin(), mesh);
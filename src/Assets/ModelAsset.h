@@ -23,8 +23,28 @@
 
 
 class AnimationAssimp;
+class BinaryWriter;
+class BinaryReader;
 
 class ModelAsset : public Asset {
+    static const uint32_t COOKED_MAGIC = 0x4C444D4C;//"LMDL"
+    static const uint32_t COOKED_VERSION = 5;
+
+    /**
+     * Cooked file is invalidated if source file size or modification time changes, or it was cooked with different
+     * mesh processing options.
+     * Meshes keep float attributes for collision and batching, and the packed interleaved stream for GPU.
+     * Collision data is cooked as convex hull points of bones, static triangle meshes are made from the faces.
+     */
+    struct CookedFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        uint32_t meshLodCount;
+        uint32_t optimizeMeshes;
+    };
+
     std::string name;
     std::unordered_map<std::string, AnimationAssimp*> animations;//FIXME these should be removed
     BoneNode *rootNode;
@@ -35,6 +55,11 @@ class ModelAsset : public Asset {
     glm::vec3 centerOffset;
 
     std::unordered_map<std::string, Material *> materialMap;
+    //texture files of materials, textures are set on GPU part since they need GL
+    struct MaterialTextures {
+        std::string ambient, diffuse, specular, opacity;
+    };
+    std::unordered_map<std::string, MaterialTextures> materialTextureNames;
     std::vector<btConvexShape *> shapeCopies;
     std::vector<MeshAsset *> meshes;
     std::unordered_map<std::string, MeshAsset *> simplifiedMeshes;
@@ -43,8 +68,30 @@ class ModelAsset : public Asset {
 
     bool hasAnimation;
 
+    //texture arrays of ambient, diffuse, specular and opacity maps, 0 if not packed
+    uint32_t textureArrays[4] = {0, 0, 0, 0};
+
     Material *loadMaterials(const aiScene *scene, unsigned int materialIndex);
 
+    void loadFromSource();
+
+    bool loadFromCookedFile(const std::string &cookedFileName, const CookedFileHeader &expectedHeader);
+
+    bool writeCookedFile(const std::string &cookedFileName, const CookedFileHeader &header) const;
+
+    void serializeNodeTree(BinaryWriter &writer, const BoneNode *boneNode) const;
+
+    BoneNode *deserializeNodeTree(BinaryReader &reader);
+
+    /**
+     * Removes what is loaded by CPU part, used if cooked file turns out to be corrupted.
+     */
+    void clearCPUData();
+
+    void packTextureArrays();
+
+    void freeTextureArrays();
+
     void createMeshes(const aiScene *scene, aiNode *aiNode, glm::mat4 parentTransform);//parent transform is not reference on purpose
     //if it was, then we would need a stack
 
@@ -61,6 +108,23 @@ class ModelAsset : public Asset {
 public:
     ModelAsset(AssetManager *assetManager, uint32_t assetID, const std::vector<std::string> &fileList);
 
+    void loadCPUPart() override;
+
+    void loadGPUPart() override;
+
+    std::vector<std::vector<std::string>> getTextureDependencies() const override;
+
+    /**
+     * Textures are separate assets, so they are not included.
+     */
+    uint64_t getCPUMemoryUsage() const override;
+
+    uint64_t getGPUMemoryUsage() const override;
+
+    std::string getTypeName() const override {
+        return "Model";
+    }
+
     bool isAnimated() const;
 
     void getTransform(long time, std::string animationName, std::vector<glm::mat4> &transformMatrix) const; //this method takes vector to avoid copying it
@@ -76,6 +140,16 @@ public:
      */
     const std::unordered_map<std::string, Material *> &getMaterialMap() const { return materialMap; };
 
+    /**
+     * @param mapIndex 0 ambient, 1 diffuse, 2 specular, 3 opacity, same as material texture layers
+     * @return 0 if the map type is not packed
+     */
+    uint32_t getTextureArray(uint32_t mapIndex) const { return textureArrays[mapIndex]; }
+
+    bool hasTextureArrays() const {
+        return textureArrays[0] != 0 || textureArrays[1] != 0 || textureArrays[2] != 0 || textureArrays[3] != 0;
+    }
+
     ~ModelAsset() {
         std::cout << "Model asset deleted: " << name << std::endl;
         for (std::vector<MeshAsset *>::iterator iter = meshes.begin(); iter != meshes.end(); ++iter) {
@@ -90,14 +164,24 @@ public:
              iter != materialMap.end(); ++iter) {
             delete iter->second;
         }
-        //FIXME GPU side is not freed
-
+        freeTextureArrays();
     }
 
     std::vector<MeshAsset *> getMeshes() const {
         return meshes;
     }
 
+    /**
+     * Meshes might have different lod counts, this is the biggest one.
+     */
+    uint32_t getLodCount() const {
+        uint32_t lodCount = 1;
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            lodCount = std::max(lodCount, meshes[i]->getLodCount());
+        }
+        return lodCount;
+    }
+
     /**
      * This method checks if there is a simplified mesh with same name, and there is, adds simplified one instead of original.
      * @return hybrid of original and simplified meshes
@@ -3,6 +3,8 @@
 //
 
 #include "SoundAsset.h"
+#include "AssetManager.h"
+#include "../Options.h"
 #include "../../libs/dr_wav.h"
 
 #include <iostream>
@@ -20,6 +22,24 @@ SoundAsset::SoundAsset(AssetManager *assetManager, uint32_t assetID, const std::
         std::cerr << "multiple files are sent to Sound Asset constructor, extra elements ignored." << std::endl;
     }
 
+    uint64_t streamingThreshold = ((uint64_t) assetManager->getOptions()->getSoundStreamingThresholdKB()) * 1024;
+    if (mappedFile.open(name) && mappedFile.getSize() > streamingThreshold) {
+        //only the header is read here, samples are decoded while playing
+        drwav header;
+        if (drwav_init_memory(&header, mappedFile.getData(), mappedFile.getSize())) {
+            channels = header.channels;
+            sampleRate = header.sampleRate;
+            sampleCount = header.totalSampleCount;
+            drwav_uninit(&header);
+            streamed = true;
+            std::cout << "Sound asset " << this->name << " is streamed, " << mappedFile.getSize() / 1024 << " KB"
+                      << std::endl;
+            return;
+        }
+        std::cerr << "Wav header of " << this->name << " can't be read for streaming, decoding whole file." << std::endl;
+    }
+    mappedFile.close();
+
     soundData = drwav_open_and_read_file_s16(name.c_str(), &channels, &sampleRate, &sampleCount);
     if (soundData == nullptr) {
         // Error opening and reading WAV file.
@@ -31,4 +51,32 @@ SoundAsset::SoundAsset(AssetManager *assetManager, uint32_t assetID, const std::
 SoundAsset::~SoundAsset() {
     drwav_free(soundData);
     std::cout << "Sound asset " << this->name << " unloaded" << std::endl;
-}
\ No newline at end of file
+}
+
+SoundStream::SoundStream(const SoundAsset *asset) {
+    if (!asset->isStreamed()) {
+        return;
+    }
+    decoder = drwav_open_memory(asset->getMappedFile().getData(), asset->getMappedFile().getSize());
+    if (decoder == nullptr) {
+        std::cerr << "Sound stream decoder can't be opened." << std::endl;
+    }
+}
+
+SoundStream::~SoundStream() {
+    drwav_close(static_cast<drwav *>(decoder));
+}
+
+uint64_t SoundStream::read(int16_t *samples, uint64_t sampleCount) {
+    if (decoder == nullptr) {
+        return 0;
+    }
+    return drwav_read_s16(static_cast<drwav *>(decoder), sampleCount, samples);
+}
+
+bool SoundStream::rewind() {
+    if (decoder == nullptr) {
+        return false;
+    }
+    return drwav_seek_to_sample(static_cast<drwav *>(decoder), 0) != 0;
+}
@@ -7,6 +7,36 @@
 
 
 #include "Asset.h"
+#include "../Utils/MemoryMappedFile.h"
+
+class SoundAsset;
+
+/**
+ * Decoder for a playing instance of a streamed sound. Instances of the same asset share the mapped file,
+ * but each one has its own read position.
+ */
+class SoundStream {
+    void *decoder = nullptr;//drwav, kept opaque so dr_wav is only included by the implementation
+
+public:
+    explicit SoundStream(const SoundAsset *asset);
+
+    SoundStream(const SoundStream &) = delete;
+    SoundStream &operator=(const SoundStream &) = delete;
+
+    ~SoundStream();
+
+    bool isOpen() const {
+        return decoder != nullptr;
+    }
+
+    /**
+     * @return number of samples read, less than requested at the end of the sound
+     */
+    uint64_t read(int16_t *samples, uint64_t sampleCount);
+
+    bool rewind();
+};
 
 class SoundAsset : public Asset {
     unsigned int channels;
@@ -14,6 +44,9 @@ class SoundAsset : public Asset {
     uint64_t sampleCount;
     int16_t* soundData = nullptr; //PCM 16bit, prefer single channel
     std::string name;
+    //files bigger than streaming threshold are kept mapped, and decoded by SoundStream while playing
+    MemoryMappedFile mappedFile;
+    bool streamed = false;
 
 public:
 
@@ -32,9 +65,29 @@ public:
         return sampleCount;
     }
 
+    /**
+     * nullptr if the sound is streamed.
+     */
     const int16_t *getSoundData() const {
         return soundData;
     }
+
+    bool isStreamed() const {
+        return streamed;
+    }
+
+    const MemoryMappedFile &getMappedFile() const {
+        return mappedFile;
+    }
+
+    uint64_t getCPUMemoryUsage() const override {
+        //mapped file pages are managed by the OS
+        return streamed ? 0 : sampleCount * sizeof(int16_t);
+    }
+
+    std::string getTypeName() const override {
+        return "Sound";
+    }
 };
 
 
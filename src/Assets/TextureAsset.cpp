@@ -2,8 +2,30 @@
 // Created by Engin manap on 1.03.2016.
 //
 
+#include <cstring>
+#include <sys/stat.h>
+#include <SDL_timer.h>
 #include "TextureAsset.h"
 #include "../GLHelper.h"
+#include "../Options.h"
+#include "../Utils/BinaryStream.h"
+#include "TextureStreamer.h"
+
+const uint32_t TextureAsset::COOKED_MAGIC;
+const uint32_t TextureAsset::COOKED_VERSION;
+const uint32_t TextureAsset::streamingInitialSize;
+
+static GLenum getInternalFormat(TextureCompressor::Format format) {
+    switch (format) {
+        case TextureCompressor::Format::BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case TextureCompressor::Format::BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TextureCompressor::Format::BC5:
+        default:
+            return GL_COMPRESSED_RG_RGTC2;
+    }
+}
 
 TextureAsset::TextureAsset(AssetManager *assetManager, uint32_t assetID, const std::vector<std::string> &files) :
         Asset(assetManager, assetID, files) {
@@ -15,11 +37,62 @@ TextureAsset::TextureAsset(AssetManager *assetManager, uint32_t assetID, const s
     if (files.size() > 1) {
         std::cerr << "multiple files are sent to Texture constructor, extra elements ignored." << std::endl;
     }
+}
+
+void TextureAsset::loadCPUPart() {
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    bool isCompressionEnabled = assetManager->getOptions()->isUseCompressedTextures() &&
+                                assetManager->getGlHelper()->isTextureCompressionSupported();
+    if (!isCompressionEnabled) {
+        decodeSource();
+        cpuLoadMicroseconds = ((SDL_GetPerformanceCounter() - startTime) * 1000000) / SDL_GetPerformanceFrequency();
+        return;
+    }
+
+    std::string cookedFileName = name + ".limontexture";
+    CookedFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = COOKED_MAGIC;
+    header.version = COOKED_VERSION;
+    struct stat sourceStat;
+    bool isSourceFound = stat(name.c_str(), &sourceStat) == 0;
+    if (isSourceFound) {
+        header.sourceSize = (uint64_t) sourceStat.st_size;
+        header.sourceModifiedTime = (int64_t) sourceStat.st_mtime;
+    }
+
+    bool isStreamingEnabled = assetManager->getTextureStreamer() != nullptr;
+    if (!loadFromCookedFile(cookedFileName, header, isStreamingEnabled)) {
+        cookedFile.close();
+        compressedLevels.clear();
+        levelInfos.clear();
+        decodeSource();
+        compressSurface();
+        if (isSourceFound) {
+            if (!writeCookedFile(cookedFileName, header)) {
+                std::cerr << "Texture " << name << " couldn't be cooked, it will be compressed again on next load." << std::endl;
+            } else if (isStreamingEnabled) {
+                //streaming reads from cooked file, so switch to it
+                std::vector<TextureCompressor::MipLevel> allLevels;
+                allLevels.swap(compressedLevels);
+                if (!loadFromCookedFile(cookedFileName, header, true)) {
+                    cookedFile.close();
+                    compressedLevels.swap(allLevels);
+                    levelInfos.clear();
+                }
+            }
+        }
+    }
+    isStreamed = cookedFile.isOpen();
+    cpuLoadMicroseconds = ((SDL_GetPerformanceCounter() - startTime) * 1000000) / SDL_GetPerformanceFrequency();
+}
+
+void TextureAsset::decodeSource() {
     /**
      * FIXME: This takes full path, which is not acceptable,
      * we need to work with relative path to model for textures
      */
-    SDL_Surface *surface = IMG_Load(name.data());
+    surface = IMG_Load(name.data());
 
     if (!surface) {
         std::cerr << "TextureAsset Load from disk failed for " << name << ". Error:" << std::endl << IMG_GetError()
@@ -34,20 +107,18 @@ TextureAsset::TextureAsset(AssetManager *assetManager, uint32_t assetID, const s
             SDL_Surface* surfaceTemp = SDL_ConvertSurfaceFormat(surface,
                                                                 SDL_PIXELFORMAT_ABGR8888,
                                                                 0);
-            delete surface;
+            SDL_FreeSurface(surface);
             surface = surfaceTemp;
         }
-        textureBufferID = assetManager->getGlHelper()->loadTexture(surface->h, surface->w, GL_RGBA, surface->pixels);
     } else if (surface->format->BytesPerPixel == 3) {
         if(surface->format->format != SDL_PIXELFORMAT_RGB24) {
             //if the internal format is not rgb24, convert to it.
             SDL_Surface* surfaceTemp = SDL_ConvertSurfaceFormat(surface,
                                                                 SDL_PIXELFORMAT_RGB24,
                                                                 0);
-            delete surface;
+            SDL_FreeSurface(surface);
             surface = surfaceTemp;
         }
-        textureBufferID = assetManager->getGlHelper()->loadTexture(surface->h, surface->w, GL_RGB, surface->pixels);
     } else {
         std::cerr << "Format has undefined number of pixels:" << surface->format->BytesPerPixel << std::endl;
         exit(1);
@@ -55,11 +126,208 @@ TextureAsset::TextureAsset(AssetManager *assetManager, uint32_t assetID, const s
 
     this->height = surface->h;
     this->width = surface->w;
+}
+
+/**
+ * Converts surface to tightly packed RGBA, and compresses it. Surface is not needed after this.
+ */
+void TextureAsset::compressSurface() {
+    std::vector<uint8_t> rgbaPixels(width * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *row = static_cast<const uint8_t *>(surface->pixels) + y * surface->pitch;
+        if (surface->format->BytesPerPixel == 4) {
+            memcpy(rgbaPixels.data() + y * width * 4, row, width * 4);
+        } else {
+            for (uint32_t x = 0; x < width; ++x) {
+                memcpy(rgbaPixels.data() + (y * width + x) * 4, row + x * 3, 3);
+                rgbaPixels[(y * width + x) * 4 + 3] = 255;
+            }
+        }
+    }
+    SDL_FreeSurface(surface);
+    surface = nullptr;
+
+    if (TextureCompressor::hasTransparency(rgbaPixels.data(), width * height)) {
+        compressedFormat = TextureCompressor::Format::BC3;
+    } else {
+        compressedFormat = TextureCompressor::Format::BC1;
+    }
+    compressedLevels = TextureCompressor::compress(rgbaPixels.data(), width, height, compressedFormat);
+}
 
-    delete surface;
+bool TextureAsset::writeCookedFile(const std::string &cookedFileName, CookedFileHeader header) const {
+    header.format = (uint32_t) compressedFormat;
+    header.width = width;
+    header.height = height;
+    header.levelCount = compressedLevels.size();
+    BinaryWriter writer;
+    writer.write(header);
+    for (size_t i = 0; i < compressedLevels.size(); ++i) {
+        writer.write(compressedLevels[i].width);
+        writer.write(compressedLevels[i].height);
+        writer.writeVector(compressedLevels[i].data);
+    }
+    return writer.writeToFile(cookedFileName);
+}
+
+bool TextureAsset::loadFromCookedFile(const std::string &cookedFileName, const CookedFileHeader &expectedHeader,
+                                      bool isStreamingEnabled) {
+    if (!cookedFile.open(cookedFileName)) {
+        return false;
+    }
+    BinaryReader reader(cookedFile.getData(), cookedFile.getSize());
+    CookedFileHeader header = reader.read<CookedFileHeader>();
+    if (reader.isFailed() || header.magic != COOKED_MAGIC || header.version != COOKED_VERSION) {
+        std::cerr << "Cooked texture " << cookedFileName << " is not valid, compressing from source." << std::endl;
+        return false;
+    }
+    //if source is not shipped, cooked file is used as is
+    if (expectedHeader.sourceSize != 0 &&
+        (header.sourceSize != expectedHeader.sourceSize || header.sourceModifiedTime != expectedHeader.sourceModifiedTime)) {
+        std::cout << "Cooked texture " << cookedFileName << " is outdated, compressing from source." << std::endl;
+        return false;
+    }
+    if (header.format != (uint32_t) TextureCompressor::Format::BC1 &&
+        header.format != (uint32_t) TextureCompressor::Format::BC3 &&
+        header.format != (uint32_t) TextureCompressor::Format::BC5) {
+        std::cerr << "Cooked texture " << cookedFileName << " has unknown format, compressing from source." << std::endl;
+        return false;
+    }
+    compressedFormat = (TextureCompressor::Format) header.format;
+    uint32_t blockSize = TextureCompressor::getBlockSize(compressedFormat);
+
+    //when streaming, only the small levels are loaded now
+    uint32_t firstLevelToLoad = 0;
+    if (isStreamingEnabled) {
+        uint32_t levelWidth = header.width, levelHeight = header.height;
+        while (firstLevelToLoad + 1 < header.levelCount && std::max(levelWidth, levelHeight) > streamingInitialSize) {
+            levelWidth = std::max(1u, levelWidth / 2);
+            levelHeight = std::max(1u, levelHeight / 2);
+            firstLevelToLoad++;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.levelCount && !reader.isFailed(); ++i) {
+        LevelInfo levelInfo;
+        levelInfo.width = reader.read<uint32_t>();
+        levelInfo.height = reader.read<uint32_t>();
+        levelInfo.size = reader.read<uint32_t>();
+        levelInfo.offset = reader.getOffset();
+        if (levelInfo.size != ((levelInfo.width + 3) / 4) * ((levelInfo.height + 3) / 4) * blockSize) {
+            std::cerr << "Cooked texture " << cookedFileName << " has wrong level size, compressing from source." << std::endl;
+            return false;
+        }
+        if (i < firstLevelToLoad) {
+            reader.skipBytes(levelInfo.size);
+        } else {
+            TextureCompressor::MipLevel level;
+            level.width = levelInfo.width;
+            level.height = levelInfo.height;
+            level.data.resize(levelInfo.size);
+            reader.readBytes(level.data.data(), levelInfo.size);
+            compressedLevels.push_back(std::move(level));
+        }
+        levelInfos.push_back(levelInfo);
+    }
+    if (reader.isFailed() || !reader.isAtEnd() || compressedLevels.empty()) {
+        std::cerr << "Cooked texture " << cookedFileName << " is corrupted, compressing from source." << std::endl;
+        return false;
+    }
+    this->width = header.width;
+    this->height = header.height;
+    this->residentLevel = firstLevelToLoad;
+    this->initialLevel = firstLevelToLoad;
+    if (firstLevelToLoad == 0) {
+        //nothing to stream
+        cookedFile.close();
+    }
+    return true;
+}
+
+void TextureAsset::readLevel(uint32_t level, std::vector<uint8_t> &data) const {
+    data.assign(cookedFile.getData() + levelInfos[level].offset,
+                cookedFile.getData() + levelInfos[level].offset + levelInfos[level].size);
+}
+
+void TextureAsset::addResidentLevel(uint32_t level, const std::vector<uint8_t> &data) {
+    if (level + 1 != residentLevel || data.size() != levelInfos[level].size) {
+        std::cerr << "Texture " << name << " streamed level " << level << " is not next to resident level, ignored." << std::endl;
+        return;
+    }
+    assetManager->getGlHelper()->loadCompressedTextureLevel(textureBufferID, levelInfos[level].height,
+                                                            levelInfos[level].width,
+                                                            getInternalFormat(compressedFormat), level,
+                                                            data.data(), data.size());
+    residentLevel = level;
+    gpuMemoryUsage += data.size();
+}
+
+void TextureAsset::dropResidentLevels(uint32_t firstLevel) {
+    if (firstLevel <= residentLevel || firstLevel >= levelInfos.size()) {
+        std::cerr << "Texture " << name << " can't drop levels before " << firstLevel << ", ignored." << std::endl;
+        return;
+    }
+    assetManager->getGlHelper()->dropCompressedTextureLevels(textureBufferID, residentLevel, firstLevel);
+    for (uint32_t level = residentLevel; level < firstLevel; ++level) {
+        gpuMemoryUsage -= levelInfos[level].size;
+    }
+    residentLevel = firstLevel;
+}
+
+void TextureAsset::loadGPUPart() {
+    Uint64 startTime = SDL_GetPerformanceCounter();
+    //mip chain adds a third of the base level
+    uint64_t uncompressedMemoryUsage = ((uint64_t) width * height * 4 * 4) / 3;
+    if (!compressedLevels.empty()) {
+        glInternalFormat = getInternalFormat(compressedFormat);
+        std::vector<const void *> levelData(compressedLevels.size());
+        std::vector<uint32_t> levelSizes(compressedLevels.size());
+        gpuMemoryUsage = 0;
+        for (size_t i = 0; i < compressedLevels.size(); ++i) {
+            levelData[i] = compressedLevels[i].data.data();
+            levelSizes[i] = compressedLevels[i].data.size();
+            gpuMemoryUsage += compressedLevels[i].data.size();
+        }
+        textureBufferID = assetManager->getGlHelper()->loadCompressedTexture(compressedLevels[0].height,
+                                                                             compressedLevels[0].width,
+                                                                             glInternalFormat,
+                                                                             residentLevel, compressedLevels.size(),
+                                                                             levelData.data(), levelSizes.data());
+        std::vector<TextureCompressor::MipLevel>().swap(compressedLevels);
+        if (isStreamed) {
+            assetManager->getTextureStreamer()->addTexture(this);
+        }
+        std::cout << "Texture " << name << " uses " << gpuMemoryUsage / 1024 << " KB video memory, "
+                  << uncompressedMemoryUsage / 1024 << " KB uncompressed. Load took " << cpuLoadMicroseconds / 1000
+                  << " ms, upload took " << ((SDL_GetPerformanceCounter() - startTime) * 1000000) / SDL_GetPerformanceFrequency()
+                  << " us." << std::endl;
+        return;
+    }
+    glInternalFormat = GL_RGBA8;
+    if (surface->format->BytesPerPixel == 4) {
+        textureBufferID = assetManager->getGlHelper()->loadTexture(surface->h, surface->w, GL_RGBA, surface->pixels);
+    } else {
+        textureBufferID = assetManager->getGlHelper()->loadTexture(surface->h, surface->w, GL_RGB, surface->pixels);
+    }
+    SDL_FreeSurface(surface);
+    surface = nullptr;
+    gpuMemoryUsage = uncompressedMemoryUsage;
+    std::cout << "Texture " << name << " uses " << gpuMemoryUsage / 1024 << " KB video memory. Load took "
+              << cpuLoadMicroseconds / 1000 << " ms, upload took "
+              << ((SDL_GetPerformanceCounter() - startTime) * 1000000) / SDL_GetPerformanceFrequency() << " us." << std::endl;
 }
 
 TextureAsset::~TextureAsset() {
-    assetManager->getGlHelper()->deleteTexture(textureBufferID);
+    if (isStreamed && textureBufferID != 0) {
+        //streamer might be reading from the mapped file
+        assetManager->getTextureStreamer()->removeTexture(this);
+    }
+    if (surface != nullptr) {
+        //loaded but never uploaded
+        SDL_FreeSurface(surface);
+    }
+    if (textureBufferID != 0) {
+        assetManager->getGlHelper()->deleteTexture(textureBufferID);
+    }
     std::cout << "Texture asset deleted: " << name << std::endl;
-}
\ No newline at end of file
+}
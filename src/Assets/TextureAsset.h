@@ -10,17 +10,75 @@
 #include <SDL2/SDL_image.h>
 #include "Asset.h"
 #include "AssetManager.h"
+#include "../Utils/TextureCompressor.h"
+#include "../Utils/MemoryMappedFile.h"
 
+/**
+ * If compressed textures are enabled and supported, source image is block compressed with its mips once, and written
+ * next to the source. Later loads use the compressed file, and upload the levels directly.
+ *
+ * If texture streaming is enabled, only the levels smaller than streamingInitialSize are loaded, and the compressed
+ * file is kept mapped. TextureStreamer reads higher levels from it when they are needed, and drops them when not.
+ */
 class TextureAsset : public Asset {
+    static const uint32_t COOKED_MAGIC = 0x5845544C;//"LTEX"
+    static const uint32_t COOKED_VERSION = 1;
+
+    struct CookedFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+    };
+
+    struct LevelInfo {
+        uint32_t width;
+        uint32_t height;
+        size_t offset;//in cooked file
+        size_t size;
+    };
+
+    static const uint32_t streamingInitialSize = 64;
+
+    TextureCompressor::Format compressedFormat = TextureCompressor::Format::BC1;
+    std::vector<TextureCompressor::MipLevel> compressedLevels;//kept between CPU and GPU parts
+    uint64_t gpuMemoryUsage = 0;
+    uint64_t cpuLoadMicroseconds = 0;
+    uint32_t glInternalFormat = 0;
+
+    MemoryMappedFile cookedFile;//only kept open if texture is streamed
+    std::vector<LevelInfo> levelInfos;
+    uint32_t residentLevel = 0;//highest detail level that is on GPU
+    uint32_t initialLevel = 0;//levels starting from this are never streamed out
+    bool isStreamed = false;
+
+    void decodeSource();
+
+    void compressSurface();
+
+    bool loadFromCookedFile(const std::string &cookedFileName, const CookedFileHeader &expectedHeader,
+                            bool isStreamingEnabled);
+
+    bool writeCookedFile(const std::string &cookedFileName, CookedFileHeader header) const;
+
 protected:
     std::string name;
-    uint32_t textureBufferID;
+    uint32_t textureBufferID = 0;
     uint32_t height = 0;
     uint32_t width;
+    SDL_Surface *surface = nullptr;//decoded image, kept between CPU and GPU parts
 
 public:
     TextureAsset(AssetManager *assetManager, uint32_t assetID, const std::vector<std::string> &files);
 
+    void loadCPUPart() override;
+
+    void loadGPUPart() override;
+
     ~TextureAsset();
 
     uint32_t getID() const {
@@ -38,6 +96,58 @@ public:
     uint32_t getWidth() const {
         return width;
     }
+
+    uint64_t getGPUMemoryUsage() const override {
+        return gpuMemoryUsage;
+    }
+
+    std::string getTypeName() const override {
+        return "Texture";
+    }
+
+    /**
+     * Sized internal format of the texture, textures with same format and size can be packed to a texture array.
+     */
+    uint32_t getGLInternalFormat() const {
+        return glInternalFormat;
+    }
+
+    /*** Streaming methods, only valid if isStreamed returns true ***/
+
+    bool isStreamedTexture() const {
+        return isStreamed;
+    }
+
+    uint32_t getLevelCount() const {
+        return levelInfos.size();
+    }
+
+    uint32_t getResidentLevel() const {
+        return residentLevel;
+    }
+
+    uint32_t getInitialLevel() const {
+        return initialLevel;
+    }
+
+    uint64_t getLevelSize(uint32_t level) const {
+        return levelInfos[level].size;
+    }
+
+    /**
+     * Copies level data from mapped file, can be called from any thread.
+     */
+    void readLevel(uint32_t level, std::vector<uint8_t> &data) const;
+
+    /**
+     * Uploads one level higher than resident level.
+     */
+    void addResidentLevel(uint32_t level, const std::vector<uint8_t> &data);
+
+    /**
+     * Drops resident levels before first level. Texture ID doesn't change.
+     */
+    void dropResidentLevels(uint32_t firstLevel);
 };
 
 #endif //LIMONENGINE_TEXTURE_H
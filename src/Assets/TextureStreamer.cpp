@@ -0,0 +1,243 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "TextureStreamer.h"
+#include "TextureAsset.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+
+TextureStreamer::TextureStreamer(uint64_t memoryBudget) : memoryBudget(memoryBudget) {
+    jobMutex = SDL_CreateMutex();
+    jobCondition = SDL_CreateCond();
+    streamingThread = SDL_CreateThread(&staticStreamingWorker, "textureStreamer", this);
+    if (streamingThread == nullptr) {
+        std::cerr << "Texture streaming thread creation failed, levels will be read on main thread. " << SDL_GetError() << std::endl;
+    }
+}
+
+TextureStreamer::~TextureStreamer() {
+    if (streamingThread != nullptr) {
+        SDL_LockMutex(jobMutex);
+        stopStreaming = true;
+        SDL_CondBroadcast(jobCondition);
+        SDL_UnlockMutex(jobMutex);
+        SDL_WaitThread(streamingThread, nullptr);
+    }
+    for (size_t i = 0; i < pendingJobs.size(); ++i) {
+        delete pendingJobs[i];
+    }
+    for (size_t i = 0; i < completedJobs.size(); ++i) {
+        delete completedJobs[i];
+    }
+    SDL_DestroyCond(jobCondition);
+    SDL_DestroyMutex(jobMutex);
+}
+
+void TextureStreamer::printStats() const {
+    std::cout << "Texture streaming: " << streamedInCount << " levels streamed in, " << evictionCount << " evictions, "
+              << residentMemory / (1024 * 1024) << " MB resident." << std::endl;
+}
+
+int TextureStreamer::staticStreamingWorker(void *textureStreamer) {
+    static_cast<TextureStreamer *>(textureStreamer)->streamingWorker();
+    return 0;
+}
+
+void TextureStreamer::streamingWorker() {
+    SDL_LockMutex(jobMutex);
+    while (true) {
+        while (!stopStreaming && pendingJobs.empty()) {
+            SDL_CondWait(jobCondition, jobMutex);
+        }
+        if (stopStreaming) {
+            break;
+        }
+        activeJob = pendingJobs.front();
+        pendingJobs.pop_front();
+        SDL_UnlockMutex(jobMutex);
+
+        readJobData(activeJob);
+
+        SDL_LockMutex(jobMutex);
+        completedJobs.push_back(activeJob);
+        activeJob = nullptr;
+        //removeTexture might be waiting for this job
+        SDL_CondBroadcast(jobCondition);
+    }
+    SDL_UnlockMutex(jobMutex);
+}
+
+void TextureStreamer::readJobData(StreamJob *job) {
+    job->texture->readLevel(job->firstLevel, job->levelData);
+}
+
+void TextureStreamer::addTexture(TextureAsset *texture) {
+    StreamingTexture &streamingTexture = textures[texture];
+    streamingTexture.requestedLevel = std::numeric_limits<uint32_t>::max();
+    streamingTexture.wantedLevel = texture->getInitialLevel();
+    streamingTexture.lastRequestFrame = frameCount;
+    streamingTexture.lastNeededFrame = frameCount;
+    residentMemory += texture->getGPUMemoryUsage();
+}
+
+void TextureStreamer::removeTexture(TextureAsset *texture) {
+    auto textureIt = textures.find(texture);
+    if (textureIt == textures.end()) {
+        return;
+    }
+    SDL_LockMutex(jobMutex);
+    while (activeJob != nullptr && activeJob->texture == texture) {
+        SDL_CondWait(jobCondition, jobMutex);
+    }
+    for (std::deque<StreamJob *> *jobList : {&pendingJobs, &completedJobs}) {
+        for (auto jobIt = jobList->begin(); jobIt != jobList->end();) {
+            if ((*jobIt)->texture == texture) {
+                reservedMemory -= (*jobIt)->reservedMemory;
+                pendingJobCount--;
+                delete *jobIt;
+                jobIt = jobList->erase(jobIt);
+            } else {
+                ++jobIt;
+            }
+        }
+    }
+    SDL_UnlockMutex(jobMutex);
+    residentMemory -= texture->getGPUMemoryUsage();
+    textures.erase(textureIt);
+}
+
+void TextureStreamer::requestSize(TextureAsset *texture, float projectedSize) {
+    auto textureIt = textures.find(texture);
+    if (textureIt == textures.end()) {
+        return;
+    }
+    uint32_t levelCount = texture->getLevelCount();
+    uint32_t level = levelCount - 1;
+    if (projectedSize >= 1.0f) {
+        //one texel per pixel is enough
+        float ratio = std::max(texture->getWidth(), texture->getHeight()) / projectedSize;
+        level = ratio <= 1.0f ? 0 : std::min(levelCount - 1, (uint32_t) std::log2(ratio));
+    }
+    textureIt->second.requestedLevel = std::min(textureIt->second.requestedLevel, level);
+}
+
+void TextureStreamer::addJob(TextureAsset *texture, uint32_t firstLevel) {
+    StreamJob *job = new StreamJob();
+    job->texture = texture;
+    job->firstLevel = firstLevel;
+    job->reservedMemory = texture->getLevelSize(firstLevel);
+    reservedMemory += job->reservedMemory;
+    textures[texture].isJobPending = true;
+    pendingJobCount++;
+
+    SDL_LockMutex(jobMutex);
+    if (streamingThread == nullptr) {
+        readJobData(job);
+        completedJobs.push_back(job);
+    } else {
+        pendingJobs.push_back(job);
+        SDL_CondSignal(jobCondition);
+    }
+    SDL_UnlockMutex(jobMutex);
+}
+
+void TextureStreamer::applyCompletedJobs() {
+    std::deque<StreamJob *> jobs;
+    SDL_LockMutex(jobMutex);
+    jobs.swap(completedJobs);
+    SDL_UnlockMutex(jobMutex);
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        StreamJob *job = jobs[i];
+        uint64_t memoryBefore = job->texture->getGPUMemoryUsage();
+        job->texture->addResidentLevel(job->firstLevel, job->levelData);
+        streamedInCount++;
+        residentMemory = residentMemory - memoryBefore + job->texture->getGPUMemoryUsage();
+        reservedMemory -= job->reservedMemory;
+        textures[job->texture].isJobPending = false;
+        pendingJobCount--;
+        delete job;
+    }
+}
+
+void TextureStreamer::dropLevels(TextureAsset *texture, uint32_t firstLevel) {
+    uint64_t memoryBefore = texture->getGPUMemoryUsage();
+    texture->dropResidentLevels(firstLevel);
+    residentMemory = residentMemory - memoryBefore + texture->getGPUMemoryUsage();
+    evictionCount++;
+}
+
+/**
+ * Drops extra levels of the texture that was not requested for the longest time.
+ * @return false if there is no texture to evict
+ */
+bool TextureStreamer::evictLeastRecentlyUsed(TextureAsset *requestingTexture) {
+    TextureAsset *oldestTexture = nullptr;
+    uint64_t oldestFrame = frameCount;
+    for (auto textureIt = textures.begin(); textureIt != textures.end(); ++textureIt) {
+        if (textureIt->first == requestingTexture || textureIt->second.isJobPending ||
+            textureIt->first->getResidentLevel() >= textureIt->first->getInitialLevel()) {
+            continue;
+        }
+        if (textureIt->second.lastRequestFrame < oldestFrame) {
+            oldestFrame = textureIt->second.lastRequestFrame;
+            oldestTexture = textureIt->first;
+        }
+    }
+    if (oldestTexture == nullptr) {
+        return false;
+    }
+    uint32_t newLevel = std::max(textures[oldestTexture].wantedLevel, oldestTexture->getResidentLevel() + 1);
+    dropLevels(oldestTexture, std::min(newLevel, oldestTexture->getInitialLevel()));
+    return true;
+}
+
+void TextureStreamer::update() {
+    frameCount++;
+    applyCompletedJobs();
+
+    std::vector<std::pair<uint32_t, TextureAsset *>> streamInCandidates;
+    for (auto textureIt = textures.begin(); textureIt != textures.end(); ++textureIt) {
+        TextureAsset *texture = textureIt->first;
+        StreamingTexture &streamingTexture = textureIt->second;
+        if (streamingTexture.requestedLevel != std::numeric_limits<uint32_t>::max()) {
+            streamingTexture.wantedLevel = std::min(streamingTexture.requestedLevel, texture->getInitialLevel());
+            streamingTexture.lastRequestFrame = frameCount;
+            streamingTexture.requestedLevel = std::numeric_limits<uint32_t>::max();
+        } else if (frameCount - streamingTexture.lastRequestFrame > evictionDelayFrames) {
+            streamingTexture.wantedLevel = texture->getInitialLevel();
+        }
+        if (streamingTexture.wantedLevel <= texture->getResidentLevel()) {
+            streamingTexture.lastNeededFrame = frameCount;
+        }
+        if (streamingTexture.isJobPending) {
+            continue;
+        }
+        if (streamingTexture.wantedLevel < texture->getResidentLevel()) {
+            streamInCandidates.push_back(std::make_pair(texture->getResidentLevel() - streamingTexture.wantedLevel, texture));
+        } else if (streamingTexture.wantedLevel > texture->getResidentLevel() &&
+                   frameCount - streamingTexture.lastNeededFrame > evictionDelayFrames) {
+            dropLevels(texture, streamingTexture.wantedLevel);
+        }
+    }
+
+    //textures that are furthest from what they need first
+    std::sort(streamInCandidates.begin(), streamInCandidates.end(),
+              [](const std::pair<uint32_t, TextureAsset *> &first, const std::pair<uint32_t, TextureAsset *> &second) {
+                  return first.first > second.first;
+              });
+    for (size_t i = 0; i < streamInCandidates.size() && pendingJobCount < maximumPendingJobs; ++i) {
+        TextureAsset *texture = streamInCandidates[i].second;
+        uint32_t level = texture->getResidentLevel() - 1;
+        if (residentMemory + reservedMemory + texture->getLevelSize(level) > memoryBudget) {
+            //one texture is evicted per frame, this texture waits for the next frames if it still doesn't fit
+            evictLeastRecentlyUsed(texture);
+            break;
+        }
+        addJob(texture, level);
+    }
+}
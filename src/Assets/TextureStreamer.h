@@ -0,0 +1,111 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_TEXTURESTREAMER_H
+#define LIMONENGINE_TEXTURESTREAMER_H
+
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <SDL_thread.h>
+
+class TextureAsset;
+
+/**
+ * Streams mip levels of compressed textures in and out, depending on how big they are on screen.
+ *
+ * World requests the size of the rendered objects in pixels each frame. Update picks the level each texture needs,
+ * streams in one level at a time for the textures that need more detail, and drops levels of the textures that
+ * didn't need them for evictionDelayFrames. Reading level data is done on a background thread, GL work is done on
+ * main thread by update. Dropping levels doesn't need any data, so it is done by update directly.
+ *
+ * Total size of streamed textures is kept under memory budget. If a level doesn't fit, the texture that was not
+ * requested for the longest time drops its extra levels.
+ */
+class TextureStreamer {
+    struct StreamingTexture {
+        uint32_t requestedLevel;//this frames request
+        uint32_t wantedLevel;
+        uint64_t lastRequestFrame = 0;
+        uint64_t lastNeededFrame = 0;//last frame that resident level was needed
+        bool isJobPending = false;
+    };
+
+    struct StreamJob {
+        TextureAsset *texture;
+        uint32_t firstLevel;
+        uint64_t reservedMemory;//jobs reserve budget until they are applied
+        std::vector<uint8_t> levelData;
+    };
+
+    std::unordered_map<TextureAsset *, StreamingTexture> textures;
+    uint64_t memoryBudget;
+    uint64_t residentMemory = 0;
+    uint64_t reservedMemory = 0;
+    uint64_t frameCount = 0;
+    uint32_t evictionDelayFrames = 120;
+    uint32_t maximumPendingJobs = 4;
+    uint32_t pendingJobCount = 0;
+
+    uint64_t streamedInCount = 0;
+    uint64_t evictionCount = 0;
+
+    SDL_Thread *streamingThread = nullptr;
+    SDL_mutex *jobMutex;
+    SDL_cond *jobCondition;
+    std::deque<StreamJob *> pendingJobs;
+    std::deque<StreamJob *> completedJobs;
+    StreamJob *activeJob = nullptr;
+    bool stopStreaming = false;
+
+    static int staticStreamingWorker(void *textureStreamer);
+
+    void streamingWorker();
+
+    static void readJobData(StreamJob *job);
+
+    void addJob(TextureAsset *texture, uint32_t firstLevel);
+
+    void dropLevels(TextureAsset *texture, uint32_t firstLevel);
+
+    void applyCompletedJobs();
+
+    bool evictLeastRecentlyUsed(TextureAsset *requestingTexture);
+
+public:
+    explicit TextureStreamer(uint64_t memoryBudget);
+
+    ~TextureStreamer();
+
+    void addTexture(TextureAsset *texture);
+
+    /**
+     * Blocks if the streaming thread is reading this texture.
+     */
+    void removeTexture(TextureAsset *texture);
+
+    /**
+     * @param projectedSize size of the object using the texture on screen, in pixels
+     */
+    void requestSize(TextureAsset *texture, float projectedSize);
+
+    /**
+     * Must be called from main thread, once per frame.
+     */
+    void update();
+
+    uint64_t getResidentMemory() const {
+        return residentMemory;
+    }
+
+    /**
+     * Removed textures release their memory, so this should be called before they are freed.
+     */
+    void printStats() const;
+};
+
+
+#endif //LIMONENGINE_TEXTURESTREAMER_H
@@ -2,6 +2,8 @@
 // Created by Engin Manap on 10.02.2016.
 //
 
+#include <cstddef>
+
 #include "GLHelper.h"
 #include "GLSLProgram.h"
 
@@ -284,7 +286,15 @@ GLHelper::GLHelper(Options *options): options(options) {
         sprintf(extensionNameBuffer, "%s", glGetStringi(GL_EXTENSIONS, i));
         if(std::strcmp(extensionNameBuffer, "GL_ARB_texture_cube_map_array") == 0) {
             isCubeMapArraySupported = true;
-            break;
+        }
+        if(std::strcmp(extensionNameBuffer, "GL_EXT_texture_compression_s3tc") == 0) {
+            textureCompressionSupported = true;
+        }
+        if(std::strcmp(extensionNameBuffer, "GL_ARB_copy_image") == 0) {
+            copyImageSupported = true;
+        }
+        if(std::strcmp(extensionNameBuffer, "GL_ARB_texture_storage") == 0) {
+            textureStorageSupported = true;
         }
     }
     if(!isCubeMapArraySupported) {
@@ -293,12 +303,16 @@ GLHelper::GLHelper(Options *options): options(options) {
     }
 
     std::cout << "Cubemap array support is present. " << std::endl;
+    if(!textureCompressionSupported) {
+        std::cout << "S3TC texture compression is not supported, textures will be uploaded uncompressed." << std::endl;
+    }
 
     GLint uniformBufferAlignSize = 0;
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignSize);
 
-    if(uniformBufferAlignSize > materialUniformSize) {
-        materialUniformSize = uniformBufferAlignSize;
+    if(uniformBufferAlignSize > 0) {
+        //each material is bound by offset, so size should be a multiple of alignment
+        materialUniformSize = ((materialUniformSize + uniformBufferAlignSize - 1) / uniformBufferAlignSize) * uniformBufferAlignSize;
     }
 
 
@@ -437,7 +451,7 @@ GLuint GLHelper::generateVAO(const GLuint number) {
 }
 
 bool GLHelper::deleteVAO(const GLuint number, const GLuint bufferID) {
-    if (glIsBuffer(bufferID)) {
+    if (glIsVertexArray(bufferID)) {
         glDeleteVertexArrays(number, &bufferID);
         checkErrors("deleteVAO");
         return true;
@@ -449,7 +463,7 @@ bool GLHelper::deleteVAO(const GLuint number, const GLuint bufferID) {
 bool GLHelper::freeVAO(const GLuint bufferID) {
     for (unsigned int i = 0; i < vertexArrays.size(); ++i) {
         if (vertexArrays[i] == bufferID) {
-            deleteBuffer(1, vertexArrays[i]);
+            deleteVAO(1, vertexArrays[i]);
             vertexArrays[i] = vertexArrays[vertexArrays.size() - 1];
             vertexArrays.pop_back();
             checkErrors("freeVAO");
@@ -550,6 +564,71 @@ void GLHelper::bufferVertexTextureCoordinates(const std::vector<glm::vec2> &text
     checkErrors("bufferVertexTextureCoordinates");
 }
 
+uint_fast32_t GLHelper::bufferIndexData(const std::vector<glm::mediump_uvec3> &faces, GLenum indexType) {
+    uint_fast32_t ebo = generateBuffer(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    if (indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(faces.size() * 3);
+        for (size_t i = 0; i < faces.size(); ++i) {
+            shortIndices[i * 3] = (uint16_t) faces[i][0];
+            shortIndices[i * 3 + 1] = (uint16_t) faces[i][1];
+            shortIndices[i * 3 + 2] = (uint16_t) faces[i][2];
+        }
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(),
+                     GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(glm::mediump_uvec3), faces.data(), GL_STATIC_DRAW);
+    }
+    checkErrors("bufferIndexData");
+    return ebo;
+}
+
+GLenum GLHelper::bufferPackedVertexData(const std::vector<VertexQuantizer::PackedVertex> &vertices,
+                                        const std::vector<VertexQuantizer::PackedSkinnedVertex> &skinnedVertices,
+                                        const std::vector<glm::mediump_uvec3> &faces,
+                                        uint_fast32_t &vao, uint_fast32_t &vbo, uint_fast32_t &ebo) {
+    bool isSkinned = !skinnedVertices.empty();
+    size_t vertexCount = isSkinned ? skinnedVertices.size() : vertices.size();
+    GLenum indexType = vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    ebo = bufferIndexData(faces, indexType);
+
+    vao = generateVAO(1);
+    glBindVertexArray(vao);
+    vbo = generateBuffer(1);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    GLsizei stride;
+    if (isSkinned) {
+        stride = sizeof(VertexQuantizer::PackedSkinnedVertex);
+        glBufferData(GL_ARRAY_BUFFER, skinnedVertices.size() * stride, skinnedVertices.data(), GL_STATIC_DRAW);
+    } else {
+        stride = sizeof(VertexQuantizer::PackedVertex);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * stride, vertices.data(), GL_STATIC_DRAW);
+    }
+
+    glVertexAttribPointer(2, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                          (void *) offsetof(VertexQuantizer::PackedVertex, position));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                          (void *) offsetof(VertexQuantizer::PackedVertex, textureCoordinate));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(4, 2, GL_SHORT, GL_TRUE, stride,
+                          (void *) offsetof(VertexQuantizer::PackedVertex, normal));
+    glEnableVertexAttribArray(4);
+    if (isSkinned) {
+        glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride,
+                               (void *) offsetof(VertexQuantizer::PackedSkinnedVertex, boneIDs));
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              (void *) offsetof(VertexQuantizer::PackedSkinnedVertex, boneWeights));
+        glEnableVertexAttribArray(6);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    checkErrors("bufferPackedVertexData");
+    return indexType;
+}
+
 void GLHelper::switchRenderToShadowMapDirectional(const unsigned int index) {
     glViewport(0, 0, options->getShadowMapDirectionalWidth(), options->getShadowMapDirectionalHeight());
     glBindFramebuffer(GL_FRAMEBUFFER, depthOnlyFrameBufferDirectional);
@@ -584,7 +663,8 @@ void GLHelper::switchRenderToDefault() {
     checkErrors("switchRenderToDefault");
 }
 
-void GLHelper::render(const GLuint program, const GLuint vao, const GLuint ebo, const GLuint elementCount) {
+void GLHelper::render(const GLuint program, const GLuint vao, const GLuint ebo, const GLuint elementCount,
+                      GLenum indexType) {
     if (program == 0) {
         std::cerr << "No program render requested." << std::endl;
         return;
@@ -596,7 +676,7 @@ void GLHelper::render(const GLuint program, const GLuint vao, const GLuint ebo,
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
     renderTriangleCount = renderTriangleCount + elementCount;
-    glDrawElements(GL_TRIANGLES, elementCount, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(GL_TRIANGLES, elementCount, indexType, nullptr);
     glBindVertexArray(0);
     //state->setProgram(0);
 
@@ -604,7 +684,7 @@ void GLHelper::render(const GLuint program, const GLuint vao, const GLuint ebo,
 }
 
 void GLHelper::renderInstanced(GLuint program, uint_fast32_t VAO, uint_fast32_t EBO, uint_fast32_t triangleCount,
-                               uint32_t instanceCount) {
+                               uint32_t instanceCount, GLenum indexType) {
     if (program == 0) {
         std::cerr << "No program render requested." << std::endl;
         return;
@@ -616,7 +696,7 @@ void GLHelper::renderInstanced(GLuint program, uint_fast32_t VAO, uint_fast32_t
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 
     renderTriangleCount = renderTriangleCount + (triangleCount * instanceCount);
-    glDrawElementsInstanced(GL_TRIANGLES, triangleCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+    glDrawElementsInstanced(GL_TRIANGLES, triangleCount, indexType, nullptr, instanceCount);
     glBindVertexArray(0);
     //state->setProgram(0);
 
@@ -728,26 +808,114 @@ GLuint GLHelper::loadTexture(int height, int width, GLenum format, void *data) {
     state->activateTextureUnit(0);//this is the default working texture
     glBindTexture(GL_TEXTURE_2D, texture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    setTextureParameters(GL_TEXTURE_2D);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkErrors("loadTexture");
+    return texture;
+}
+
+/**
+ * Uploads precomputed mip levels, levels are expected to be halving down to 1x1. Height and width are of firstLevel,
+ * levels before first level can be added later by loadCompressedTextureLevel.
+ */
+GLuint GLHelper::loadCompressedTexture(int height, int width, GLenum internalFormat, uint32_t firstLevel, uint32_t levelCount,
+                                       const void *const *levelData, const uint32_t *levelSizes) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    state->activateTextureUnit(0);//this is the default working texture
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, firstLevel + i, internalFormat, width, height, 0, levelSizes[i], levelData[i]);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, firstLevel + levelCount - 1);
+    setTextureParameters(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkErrors("loadCompressedTexture");
+    return texture;
+}
+
+void GLHelper::loadCompressedTextureLevel(GLuint textureID, int height, int width, GLenum internalFormat, uint32_t level,
+                                          const void *data, uint32_t dataSize) {
+    state->activateTextureUnit(0);//this is the default working texture
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0, dataSize, data);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkErrors("loadCompressedTextureLevel");
+}
+
+/**
+ * Texture keeps its ID, so attached textures stay valid. Levels before new first level are respecified as empty to
+ * free their memory, they are below base level so texture stays complete.
+ */
+void GLHelper::dropCompressedTextureLevels(GLuint textureID, uint32_t firstLevel, uint32_t newFirstLevel) {
+    state->activateTextureUnit(0);//this is the default working texture
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, newFirstLevel);
+    for (uint32_t level = firstLevel; level < newFirstLevel; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    checkErrors("dropCompressedTextureLevels");
+}
+
+GLuint GLHelper::createTextureArray(const std::vector<GLuint> &textureIDs, int height, int width, GLenum internalFormat) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (!isTextureArrayPackingSupported() || textureIDs.empty() || textureIDs.size() > (size_t) maxLayers) {
+        return 0;
+    }
+    GLsizei levelCount = 1;
+    while ((std::max(width, height) >> levelCount) > 0) {
+        levelCount++;
+    }
+    GLuint textureArray;
+    glGenTextures(1, &textureArray);
+    state->activateTextureUnit(0);//this is the default working texture
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levelCount, internalFormat, width, height, textureIDs.size());
+    setTextureParameters(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    for (size_t layer = 0; layer < textureIDs.size(); ++layer) {
+        for (GLsizei level = 0; level < levelCount; ++level) {
+            glCopyImageSubData(textureIDs[layer], GL_TEXTURE_2D, level, 0, 0, 0,
+                               textureArray, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+                               std::max(1, width >> level), std::max(1, height >> level), 1);
+        }
+    }
+    if (checkErrors("createTextureArray")) {
+        glDeleteTextures(1, &textureArray);
+        return 0;
+    }
+    return textureArray;
+}
+
+void GLHelper::attachTextureArray(unsigned int textureArrayID, unsigned int attachPoint) {
+    state->attach2DTextureArray(textureArrayID, attachPoint);
+    checkErrors("attachTextureArray");
+}
+
+void GLHelper::setTextureParameters(GLenum target) {
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     switch (options->getTextureFiltering()) {
         case Options::TextureFilteringModes::NEAREST:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
             break;
         case Options::TextureFilteringModes::BILINEAR:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             break;
         case Options::TextureFilteringModes::TRILINEAR:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             break;
     }
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    checkErrors("loadTexture");
-    return texture;
 }
 
 void GLHelper::attachTexture(unsigned int textureID, unsigned int attachPoint) {
@@ -763,6 +931,7 @@ void GLHelper::attachCubeMap(unsigned int cubeMapID, unsigned int attachPoint) {
 bool GLHelper::deleteTexture(GLuint textureID) {
     if (glIsTexture(textureID)) {
         glDeleteTextures(1, &textureID);
+        state->removeTexture(textureID);
         checkErrors("deleteTexture");
         return true;
     } else {
@@ -908,6 +1077,7 @@ void GLHelper::setMaterial(const Material* material) {
             float shininess;
             vec3 diffuse;
             int isMap;
+            ivec4 textureLayers;
     } material;
     */
     float shininess = material->getSpecularExponent();
@@ -922,6 +1092,8 @@ void GLHelper::setMaterial(const Material* material) {
                     sizeof(glm::vec3), glm::value_ptr(material->getDiffuseColor()));
     glBufferSubData(GL_UNIFORM_BUFFER, material->getMaterialIndex() * materialUniformSize + 2 *sizeof(glm::vec3) + sizeof(GLfloat),
                     sizeof(GLint), &maps);
+    glBufferSubData(GL_UNIFORM_BUFFER, material->getMaterialIndex() * materialUniformSize + 2 *sizeof(glm::vec3) + sizeof(GLfloat) + sizeof(GLint),
+                    sizeof(glm::ivec4), glm::value_ptr(material->getTextureLayers()));
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     checkErrors("setMaterial");
 }
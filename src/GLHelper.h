@@ -31,6 +31,7 @@
 #define NR_MAX_MATERIALS 2000
 
 #include "Options.h"
+#include "Utils/VertexQuantizer.h"
 class Material;
 
 class Light;
@@ -57,6 +58,7 @@ class GLHelper {
         unsigned int activeProgram;
         unsigned int activeTextureUnit;
         unsigned int *textures;
+        GLint textureUnitCount;
 
         void attachTexture(GLuint textureID, GLuint textureUnit, GLenum type) {
             if (textures[textureUnit] != textureID) {
@@ -69,7 +71,7 @@ class GLHelper {
     public:
         uint32_t programChangeCount=0;
 
-        explicit OpenglState(GLint textureUnitCount) : activeProgram(0) {
+        explicit OpenglState(GLint textureUnitCount) : activeProgram(0), textureUnitCount(textureUnitCount) {
             textures = new unsigned int[textureUnitCount];
             memset(textures, 0, textureUnitCount * sizeof(int));
             activeTextureUnit = 0;
@@ -100,6 +102,17 @@ class GLHelper {
             attachTexture(textureID, textureUnit, GL_TEXTURE_CUBE_MAP_ARRAY_ARB);
         }
 
+        /**
+         * GL reuses names of deleted textures, so a new texture with the same ID must not be considered attached.
+         */
+        void removeTexture(GLuint textureID) {
+            for (GLint i = 0; i < textureUnitCount; ++i) {
+                if (textures[i] == textureID) {
+                    textures[i] = 0;
+                }
+            }
+        }
+
 
         void setProgram(GLuint program) {
             if (program != this->activeProgram) {
@@ -200,7 +213,7 @@ private:
 
     const uint_fast32_t lightUniformSize = (sizeof(glm::mat4) * 7) + (2 * sizeof(glm::vec4));
     const uint32_t playerUniformSize = 3 * sizeof(glm::mat4) + sizeof(glm::vec4);
-    int32_t materialUniformSize = 2 * sizeof(glm::vec3) + sizeof(float) + sizeof(GLuint);
+    int32_t materialUniformSize = 2 * sizeof(glm::vec3) + sizeof(float) + sizeof(GLuint) + sizeof(glm::ivec4);
     int32_t modelUniformSize = sizeof(glm::mat4);
 
     glm::mat4 cameraMatrix;
@@ -212,6 +225,9 @@ private:
     uint32_t renderTriangleCount;
     uint32_t renderLineCount;
     uint32_t uniformSetCount=0;
+    bool textureCompressionSupported = false;
+    bool copyImageSupported = false;
+    bool textureStorageSupported = false;
 
 
 public:
@@ -262,6 +278,8 @@ private:
     void fillUniformMap(const GLuint program, std::unordered_map<std::string, Uniform *> &uniformMap) const;
 
     void attachGeneralUBOs(const GLuint program);
+
+    void setTextureParameters(GLenum target);
     void bufferExtraVertexData(uint_fast32_t elementPerVertexCount, GLenum elementType, uint_fast32_t dataSize,
                                const void *extraData, uint_fast32_t &vao, uint_fast32_t &vbo,
                                const uint_fast32_t attachPointer);
@@ -298,6 +316,23 @@ public:
     void bufferVertexTextureCoordinates(const std::vector<glm::vec2> &textureCoordinates,
                                         uint_fast32_t &vao, uint_fast32_t &vbo, const uint_fast32_t attachPointer);
 
+    /**
+     * @param indexType GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, faces are converted if short
+     */
+    uint_fast32_t bufferIndexData(const std::vector<glm::mediump_uvec3> &faces, GLenum indexType);
+
+    /**
+     * Creates vao with a single interleaved buffer. Attributes are position 2, texture coordinate 3, normal 4,
+     * and if skinned vertices are sent, bone IDs 5 and bone weights 6.
+     *
+     * @param skinnedVertices if not empty, vertices is ignored
+     * @return index type of the element buffer, 16 bit indices are used if vertex count allows
+     */
+    GLenum bufferPackedVertexData(const std::vector<VertexQuantizer::PackedVertex> &vertices,
+                                const std::vector<VertexQuantizer::PackedSkinnedVertex> &skinnedVertices,
+                                const std::vector<glm::mediump_uvec3> &faces,
+                                uint_fast32_t &vao, uint_fast32_t &vbo, uint_fast32_t &ebo);
+
     bool freeBuffer(const GLuint bufferID);
 
     bool freeVAO(const GLuint VAO);
@@ -321,12 +356,41 @@ public:
         uniformSetCount = 0;
     }
 
-    void render(const GLuint program, const GLuint vao, const GLuint ebo, const GLuint elementCount);
+    void render(const GLuint program, const GLuint vao, const GLuint ebo, const GLuint elementCount,
+                GLenum indexType = GL_UNSIGNED_INT);
 
     void reshape();
 
     GLuint loadTexture(int height, int width, GLenum format, void *data);
 
+    GLuint loadCompressedTexture(int height, int width, GLenum internalFormat, uint32_t firstLevel, uint32_t levelCount,
+                                 const void *const *levelData, const uint32_t *levelSizes);
+
+    void dropCompressedTextureLevels(GLuint textureID, uint32_t firstLevel, uint32_t newFirstLevel);
+
+    void loadCompressedTextureLevel(GLuint textureID, int height, int width, GLenum internalFormat, uint32_t level,
+                                    const void *data, uint32_t dataSize);
+
+    /**
+     * Set on initialization and never changed, so it is safe to read from loader threads.
+     */
+    bool isTextureCompressionSupported() const {
+        return textureCompressionSupported;
+    }
+
+    bool isTextureArrayPackingSupported() const {
+        return copyImageSupported && textureStorageSupported;
+    }
+
+    /**
+     * Copies all levels of given textures to layers of a new texture array, in the given order.
+     * Textures must have the same size, sized internal format and full mip chain.
+     * @return 0 if textures can't be packed
+     */
+    GLuint createTextureArray(const std::vector<GLuint> &textureIDs, int height, int width, GLenum internalFormat);
+
+    void attachTextureArray(unsigned int textureArrayID, unsigned int attachPoint);
+
     GLuint loadCubeMap(int height, int width, void *right, void *left, void *top, void *bottom, void *back,
                        void *front);
 
@@ -408,7 +472,7 @@ public:
     void attachModelIndicesUBO(const uint32_t programID);
 
     void renderInstanced(GLuint program, uint_fast32_t VAO, uint_fast32_t EBO, uint_fast32_t triangleCount,
-                         uint32_t instanceCount);
+                         uint32_t instanceCount, GLenum indexType = GL_UNSIGNED_INT);
 };
 
 #endif //LIMONENGINE_GLHELPER_H
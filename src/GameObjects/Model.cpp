@@ -4,6 +4,7 @@
 
 #include "Model.h"
 #include "../AI/Actor.h"
+#include "../Assets/TextureStreamer.h"
 
 Model::Model(uint32_t objectID, AssetManager *assetManager, const float mass, const std::string &modelFile,
              bool disconnected = false) :
@@ -102,7 +103,7 @@ Model::Model(uint32_t objectID, AssetManager *assetManager, const float mass, co
         }
     }
 
-    btDefaultMotionState *initialMotionState = new btDefaultMotionState(
+    PhysicalRenderableMotionState *initialMotionState = new PhysicalRenderableMotionState(this,
             btTransform(btQuaternion(0, 0, 0, 1), GLMConverter::GLMToBlt(centerOffset)));
 
     btVector3 fallInertia(0, 0, 0);
@@ -145,11 +146,15 @@ void Model::setupForTime(long time) {
     lastSetupTime = time;
 }
 
+/**
+ * Maps that are packed to texture arrays are skipped, they are bound once per model by activateTextureArrays.
+ */
 void Model::activateTexturesOnly(const Material *material) {
-    if(material->hasDiffuseMap()) {
+    const glm::ivec4 &textureLayers = material->getTextureLayers();
+    if(material->hasDiffuseMap() && textureLayers.y < 0) {
         glHelper->attachTexture(material->getDiffuseTexture()->getID(), diffuseMapAttachPoint);
     }
-    if(material->hasAmbientMap()) {
+    if(material->hasAmbientMap() && textureLayers.x < 0) {
         glHelper->attachTexture(material->getAmbientTexture()->getID(), ambientMapAttachPoint);
     }
 
@@ -157,11 +162,45 @@ void Model::activateTexturesOnly(const Material *material) {
         glHelper->attachTexture(material->getSpecularTexture()->getID(), specularMapAttachPoint);
     }
 
-    if(material->hasOpacityMap()) {
+    if(material->hasOpacityMap() && textureLayers.w < 0) {
         glHelper->attachTexture(material->getOpacityTexture()->getID(), opacityMapAttachPoint);
     }
 }
 
+void Model::activateTextureArrays() {
+    if (modelAsset->getTextureArray(0) != 0) {
+        glHelper->attachTextureArray(modelAsset->getTextureArray(0), ambientArrayAttachPoint);
+    }
+    if (modelAsset->getTextureArray(1) != 0) {
+        glHelper->attachTextureArray(modelAsset->getTextureArray(1), diffuseArrayAttachPoint);
+    }
+    if (modelAsset->getTextureArray(3) != 0) {
+        glHelper->attachTextureArray(modelAsset->getTextureArray(3), opacityArrayAttachPoint);
+    }
+}
+
+void Model::requestTextureLevels(TextureStreamer *textureStreamer, float projectedSize) const {
+    for (auto iter = meshMetaData.begin(); iter != meshMetaData.end(); ++iter) {
+        requestMaterialTextureLevels(textureStreamer, (*iter)->mesh->getMaterial(), projectedSize);
+    }
+}
+
+void Model::requestMaterialTextureLevels(TextureStreamer *textureStreamer, const Material *material,
+                                         float projectedSize) {
+    if (material->hasDiffuseMap()) {
+        textureStreamer->requestSize(material->getDiffuseTexture(), projectedSize);
+    }
+    if (material->hasAmbientMap()) {
+        textureStreamer->requestSize(material->getAmbientTexture(), projectedSize);
+    }
+    if (material->hasSpecularMap()) {
+        textureStreamer->requestSize(material->getSpecularTexture(), projectedSize);
+    }
+    if (material->hasOpacityMap()) {
+        textureStreamer->requestSize(material->getOpacityTexture(), projectedSize);
+    }
+}
+
 void Model::setSamplersAndUBOs(GLSLProgram *program) {
     if (!program->setUniform("diffuseSampler", diffuseMapAttachPoint)) {
         std::cerr << "Uniform \"diffuseSampler\" could not be set" << std::endl;
@@ -175,6 +214,15 @@ void Model::setSamplersAndUBOs(GLSLProgram *program) {
     if (!program->setUniform("opacitySampler", opacityMapAttachPoint)) {
         std::cerr << "Uniform \"opacitySampler\" could not be set" << std::endl;
     }
+    if (!program->setUniform("ambientArraySampler", ambientArrayAttachPoint)) {
+        std::cerr << "Uniform \"ambientArraySampler\" could not be set" << std::endl;
+    }
+    if (!program->setUniform("diffuseArraySampler", diffuseArrayAttachPoint)) {
+        std::cerr << "Uniform \"diffuseArraySampler\" could not be set" << std::endl;
+    }
+    if (!program->setUniform("opacityArraySampler", opacityArrayAttachPoint)) {
+        std::cerr << "Uniform \"opacityArraySampler\" could not be set" << std::endl;
+    }
     //TODO we should support multi texture on one pass
 
     if (!program->setUniform("shadowSamplerDirectional", glHelper->getMaxTextureImageUnits() - 1)) {
@@ -197,6 +245,8 @@ bool Model::setupRenderVariables(MeshMeta *meshMetaData) {
         std::cerr << "No material setup, passing rendering. " << std::endl;
         return false;
     }
+    program->setUniform("positionOffset", meshMetaData->mesh->getPositionOffset());
+    program->setUniform("positionScale", meshMetaData->mesh->getPositionScale());
 
     if (animated) {
         //set all of the bones to unitTransform for testing
@@ -209,13 +259,16 @@ void Model::render() {
     for (std::vector<MeshMeta *>::iterator iter = meshMetaData.begin(); iter != meshMetaData.end(); ++iter) {
         if (setupRenderVariables((*iter))) {
             glHelper->render((*iter)->program->getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(),
-                             (*iter)->mesh->getTriangleCount() * 3);
+                             (*iter)->mesh->getTriangleCount() * 3, (*iter)->mesh->getIndexType());
         }
     }
 }
 
-void Model::renderInstanced(std::vector<uint32_t> &modelIndices) {
+void Model::renderInstanced(std::vector<uint32_t> &modelIndices, uint32_t lod) {
     glHelper->setModelIndexesUBO(modelIndices);
+    if (modelAsset->hasTextureArrays()) {
+        activateTextureArrays();
+    }
     for (std::vector<MeshMeta *>::iterator iter = meshMetaData.begin(); iter != meshMetaData.end(); ++iter) {
         MeshMeta* meshMetaData = *iter;
 
@@ -224,8 +277,8 @@ void Model::renderInstanced(std::vector<uint32_t> &modelIndices) {
         if (meshMetaData->mesh != nullptr && meshMetaData->mesh->getMaterial() != nullptr) {
             this->activateTexturesOnly(meshMetaData->mesh->getMaterial());
 
-            glHelper->renderInstanced((*iter)->program->getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(),
-                             (*iter)->mesh->getTriangleCount() * 3, modelIndices.size());
+            glHelper->renderInstanced((*iter)->program->getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(lod),
+                             (*iter)->mesh->getTriangleCount(lod) * 3, modelIndices.size(), (*iter)->mesh->getIndexType());
         }
     }
 }
@@ -245,11 +298,14 @@ void Model::renderWithProgram(GLSLProgram &program) {
         if(program.IsMaterialRequired()) {
             glHelper->attachMaterialUBO(program.getID(), (*iter)->mesh->getMaterial()->getMaterialIndex());
         }
-        glHelper->render(program.getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(), (*iter)->mesh->getTriangleCount() * 3);
+        program.setUniform("positionOffset", (*iter)->mesh->getPositionOffset());
+        program.setUniform("positionScale", (*iter)->mesh->getPositionScale());
+        glHelper->render(program.getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(), (*iter)->mesh->getTriangleCount() * 3,
+                         (*iter)->mesh->getIndexType());
     }
 }
 
-void Model::renderWithProgramInstanced(std::vector<uint32_t> &modelIndices, GLSLProgram &program) {
+void Model::renderWithProgramInstanced(std::vector<uint32_t> &modelIndices, GLSLProgram &program, uint32_t lod) {
     glHelper->setModelIndexesUBO(modelIndices);
 
     glHelper->attachModelUBO(program.getID());
@@ -265,7 +321,10 @@ void Model::renderWithProgramInstanced(std::vector<uint32_t> &modelIndices, GLSL
         if(program.IsMaterialRequired()) {
             glHelper->attachMaterialUBO(program.getID(), (*iter)->mesh->getMaterial()->getMaterialIndex());
         }
-        glHelper->renderInstanced(program.getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(), (*iter)->mesh->getTriangleCount() * 3, modelIndices.size());
+        program.setUniform("positionOffset", (*iter)->mesh->getPositionOffset());
+        program.setUniform("positionScale", (*iter)->mesh->getPositionScale());
+        glHelper->renderInstanced(program.getID(), (*iter)->mesh->getVao(), (*iter)->mesh->getEbo(lod), (*iter)->mesh->getTriangleCount(lod) * 3, modelIndices.size(),
+                                  (*iter)->mesh->getIndexType());
     }
 }
 
@@ -20,6 +20,7 @@
 #include "Sound.h"
 
 class Actor;
+class TextureStreamer;
 
 class Model : public PhysicalRenderable, public GameObject {
     uint32_t objectID;
@@ -49,7 +50,13 @@ class Model : public PhysicalRenderable, public GameObject {
     int ambientMapAttachPoint = 2;
     int specularMapAttachPoint = 3;
     int opacityMapAttachPoint = 4;
+    //texture arrays need their own units, since sampler types can't share a unit
+    int ambientArrayAttachPoint = 5;
+    int diffuseArrayAttachPoint = 6;
+    int opacityArrayAttachPoint = 7;
     uint_fast32_t triangleCount;
+    bool staticBatched = false;
+    bool movedAfterBatching = false;
 
 public:
     Model(uint32_t objectID, AssetManager *assetManager, const std::string &modelFile) : Model(objectID, assetManager,
@@ -63,6 +70,10 @@ public:
     void transformChangeCallback() {
         PhysicalRenderable::updatePhysicsFromTransform();
         glHelper->setModel(this->getWorldObjectID(), this->transformation.getWorldTransform());
+        if (staticBatched) {
+            //batch has the old transform baked, world should render this model by itself
+            movedAfterBatching = true;
+        }
     }
 
     void updateTransformFromPhysics() override {
@@ -73,6 +84,8 @@ public:
     void setSamplersAndUBOs(GLSLProgram *program);
     void activateTexturesOnly(const Material *material);
 
+    void activateTextureArrays();
+
     bool setupRenderVariables(MeshMeta *meshMetaData);
 
     void setupForTime(long time);
@@ -81,9 +94,48 @@ public:
 
     void renderWithProgram(GLSLProgram &program);
 
-    void renderInstanced(std::vector<uint32_t> &modelIndices);
+    /**
+     * @param lod level of detail for all meshes, meshes with less levels use their lowest detail
+     */
+    void renderInstanced(std::vector<uint32_t> &modelIndices, uint32_t lod = 0);
+
+    void renderWithProgramInstanced(std::vector<uint32_t> &modelIndices, GLSLProgram &program, uint32_t lod = 0);
+
+    uint32_t getLodCount() const {
+        return modelAsset->getLodCount();
+    }
+
+    /**
+     * Requests the texture levels needed to render this model with given size on screen, in pixels.
+     */
+    void requestTextureLevels(TextureStreamer *textureStreamer, float projectedSize) const;
+
+    static void requestMaterialTextureLevels(TextureStreamer *textureStreamer, const Material *material,
+                                             float projectedSize);
+
+    std::vector<MeshAsset *> getMeshes() const {
+        return modelAsset->getMeshes();
+    }
+
+    /**
+     * Meshes are in the same order as getMeshes.
+     */
+    GLSLProgram *getMeshProgram(uint32_t meshIndex) const {
+        return meshMetaData[meshIndex]->program;
+    }
 
-    void renderWithProgramInstanced(std::vector<uint32_t> &modelIndices, GLSLProgram &program);
+    bool hasTextureArrays() const {
+        return modelAsset->hasTextureArrays();
+    }
+
+    void setStaticBatched(bool staticBatched) {
+        this->staticBatched = staticBatched;
+        this->movedAfterBatching = false;
+    }
+
+    bool isStaticBatched() const { return staticBatched; }
+
+    bool isMovedAfterBatching() const { return movedAfterBatching; }
 
     bool isAnimated() const { return animated;}
 
@@ -128,6 +180,10 @@ public:
         return name + "_" + std::to_string(objectID);
     };
 
+    const std::string &getModelFileName() const {
+        return name;
+    }
+
     ImGuiResult addImGuiEditorElements(const ImGuiRequest &request);
     /************Game Object methods **************/
 
@@ -226,4 +226,18 @@ std::vector<LimonAPI::ParameterRequest> TriggerObject::getResultOfCode(uint32_t
     return std::vector<LimonAPI::ParameterRequest>();
 }
 
-
+void TriggerObject::getTargetWorldFiles(std::vector<std::string> &worldFiles) const {
+    const TriggerInterface *triggerCodes[3] = {firstEnterTriggerCode, enterTriggerCode, exitTriggerCode};
+    const std::vector<LimonAPI::ParameterRequest> *triggerParameters[3] = {&firstEnterParameters, &enterParameters,
+                                                                           &exitParameters};
+    for (size_t i = 0; i < 3; ++i) {
+        if (triggerCodes[i] == nullptr || triggerCodes[i]->getName() != "ChangeWorldOnTrigger" ||
+            triggerParameters[i]->empty()) {
+            continue;
+        }
+        std::string worldFile = (*triggerParameters[i])[0].value.stringValue;
+        if (!worldFile.empty()) {
+            worldFiles.push_back(worldFile);
+        }
+    }
+}
@@ -31,6 +31,7 @@ class TriggerObject : public GameObject {
 
     bool triggered = false;
     bool inside = false;
+    uint32_t playerOverlapCount = 0;
     bool enabledAny = false;
     bool enabledFirstTrigger = false;
     bool enabledEnterTrigger = false;
@@ -83,7 +84,23 @@ public:
     void render(BulletDebugDrawer *debugDrawer);
 
 
-    bool checkAndTrigger() {
+    /**
+     * Called by World when broadphase reports the player started or stopped overlapping this trigger.
+     * Player might have more than one pair with the trigger, so transitions are decided by overlap count.
+     *
+     * @param entered true if a pair is added, false if removed
+     * @return result of the trigger code run, false if nothing run
+     */
+    bool playerOverlapChanged(bool entered) {
+        if(entered) {
+            playerOverlapCount++;
+        } else if(playerOverlapCount > 0) {
+            playerOverlapCount--;
+        }
+        return checkAndTrigger(playerOverlapCount > 0);
+    }
+
+    bool checkAndTrigger(bool playerFound) {
         if(!enabledAny) {
             return false;
         }
@@ -91,15 +108,6 @@ public:
         if(enterTriggerCode == nullptr && exitTriggerCode == nullptr && triggered) {
             return false;// first trigger done, and no other triggers found
         }
-        bool playerFound = false;
-        //Bullet collision callbacks are global, and since player is suppose to collide with world all the time, it doesn't make sense to use them
-        for(int i = 0; i < ghostObject->getNumOverlappingObjects(); i++ ) {
-            btCollisionObject* object = ghostObject->getOverlappingPairs().at(i);
-            if(object->getUserPointer() != nullptr && static_cast<GameObject*>(object->getUserPointer())->getTypeID() == GameObject::PLAYER) {
-                playerFound = true;
-                break;
-            }
-        }
 
         /**
          * now decide what to do. 4 options
@@ -154,6 +162,11 @@ public:
     static TriggerObject *deserialize(tinyxml2::XMLElement *triggerNode, LimonAPI *limonAPI);
 
     std::vector<LimonAPI::ParameterRequest> getResultOfCode(uint32_t codeID);
+
+    /**
+     * Adds world files this trigger can switch to, using ChangeWorldOnTrigger parameters.
+     */
+    void getTargetWorldFiles(std::vector<std::string> &worldFiles) const;
 };
 
 
@@ -0,0 +1,35 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "TriggerPairCallback.h"
+#include "GameObject.h"
+
+void TriggerPairCallback::recordEventIfTrigger(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1, bool entered) {
+    btCollisionObject* object0 = static_cast<btCollisionObject*>(proxy0->m_clientObject);
+    btCollisionObject* object1 = static_cast<btCollisionObject*>(proxy1->m_clientObject);
+    if(object0->getUserPointer() == nullptr || object1->getUserPointer() == nullptr) {
+        return;//AI grid ghost object has no game object, it is not a trigger or player
+    }
+    GameObject* gameObject0 = static_cast<GameObject*>(object0->getUserPointer());
+    GameObject* gameObject1 = static_cast<GameObject*>(object1->getUserPointer());
+
+    if(gameObject0->getTypeID() == GameObject::TRIGGER && gameObject1->getTypeID() == GameObject::PLAYER) {
+        triggerEvents.push_back(TriggerEvent(gameObject0->getWorldObjectID(), entered));
+    } else if(gameObject1->getTypeID() == GameObject::TRIGGER && gameObject0->getTypeID() == GameObject::PLAYER) {
+        triggerEvents.push_back(TriggerEvent(gameObject1->getWorldObjectID(), entered));
+    }
+}
+
+btBroadphasePair *TriggerPairCallback::addOverlappingPair(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1) {
+    btBroadphasePair* pair = btGhostPairCallback::addOverlappingPair(proxy0, proxy1);
+    recordEventIfTrigger(proxy0, proxy1, true);
+    return pair;
+}
+
+void *TriggerPairCallback::removeOverlappingPair(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1,
+                                                 btDispatcher *dispatcher) {
+    void* result = btGhostPairCallback::removeOverlappingPair(proxy0, proxy1, dispatcher);
+    recordEventIfTrigger(proxy0, proxy1, false);
+    return result;
+}
@@ -0,0 +1,50 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_TRIGGERPAIRCALLBACK_H
+#define LIMONENGINE_TRIGGERPAIRCALLBACK_H
+
+#include <vector>
+#include <cstdint>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+
+/**
+ * Ghost pair callback that also records player enter/exit transitions of trigger volumes.
+ *
+ * Broadphase calls this only when a pair is created or destroyed, so triggers cost nothing
+ * while player is not near them. Events are queued, and processed by World once per tick.
+ */
+class TriggerPairCallback : public btGhostPairCallback {
+public:
+    struct TriggerEvent {
+        uint32_t triggerID;
+        bool entered;
+
+        TriggerEvent(uint32_t triggerID, bool entered) : triggerID(triggerID), entered(entered) {}
+    };
+
+private:
+    std::vector<TriggerEvent> triggerEvents;
+
+    void recordEventIfTrigger(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1, bool entered);
+
+public:
+    btBroadphasePair *addOverlappingPair(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1) override;
+
+    void *removeOverlappingPair(btBroadphaseProxy *proxy0, btBroadphaseProxy *proxy1, btDispatcher *dispatcher) override;
+
+    /**
+     * Moves queued events to given vector. Trigger codes can add or remove collision objects while
+     * they run, so events must be consumed from a copy, not from the queue itself.
+     *
+     * @param events vector to fill, its old content is discarded
+     */
+    void swapTriggerEvents(std::vector<TriggerEvent> &events) {
+        events.clear();
+        events.swap(triggerEvents);
+    }
+};
+
+
+#endif //LIMONENGINE_TRIGGERPAIRCALLBACK_H
@@ -26,6 +26,8 @@ private:
     float refractionIndex;
 
     TextureAsset *ambientTexture = nullptr, *diffuseTexture = nullptr, *specularTexture = nullptr, *opacityTexture = nullptr;
+    //layers of ambient, diffuse, specular and opacity maps in the texture arrays of model, -1 if not packed
+    glm::ivec4 textureLayers = glm::ivec4(-1, -1, -1, -1);
 
 public:
     Material(AssetManager *assetManager, const std::string &name, uint32_t materialIndex, float specularExponent, const glm::vec3 &ambientColor,
@@ -52,6 +54,10 @@ public:
         return materialIndex;
     }
 
+    void setMaterialIndex(uint32_t materialIndex) {
+        this->materialIndex = materialIndex;
+    }
+
     float getSpecularExponent() const {
         return specularExponent;
     }
@@ -164,6 +170,14 @@ public:
         return isOpacityMap;
     }
 
+    const glm::ivec4 &getTextureLayers() const {
+        return textureLayers;
+    }
+
+    void setTextureLayers(const glm::ivec4 &textureLayers) {
+        this->textureLayers = textureLayers;
+    }
+
     void setMaps(uint32_t maps) {
         this->maps = maps;
     }
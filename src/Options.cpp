@@ -107,6 +107,219 @@ bool Options::loadOptions(const std::string &optionsFileName) {
         debugDrawBufferSize = std::stoul(debugDrawBufferSizeNode->GetText());
     }
 
+    tinyxml2::XMLElement *raycastThreadCountNode = optionsNode->FirstChildElement("raycastThreadCount");
+    if (raycastThreadCountNode != nullptr) {
+        raycastThreadCount = std::stoul(raycastThreadCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *aiGridGenerationThreadCountNode = optionsNode->FirstChildElement("aiGridGenerationThreadCount");
+    if (aiGridGenerationThreadCountNode != nullptr) {
+        aiGridGenerationThreadCount = std::stoul(aiGridGenerationThreadCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *pathRequestBudgetNode = optionsNode->FirstChildElement("pathRequestBudgetMicroseconds");
+    if (pathRequestBudgetNode != nullptr) {
+        pathRequestBudgetMicroseconds = std::stoul(pathRequestBudgetNode->GetText());
+    }
+
+    tinyxml2::XMLElement *printPathSearchStatsNode = optionsNode->FirstChildElement("printPathSearchStats");
+    if (printPathSearchStatsNode != nullptr) {
+        std::string printPathSearchStatsText = printPathSearchStatsNode->GetText();
+        if (printPathSearchStatsText == "True") {
+            printPathSearchStats = true;
+        } else if (printPathSearchStatsText == "False") {
+            printPathSearchStats = false;
+        } else {
+            std::cerr << "printPathSearchStats value is unknown, defaulting to False" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *crowdSimulationThreadCountNode = optionsNode->FirstChildElement("crowdSimulationThreadCount");
+    if (crowdSimulationThreadCountNode != nullptr) {
+        crowdSimulationThreadCount = std::stoul(crowdSimulationThreadCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *assetLoaderThreadCountNode = optionsNode->FirstChildElement("assetLoaderThreadCount");
+    if (assetLoaderThreadCountNode != nullptr) {
+        assetLoaderThreadCount = std::stoul(assetLoaderThreadCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *assetUploadBudgetNode = optionsNode->FirstChildElement("assetUploadBudgetMicroseconds");
+    if (assetUploadBudgetNode != nullptr) {
+        assetUploadBudgetMicroseconds = std::stoul(assetUploadBudgetNode->GetText());
+    }
+
+    tinyxml2::XMLElement *useCookedModelsNode = optionsNode->FirstChildElement("useCookedModels");
+    if (useCookedModelsNode != nullptr) {
+        std::string useCookedModelsText = useCookedModelsNode->GetText();
+        if (useCookedModelsText == "True") {
+            useCookedModels = true;
+        } else if (useCookedModelsText == "False") {
+            useCookedModels = false;
+        } else {
+            std::cerr << "useCookedModels value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *optimizeMeshesNode = optionsNode->FirstChildElement("optimizeMeshes");
+    if (optimizeMeshesNode != nullptr) {
+        std::string optimizeMeshesText = optimizeMeshesNode->GetText();
+        if (optimizeMeshesText == "True") {
+            optimizeMeshes = true;
+        } else if (optimizeMeshesText == "False") {
+            optimizeMeshes = false;
+        } else {
+            std::cerr << "optimizeMeshes value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *meshLodCountNode = optionsNode->FirstChildElement("meshLodCount");
+    if (meshLodCountNode != nullptr) {
+        meshLodCount = std::stoul(meshLodCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *lodFullDetailSizeNode = optionsNode->FirstChildElement("lodFullDetailSize");
+    if (lodFullDetailSizeNode != nullptr) {
+        lodFullDetailSize = std::stoul(lodFullDetailSizeNode->GetText());
+    }
+
+    tinyxml2::XMLElement *shadowLodBiasNode = optionsNode->FirstChildElement("shadowLodBias");
+    if (shadowLodBiasNode != nullptr) {
+        shadowLodBias = std::stoul(shadowLodBiasNode->GetText());
+    }
+
+    tinyxml2::XMLElement *useStaticBatchingNode = optionsNode->FirstChildElement("useStaticBatching");
+    if (useStaticBatchingNode != nullptr) {
+        std::string useStaticBatchingText = useStaticBatchingNode->GetText();
+        if (useStaticBatchingText == "True") {
+            useStaticBatching = true;
+        } else if (useStaticBatchingText == "False") {
+            useStaticBatching = false;
+        } else {
+            std::cerr << "useStaticBatching value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *staticBatchChunkSizeNode = optionsNode->FirstChildElement("staticBatchChunkSize");
+    if (staticBatchChunkSizeNode != nullptr) {
+        staticBatchChunkSize = std::stof(staticBatchChunkSizeNode->GetText());
+    }
+
+    tinyxml2::XMLElement *staticBatchMaxInstanceCountNode = optionsNode->FirstChildElement("staticBatchMaxInstanceCount");
+    if (staticBatchMaxInstanceCountNode != nullptr) {
+        staticBatchMaxInstanceCount = std::stoul(staticBatchMaxInstanceCountNode->GetText());
+    }
+
+    tinyxml2::XMLElement *soundStreamingThresholdNode = optionsNode->FirstChildElement("soundStreamingThresholdKB");
+    if (soundStreamingThresholdNode != nullptr) {
+        soundStreamingThresholdKB = std::stoul(soundStreamingThresholdNode->GetText());
+    }
+
+    tinyxml2::XMLElement *useCompressedTexturesNode = optionsNode->FirstChildElement("useCompressedTextures");
+    if (useCompressedTexturesNode != nullptr) {
+        std::string useCompressedTexturesText = useCompressedTexturesNode->GetText();
+        if (useCompressedTexturesText == "True") {
+            useCompressedTextures = true;
+        } else if (useCompressedTexturesText == "False") {
+            useCompressedTextures = false;
+        } else {
+            std::cerr << "useCompressedTextures value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *useTextureStreamingNode = optionsNode->FirstChildElement("useTextureStreaming");
+    if (useTextureStreamingNode != nullptr) {
+        std::string useTextureStreamingText = useTextureStreamingNode->GetText();
+        if (useTextureStreamingText == "True") {
+            useTextureStreaming = true;
+        } else if (useTextureStreamingText == "False") {
+            useTextureStreaming = false;
+        } else {
+            std::cerr << "useTextureStreaming value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *useMaterialTextureArraysNode = optionsNode->FirstChildElement("useMaterialTextureArrays");
+    if (useMaterialTextureArraysNode != nullptr) {
+        std::string useMaterialTextureArraysText = useMaterialTextureArraysNode->GetText();
+        if (useMaterialTextureArraysText == "True") {
+            useMaterialTextureArrays = true;
+        } else if (useMaterialTextureArraysText == "False") {
+            useMaterialTextureArrays = false;
+        } else {
+            std::cerr << "useMaterialTextureArrays value is unknown, defaulting to False" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *textureStreamingBudgetNode = optionsNode->FirstChildElement("textureStreamingBudgetMB");
+    if (textureStreamingBudgetNode != nullptr) {
+        textureStreamingBudgetMB = std::stoul(textureStreamingBudgetNode->GetText());
+    }
+
+    tinyxml2::XMLElement *assetCacheCPUBudgetNode = optionsNode->FirstChildElement("assetCacheCPUBudgetMB");
+    if (assetCacheCPUBudgetNode != nullptr) {
+        assetCacheCPUBudgetMB = std::stoul(assetCacheCPUBudgetNode->GetText());
+    }
+
+    tinyxml2::XMLElement *assetCacheGPUBudgetNode = optionsNode->FirstChildElement("assetCacheGPUBudgetMB");
+    if (assetCacheGPUBudgetNode != nullptr) {
+        assetCacheGPUBudgetMB = std::stoul(assetCacheGPUBudgetNode->GetText());
+    }
+
+    tinyxml2::XMLElement *prefetchTargetWorldsNode = optionsNode->FirstChildElement("prefetchTargetWorlds");
+    if (prefetchTargetWorldsNode != nullptr) {
+        std::string prefetchTargetWorldsText = prefetchTargetWorldsNode->GetText();
+        if (prefetchTargetWorldsText == "True") {
+            prefetchTargetWorlds = true;
+        } else if (prefetchTargetWorldsText == "False") {
+            prefetchTargetWorlds = false;
+        } else {
+            std::cerr << "prefetchTargetWorlds value is unknown, defaulting to True" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *flowFieldPursuitNode = optionsNode->FirstChildElement("flowFieldPursuit");
+    if (flowFieldPursuitNode != nullptr) {
+        std::string flowFieldPursuitText = flowFieldPursuitNode->GetText();
+        if (flowFieldPursuitText == "True") {
+            flowFieldPursuit = true;
+        } else if (flowFieldPursuitText == "False") {
+            flowFieldPursuit = false;
+        } else {
+            std::cerr << "flowFieldPursuit value is unknown, defaulting to False" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *useNavMeshNode = optionsNode->FirstChildElement("useNavMesh");
+    if (useNavMeshNode != nullptr) {
+        std::string useNavMeshText = useNavMeshNode->GetText();
+        if (useNavMeshText == "True") {
+            useNavMesh = true;
+        } else if (useNavMeshText == "False") {
+            useNavMesh = false;
+        } else {
+            std::cerr << "useNavMesh value is unknown, defaulting to False" << std::endl;
+        }
+    }
+
+    tinyxml2::XMLElement *aiNearDistanceNode = optionsNode->FirstChildElement("aiNearDistance");
+    if (aiNearDistanceNode != nullptr) {
+        aiNearDistance = std::stof(aiNearDistanceNode->GetText());
+    }
+
+    tinyxml2::XMLElement *aiDormantDistanceNode = optionsNode->FirstChildElement("aiDormantDistance");
+    if (aiDormantDistanceNode != nullptr) {
+        aiDormantDistance = std::stof(aiDormantDistanceNode->GetText());
+    }
+
+    tinyxml2::XMLElement *aiFarUpdateIntervalNode = optionsNode->FirstChildElement("aiFarUpdateInterval");
+    if (aiFarUpdateIntervalNode != nullptr) {
+        aiFarUpdateInterval = std::stoul(aiFarUpdateIntervalNode->GetText());
+        if (aiFarUpdateInterval == 0) {
+            aiFarUpdateInterval = 1;
+        }
+    }
+
     tinyxml2::XMLElement *jumpFactorNode = optionsNode->FirstChildElement("jumpFactor");
     if (jumpFactorNode != nullptr) {
         jumpFactor = std::stof(jumpFactorNode->GetText());
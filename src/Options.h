@@ -41,6 +41,37 @@ private:
     //aspect,near,far
 
     uint32_t debugDrawBufferSize = 1000;
+    uint32_t raycastThreadCount = 1;
+    uint32_t aiGridGenerationThreadCount = 1;
+    uint32_t pathRequestBudgetMicroseconds = 1000;
+    bool printPathSearchStats = false;//prints path search statistics of each world when it is unloaded
+    uint32_t crowdSimulationThreadCount = 1;
+    uint32_t assetLoaderThreadCount = 2;
+    uint32_t assetUploadBudgetMicroseconds = 2000;//GL uploads of async loaded assets per frame
+    bool useCookedModels = true;
+    bool optimizeMeshes = true;//reorders indices at import for vertex cache, overdraw and vertex fetch
+    uint32_t meshLodCount = 3;//simplified levels generated at import, each has about half the triangles, 0 disables
+    uint32_t lodFullDetailSize = 400;//objects bigger than this on screen in pixels use full detail
+    uint32_t shadowLodBias = 1;//shadow passes use this many levels less detail than camera pass
+    bool useStaticBatching = true;//merges static models at world load, per material and chunk
+    float staticBatchChunkSize = 32.0f;
+    uint32_t staticBatchMaxInstanceCount = 8;//assets with more static instances are drawn instanced instead
+    uint32_t soundStreamingThresholdKB = 1024;//bigger wav files are decoded while playing, instead of at load
+    bool useCompressedTextures = true;
+    bool useTextureStreaming = true;//only compressed textures are streamed
+    uint32_t textureStreamingBudgetMB = 512;
+    bool useMaterialTextureArrays = false;//packs textures of each model to texture arrays, disables streaming
+    //assets that are not used by anything are kept until these are exceeded, 0 disables caching
+    uint32_t assetCacheCPUBudgetMB = 256;
+    uint32_t assetCacheGPUBudgetMB = 512;
+    bool prefetchTargetWorlds = true;//starts loading models of the worlds current world can switch to
+    bool flowFieldPursuit = false;
+    bool useNavMesh = false;
+    //AI level of detail, actors closer than near distance perceive every tick, further ones perceive
+    //once in farUpdateInterval ticks, and actors further than dormant distance are not processed
+    float aiNearDistance = 30.0f;
+    float aiDormantDistance = 150.0f;
+    uint32_t aiFarUpdateInterval = 8;
 
     /*SDL properties that should be available */
     void* imeWindowHandle;
@@ -113,6 +144,118 @@ public:
         std::cerr << "Setting debugDrawBufferSize(" << debugDrawBufferSize << ") is not implemented." << std::endl;
     }
 
+    uint32_t getRaycastThreadCount() const {
+        return raycastThreadCount;
+    }
+
+    uint32_t getAIGridGenerationThreadCount() const {
+        return aiGridGenerationThreadCount;
+    }
+
+    uint32_t getPathRequestBudgetMicroseconds() const {
+        return pathRequestBudgetMicroseconds;
+    }
+
+    bool isPrintPathSearchStats() const {
+        return printPathSearchStats;
+    }
+
+    uint32_t getCrowdSimulationThreadCount() const {
+        return crowdSimulationThreadCount;
+    }
+
+    uint32_t getAssetLoaderThreadCount() const {
+        return assetLoaderThreadCount;
+    }
+
+    uint32_t getAssetUploadBudgetMicroseconds() const {
+        return assetUploadBudgetMicroseconds;
+    }
+
+    bool isUseCookedModels() const {
+        return useCookedModels;
+    }
+
+    bool isOptimizeMeshes() const {
+        return optimizeMeshes;
+    }
+
+    uint32_t getMeshLodCount() const {
+        return meshLodCount;
+    }
+
+    uint32_t getLodFullDetailSize() const {
+        return lodFullDetailSize;
+    }
+
+    uint32_t getShadowLodBias() const {
+        return shadowLodBias;
+    }
+
+    bool isUseStaticBatching() const {
+        return useStaticBatching;
+    }
+
+    float getStaticBatchChunkSize() const {
+        return staticBatchChunkSize;
+    }
+
+    uint32_t getStaticBatchMaxInstanceCount() const {
+        return staticBatchMaxInstanceCount;
+    }
+
+    uint32_t getSoundStreamingThresholdKB() const {
+        return soundStreamingThresholdKB;
+    }
+
+    bool isUseCompressedTextures() const {
+        return useCompressedTextures;
+    }
+
+    bool isUseTextureStreaming() const {
+        return useTextureStreaming;
+    }
+
+    uint32_t getTextureStreamingBudgetMB() const {
+        return textureStreamingBudgetMB;
+    }
+
+    bool isUseMaterialTextureArrays() const {
+        return useMaterialTextureArrays;
+    }
+
+    uint32_t getAssetCacheCPUBudgetMB() const {
+        return assetCacheCPUBudgetMB;
+    }
+
+    uint32_t getAssetCacheGPUBudgetMB() const {
+        return assetCacheGPUBudgetMB;
+    }
+
+    bool isPrefetchTargetWorlds() const {
+        return prefetchTargetWorlds;
+    }
+
+    bool isFlowFieldPursuit() const {
+        return flowFieldPursuit;
+    }
+
+    bool isUseNavMesh() const {
+        return useNavMesh;
+    }
+
+    float getAINearDistance() const {
+        return aiNearDistance;
+    }
+
+    float getAIDormantDistance() const {
+        return aiDormantDistance;
+    }
+
+    uint32_t getAIFarUpdateInterval() const {
+        return aiFarUpdateInterval;
+    }
+
     uint32_t getShadowMapDirectionalWidth() const {
         return shadowMapDirectionalWidth;
     }
@@ -7,6 +7,7 @@
 
 
 void PhysicalRenderable::updateTransformFromPhysics() {
+    isInPhysicsMovedList = false;
     btTransform trans;
     rigidBody->getMotionState()->getWorldTransform(trans);
 
@@ -10,6 +10,8 @@
 #include "Utils/GLMConverter.h"
 #include "GameObjects/Sound.h"
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 class PhysicalRenderable : public Renderable {
 protected:
@@ -20,6 +22,8 @@ protected:
     btRigidBody *rigidBody;
     bool disconnected = false;
     std::unique_ptr<Sound> soundAttachment2 = nullptr;
+    std::vector<PhysicalRenderable *> *physicsMovedList = nullptr;
+    bool isInPhysicsMovedList = false;
 
 public:
     explicit PhysicalRenderable(GLHelper *glHelper, float mass, bool disconnected)
@@ -57,6 +61,33 @@ public:
 
     virtual void updateTransformFromPhysics();
 
+    /**
+     * Sets the list that this renderable adds itself, when physics simulation moves it.
+     * Owner of the list should call updateTransformFromPhysics for each element, and clear it.
+     */
+    void setPhysicsMovedList(std::vector<PhysicalRenderable *> *physicsMovedList) {
+        this->physicsMovedList = physicsMovedList;
+    }
+
+    void reportMovedByPhysics() {
+        if(physicsMovedList == nullptr || isInPhysicsMovedList || rigidBody->isStaticOrKinematicObject()) {
+            return;
+        }
+        physicsMovedList->push_back(this);
+        isInPhysicsMovedList = true;
+    }
+
+    /**
+     * Used when object is removed, so list doesn't have a dangling pointer
+     */
+    void removeFromPhysicsMovedList() {
+        if(physicsMovedList == nullptr || !isInPhysicsMovedList) {
+            return;
+        }
+        physicsMovedList->erase(std::remove(physicsMovedList->begin(), physicsMovedList->end(), this), physicsMovedList->end());
+        isInPhysicsMovedList = false;
+    }
+
     virtual void renderWithProgram(GLSLProgram &program) = 0;
 
     float getMass() const {
@@ -117,5 +148,21 @@ public:
 
 };
 
+/**
+ * Bullet calls setWorldTransform of the motion state only for active, dynamic bodies after simulation step.
+ * Using this, objects moved by physics are collected without iterating all objects.
+ */
+class PhysicalRenderableMotionState : public btDefaultMotionState {
+    PhysicalRenderable *owner;
+public:
+    PhysicalRenderableMotionState(PhysicalRenderable *owner, const btTransform &startTransform)
+            : btDefaultMotionState(startTransform), owner(owner) {}
+
+    void setWorldTransform(const btTransform &centerOfMassWorldTransform) override {
+        btDefaultMotionState::setWorldTransform(centerOfMassWorldTransform);
+        owner->reportMovedByPhysics();
+    }
+};
+
 
 #endif //LIMONENGINE_PHYSICAL_H
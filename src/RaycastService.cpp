@@ -0,0 +1,105 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "RaycastService.h"
+#include "GameObjects/GameObject.h"
+#include "Utils/GLMConverter.h"
+#include "Utils/WorkerPool.h"
+
+#include <iostream>
+#include <algorithm>
+
+GameObject *RaycastService::RayResult::getHitGameObject() const {
+    if(hitObject == nullptr) {
+        return nullptr;
+    }
+    return static_cast<GameObject *>(hitObject->getUserPointer());
+}
+
+RaycastService::RaycastService(uint32_t threadCount) : threadCount(threadCount) {
+    if(this->threadCount == 0) {
+        this->threadCount = 1;
+    }
+#if !BT_THREADSAFE
+    if(this->threadCount > 1) {
+        std::cerr << "Bullet is not built thread safe, ray tests will run on single thread." << std::endl;
+        this->threadCount = 1;
+    }
+#endif
+    if(this->threadCount > 1) {
+        workerPool = new WorkerPool(this->threadCount, "rayTestWorker");
+        this->threadCount = workerPool->getThreadCount();
+    }
+}
+
+RaycastService::~RaycastService() {
+    delete workerPool;
+}
+
+uint32_t RaycastService::addRequest(const glm::vec3 &from, const glm::vec3 &to, int collisionFilterGroup,
+                                    int collisionFilterMask, const btCollisionObject *ignoredObject) {
+    RayRequest request;
+    request.from = from;
+    request.to = to;
+    request.collisionFilterGroup = collisionFilterGroup;
+    request.collisionFilterMask = collisionFilterMask;
+    request.ignoredObject = ignoredObject;
+    requests.push_back(request);
+    return requests.size() - 1;
+}
+
+void RaycastService::executeRange(const btCollisionWorld *world, size_t startIndex, size_t endIndex) {
+    for (size_t i = startIndex; i < endIndex; ++i) {
+        const RayRequest& request = requests[i];
+        btVector3 from = GLMConverter::GLMToBlt(request.from);
+        btVector3 to = GLMConverter::GLMToBlt(request.to);
+        FilteredClosestRayResultCallback rayCallback(from, to, request.ignoredObject);
+        rayCallback.m_collisionFilterGroup = request.collisionFilterGroup;
+        rayCallback.m_collisionFilterMask = request.collisionFilterMask;
+
+        world->rayTest(from, to, rayCallback);
+
+        RayResult& result = results[i];
+        result.hasHit = rayCallback.hasHit();
+        if(result.hasHit) {
+            result.hitObject = rayCallback.m_collisionObject;
+            result.hitPoint = GLMConverter::BltToGLM(rayCallback.m_hitPointWorld);
+            result.hitNormal = GLMConverter::BltToGLM(rayCallback.m_hitNormalWorld);
+            result.hitFraction = rayCallback.m_closestHitFraction;
+        }
+    }
+}
+
+void RaycastService::staticWorkerJob(void *raycastService, uint32_t jobIndex) {
+    RaycastService* service = static_cast<RaycastService *>(raycastService);
+    const WorkerParameters& parameters = service->workerParameters[jobIndex];
+    service->executeRange(service->batchWorld, parameters.startIndex, parameters.endIndex);
+}
+
+void RaycastService::executeBatch(const btCollisionWorld *world) {
+    //results might have been filled by a previous execution, rays that are already run are not repeated
+    size_t alreadyExecuted = results.size();
+    results.resize(requests.size());
+    size_t requestCount = requests.size() - alreadyExecuted;
+    if(requestCount == 0) {
+        return;
+    }
+
+    size_t usedThreadCount = std::min((size_t)threadCount, requestCount / minimumRaysPerThread);
+    if(usedThreadCount <= 1) {
+        executeRange(world, alreadyExecuted, requests.size());
+        return;
+    }
+
+    //one range per thread, main thread works on them too
+    workerParameters.resize(usedThreadCount);
+    size_t raysPerThread = requestCount / usedThreadCount;
+    for (size_t i = 0; i < usedThreadCount; ++i) {
+        workerParameters[i].startIndex = alreadyExecuted + i * raysPerThread;
+        workerParameters[i].endIndex = (i == usedThreadCount - 1) ? requests.size() : workerParameters[i].startIndex + raysPerThread;
+    }
+    batchWorld = world;
+    workerPool->run(&staticWorkerJob, this, (uint32_t) usedThreadCount);
+    batchWorld = nullptr;
+}
@@ -0,0 +1,124 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_RAYCASTSERVICE_H
+#define LIMONENGINE_RAYCASTSERVICE_H
+
+
+#include <vector>
+#include <cstdint>
+#include <btBulletCollisionCommon.h>
+#include <glm/glm.hpp>
+
+class GameObject;
+class WorkerPool;
+
+/**
+ * Collects ray requests during a tick, and runs them together with executeBatch.
+ *
+ * Rejection of unwanted objects should be done by collision filter group/mask, and by the ignored object,
+ * so no post processing of the hits are required. Results are accessed by the handle returned on request,
+ * and they are valid until next clear.
+ *
+ * Ray tests are read only, so batch can be split to worker threads. This is only possible if Bullet is built
+ * with BT_THREADSAFE, because broadphase ray test stack is shared otherwise. Worker threads are kept between batches.
+ */
+class RaycastService {
+public:
+    struct RayResult {
+        bool hasHit = false;
+        const btCollisionObject* hitObject = nullptr;
+        glm::vec3 hitPoint;
+        glm::vec3 hitNormal;
+        float hitFraction = 1.0f;
+
+        GameObject* getHitGameObject() const;
+    };
+
+private:
+    /**
+     * Closest ray callback that skips a single object, used for skipping the object that casts the ray
+     */
+    class FilteredClosestRayResultCallback : public btCollisionWorld::ClosestRayResultCallback {
+        const btCollisionObject* ignoredObject;
+    public:
+        FilteredClosestRayResultCallback(const btVector3 &from, const btVector3 &to, const btCollisionObject* ignoredObject)
+                : btCollisionWorld::ClosestRayResultCallback(from, to), ignoredObject(ignoredObject) {}
+
+        bool needsCollision(btBroadphaseProxy* proxy0) const override {
+            if(proxy0->m_clientObject == ignoredObject) {
+                return false;
+            }
+            return btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy0);
+        }
+    };
+
+    struct RayRequest {
+        glm::vec3 from;
+        glm::vec3 to;
+        int collisionFilterGroup;
+        int collisionFilterMask;
+        const btCollisionObject* ignoredObject;
+    };
+
+    struct WorkerParameters {
+        size_t startIndex;
+        size_t endIndex;
+    };
+
+    std::vector<RayRequest> requests;
+    std::vector<RayResult> results;
+    uint32_t threadCount;
+    size_t minimumRaysPerThread = 32;
+    WorkerPool *workerPool = nullptr;
+    //set for the duration of executeBatch, used by worker jobs
+    const btCollisionWorld *batchWorld = nullptr;
+    std::vector<WorkerParameters> workerParameters;
+
+    void executeRange(const btCollisionWorld *world, size_t startIndex, size_t endIndex);
+
+    static void staticWorkerJob(void *raycastService, uint32_t jobIndex);
+
+public:
+    explicit RaycastService(uint32_t threadCount);
+
+    RaycastService(const RaycastService &) = delete;
+    RaycastService &operator=(const RaycastService &) = delete;
+
+    ~RaycastService();
+
+    /**
+     * Requests a ray test for next executeBatch call.
+     *
+     * @param from start of ray
+     * @param to end of ray
+     * @param collisionFilterGroup group of the ray, objects mask must contain it
+     * @param collisionFilterMask objects group must be in this mask to be hit
+     * @param ignoredObject this object is never hit, can be nullptr
+     * @return handle to get result after execution
+     */
+    uint32_t addRequest(const glm::vec3 &from, const glm::vec3 &to, int collisionFilterGroup, int collisionFilterMask,
+                        const btCollisionObject *ignoredObject = nullptr);
+
+    void executeBatch(const btCollisionWorld *world);
+
+    const RayResult& getResult(uint32_t handle) const {
+        return results[handle];
+    }
+
+    size_t getRequestCount() const {
+        return requests.size();
+    }
+
+    /**
+     * Removes requests and results, but keeps the memory for next tick.
+     */
+    void clear() {
+        requests.clear();
+        results.clear();
+    }
+};
+
+
+#endif //LIMONENGINE_RAYCASTSERVICE_H
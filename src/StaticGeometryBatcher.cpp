@@ -0,0 +1,232 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "StaticGeometryBatcher.h"
+#include "GLHelper.h"
+#include "GLSLProgram.h"
+#include "GameObjects/Model.h"
+#include "Utils/VertexQuantizer.h"
+
+#include <map>
+#include <tuple>
+#include <algorithm>
+
+const uint32_t StaticGeometryBatcher::BATCH_MODEL_ID;
+
+StaticGeometryBatcher::StaticGeometryBatcher(GLHelper *glHelper, const std::vector<Model *> &models, float chunkSize)
+        : glHelper(glHelper) {
+    batchModelIndices.push_back(BATCH_MODEL_ID);
+    glHelper->setModel(BATCH_MODEL_ID, glm::mat4(1.0f));
+
+    std::map<std::tuple<int32_t, int32_t, int32_t, const Material *>, size_t> chunkIndices;
+    for (size_t i = 0; i < models.size(); ++i) {
+        Model *model = models[i];
+        glm::vec3 cell = glm::floor((model->getAabbMin() + model->getAabbMax()) * 0.5f / chunkSize);
+        std::vector<MeshAsset *> meshes = model->getMeshes();
+        for (uint32_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex) {
+            const Material *material = meshes[meshIndex]->getMaterial();
+            if (material == nullptr) {
+                continue;
+            }
+            auto key = std::make_tuple((int32_t) cell.x, (int32_t) cell.y, (int32_t) cell.z, material);
+            auto chunkIt = chunkIndices.find(key);
+            if (chunkIt == chunkIndices.end()) {
+                chunkIt = chunkIndices.insert(std::make_pair(key, chunks.size())).first;
+                chunks.emplace_back();
+                chunks.back().material = material;
+                chunks.back().sampleModel = model;
+                chunks.back().meshIndex = meshIndex;
+            }
+            chunks[chunkIt->second].batchedMeshes.push_back({model, meshes[meshIndex], 0, false});
+            std::vector<size_t> &chunksOfModel = modelChunks[model];
+            if (chunksOfModel.empty() || chunksOfModel.back() != chunkIt->second) {
+                chunksOfModel.push_back(chunkIt->second);
+            }
+        }
+        model->setStaticBatched(true);
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        buildBuffers(chunks[i]);
+    }
+}
+
+StaticGeometryBatcher::~StaticGeometryBatcher() {
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        for (size_t j = 0; j < chunks[i].lodEbos.size(); ++j) {
+            glHelper->freeBuffer(chunks[i].lodEbos[j]);
+        }
+        glHelper->freeBuffer(chunks[i].vbo);
+        glHelper->freeVAO(chunks[i].vao);
+    }
+}
+
+/**
+ * Transforms vertices of the meshes to world space, and uploads them as one packed buffer with index buffers
+ * for each lod.
+ */
+void StaticGeometryBatcher::buildBuffers(Chunk &chunk) {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> textureCoordinates;
+    for (size_t i = 0; i < chunk.batchedMeshes.size(); ++i) {
+        BatchedMesh &batchedMesh = chunk.batchedMeshes[i];
+        const glm::mat4 &worldTransform = batchedMesh.model->getTransformation()->getWorldTransform();
+        glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3(worldTransform)));
+        const std::vector<glm::vec3> &meshVertices = batchedMesh.mesh->getVertices();
+        const std::vector<glm::vec3> &meshNormals = batchedMesh.mesh->getNormals();
+        const std::vector<glm::vec2> &meshTextureCoordinates = batchedMesh.mesh->getTextureCoordinates();
+        batchedMesh.firstVertex = (uint32_t) positions.size();
+        for (size_t j = 0; j < meshVertices.size(); ++j) {
+            positions.push_back(glm::vec3(worldTransform * glm::vec4(meshVertices[j], 1.0f)));
+            normals.push_back(glm::normalize(normalTransform * meshNormals[j]));
+            textureCoordinates.push_back(j < meshTextureCoordinates.size() ? meshTextureCoordinates[j] : glm::vec2(0, 0));
+        }
+        chunk.lodCount = std::max(chunk.lodCount, batchedMesh.mesh->getLodCount());
+    }
+    if (positions.empty()) {
+        return;
+    }
+
+    chunk.aabbMin = positions[0];
+    chunk.aabbMax = positions[0];
+    for (size_t i = 1; i < positions.size(); ++i) {
+        chunk.aabbMin = glm::min(chunk.aabbMin, positions[i]);
+        chunk.aabbMax = glm::max(chunk.aabbMax, positions[i]);
+    }
+
+    VertexQuantizer::calculatePositionRange(positions, chunk.positionOffset, chunk.positionScale);
+    std::vector<VertexQuantizer::PackedVertex> packedVertices = VertexQuantizer::pack(positions, normals,
+                                                                                      textureCoordinates,
+                                                                                      chunk.positionOffset,
+                                                                                      chunk.positionScale);
+    std::vector<glm::mediump_uvec3> faces = collectFaces(chunk, 0);
+    uint_fast32_t ebo;
+    chunk.indexType = glHelper->bufferPackedVertexData(packedVertices, std::vector<VertexQuantizer::PackedSkinnedVertex>(),
+                                                       faces, chunk.vao, chunk.vbo, ebo);
+    chunk.lodEbos.push_back(ebo);
+    chunk.lodElementCounts.push_back((uint32_t) faces.size() * 3);
+    for (uint32_t lod = 1; lod < chunk.lodCount; ++lod) {
+        faces = collectFaces(chunk, lod);
+        chunk.lodEbos.push_back(glHelper->bufferIndexData(faces, chunk.indexType));
+        chunk.lodElementCounts.push_back((uint32_t) faces.size() * 3);
+    }
+}
+
+std::vector<glm::mediump_uvec3> StaticGeometryBatcher::collectFaces(const Chunk &chunk, uint32_t lod) const {
+    std::vector<glm::mediump_uvec3> faces;
+    for (size_t i = 0; i < chunk.batchedMeshes.size(); ++i) {
+        const BatchedMesh &batchedMesh = chunk.batchedMeshes[i];
+        if (batchedMesh.isRemoved) {
+            continue;
+        }
+        const std::vector<glm::mediump_uvec3> &meshFaces = batchedMesh.mesh->getFaces(lod);
+        glm::mediump_uvec3 offset(batchedMesh.firstVertex);
+        for (size_t j = 0; j < meshFaces.size(); ++j) {
+            faces.push_back(meshFaces[j] + offset);
+        }
+    }
+    return faces;
+}
+
+/**
+ * Vertices of removed meshes stay in the vertex buffer, only index buffers are rebuilt without them.
+ */
+void StaticGeometryBatcher::rebuildIndexBuffers(Chunk &chunk) {
+    //removed models might be deleted, so sample model is replaced with one that is still batched
+    for (size_t i = 0; i < chunk.batchedMeshes.size(); ++i) {
+        if (!chunk.batchedMeshes[i].isRemoved) {
+            chunk.sampleModel = chunk.batchedMeshes[i].model;
+            std::vector<MeshAsset *> meshes = chunk.sampleModel->getMeshes();
+            chunk.meshIndex = (uint32_t) (std::find(meshes.begin(), meshes.end(), chunk.batchedMeshes[i].mesh) - meshes.begin());
+            break;
+        }
+    }
+    for (uint32_t lod = 0; lod < chunk.lodEbos.size(); ++lod) {
+        glHelper->freeBuffer(chunk.lodEbos[lod]);
+        std::vector<glm::mediump_uvec3> faces = collectFaces(chunk, lod);
+        chunk.lodEbos[lod] = glHelper->bufferIndexData(faces, chunk.indexType);
+        chunk.lodElementCounts[lod] = (uint32_t) faces.size() * 3;
+    }
+}
+
+void StaticGeometryBatcher::removeModels(const std::vector<Model *> &models) {
+    std::vector<bool> isChunkChanged(chunks.size(), false);
+    for (size_t i = 0; i < models.size(); ++i) {
+        auto modelIt = modelChunks.find(models[i]);
+        if (modelIt == modelChunks.end()) {
+            continue;
+        }
+        for (size_t j = 0; j < modelIt->second.size(); ++j) {
+            Chunk &chunk = chunks[modelIt->second[j]];
+            for (size_t k = 0; k < chunk.batchedMeshes.size(); ++k) {
+                if (chunk.batchedMeshes[k].model == models[i]) {
+                    chunk.batchedMeshes[k].isRemoved = true;
+                }
+            }
+            isChunkChanged[modelIt->second[j]] = true;
+        }
+        models[i]->setStaticBatched(false);
+        modelChunks.erase(modelIt);
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (isChunkChanged[i]) {
+            rebuildIndexBuffers(chunks[i]);
+        }
+    }
+}
+
+void StaticGeometryBatcher::removeMovedModels(std::vector<Model *> &removedModels) {
+    std::vector<Model *> movedModels;
+    for (auto modelIt = modelChunks.begin(); modelIt != modelChunks.end(); ++modelIt) {
+        if (modelIt->first->isMovedAfterBatching()) {
+            movedModels.push_back(modelIt->first);
+        }
+    }
+    if (movedModels.empty()) {
+        return;
+    }
+    removeModels(movedModels);
+    removedModels.insert(removedModels.end(), movedModels.begin(), movedModels.end());
+}
+
+void StaticGeometryBatcher::requestTextureLevels(size_t chunkIndex, TextureStreamer *textureStreamer,
+                                                 float projectedSize) const {
+    if (chunks[chunkIndex].lodElementCounts.empty() || chunks[chunkIndex].lodElementCounts[0] == 0) {
+        return;
+    }
+    Model::requestMaterialTextureLevels(textureStreamer, chunks[chunkIndex].material, projectedSize);
+}
+
+void StaticGeometryBatcher::renderChunk(size_t chunkIndex, uint32_t lod, GLSLProgram *program) {
+    Chunk &chunk = chunks[chunkIndex];
+    if (chunk.lodEbos.empty()) {
+        return;
+    }
+    lod = std::min(lod, (uint32_t) chunk.lodEbos.size() - 1);
+    if (chunk.lodElementCounts[lod] == 0) {
+        //all models of the chunk are moved
+        return;
+    }
+    glHelper->setModelIndexesUBO(batchModelIndices);
+    if (program == nullptr) {
+        program = chunk.sampleModel->getMeshProgram(chunk.meshIndex);
+        if (chunk.sampleModel->hasTextureArrays()) {
+            chunk.sampleModel->activateTextureArrays();
+        }
+        glHelper->attachMaterialUBO(program->getID(), chunk.material->getMaterialIndex());
+        chunk.sampleModel->activateTexturesOnly(chunk.material);
+    } else {
+        glHelper->attachModelUBO(program->getID());
+        glHelper->attachModelIndicesUBO(program->getID());
+        program->setUniform("isAnimated", false);
+        if (program->IsMaterialRequired()) {
+            glHelper->attachMaterialUBO(program->getID(), chunk.material->getMaterialIndex());
+        }
+    }
+    program->setUniform("positionOffset", chunk.positionOffset);
+    program->setUniform("positionScale", chunk.positionScale);
+    glHelper->renderInstanced(program->getID(), chunk.vao, chunk.lodEbos[lod], chunk.lodElementCounts[lod], 1,
+                              chunk.indexType);
+}
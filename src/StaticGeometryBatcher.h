@@ -0,0 +1,113 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_STATICGEOMETRYBATCHER_H
+#define LIMONENGINE_STATICGEOMETRYBATCHER_H
+
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class GLHelper;
+class GLSLProgram;
+class Model;
+class MeshAsset;
+class Material;
+class TextureStreamer;
+
+/**
+ * Merges meshes of static models into world space vertex buffers, so they can be drawn with one call per material
+ * for each chunk, instead of one call per asset and mesh.
+ *
+ * Models are put to chunks by the grid cell their center falls, meshes of a chunk that share a material are merged.
+ * Culling and lod selection is done per chunk by World. Chunk lod levels are built from lod levels of the meshes.
+ *
+ * Batch vertices are in world space, they are drawn with BATCH_MODEL_ID, which has identity transform. If a batched
+ * model moves, it is removed from its chunks and World renders it as a normal model again.
+ */
+class StaticGeometryBatcher {
+    struct BatchedMesh {
+        Model *model;
+        MeshAsset *mesh;
+        uint32_t firstVertex;
+        bool isRemoved;
+    };
+
+    struct Chunk {
+        const Material *material;
+        Model *sampleModel;//program and texture state of the material is taken from this model
+        uint32_t meshIndex;
+        std::vector<BatchedMesh> batchedMeshes;
+        glm::vec3 aabbMin;
+        glm::vec3 aabbMax;
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
+        uint_fast32_t vao = 0;
+        uint_fast32_t vbo = 0;
+        uint32_t indexType = 0;
+        uint32_t lodCount = 1;
+        std::vector<uint_fast32_t> lodEbos;
+        std::vector<uint32_t> lodElementCounts;
+    };
+
+    GLHelper *glHelper;
+    std::vector<Chunk> chunks;
+    std::unordered_map<Model *, std::vector<size_t>> modelChunks;
+    std::vector<uint32_t> batchModelIndices;
+
+    void buildBuffers(Chunk &chunk);
+
+    std::vector<glm::mediump_uvec3> collectFaces(const Chunk &chunk, uint32_t lod) const;
+
+    void rebuildIndexBuffers(Chunk &chunk);
+
+public:
+    static const uint32_t BATCH_MODEL_ID = 0;//world object IDs start from 1
+
+    /**
+     * Models should be static, they are marked as batched. Must be called from main thread.
+     */
+    StaticGeometryBatcher(GLHelper *glHelper, const std::vector<Model *> &models, float chunkSize);
+
+    ~StaticGeometryBatcher();
+
+    void removeModels(const std::vector<Model *> &models);
+
+    /**
+     * Removes models that moved since batching, and adds them to removedModels.
+     */
+    void removeMovedModels(std::vector<Model *> &removedModels);
+
+    size_t getChunkCount() const {
+        return chunks.size();
+    }
+
+    size_t getBatchedModelCount() const {
+        return modelChunks.size();
+    }
+
+    const glm::vec3 &getChunkAabbMin(size_t chunkIndex) const {
+        return chunks[chunkIndex].aabbMin;
+    }
+
+    const glm::vec3 &getChunkAabbMax(size_t chunkIndex) const {
+        return chunks[chunkIndex].aabbMax;
+    }
+
+    uint32_t getChunkLodCount(size_t chunkIndex) const {
+        return chunks[chunkIndex].lodCount;
+    }
+
+    void requestTextureLevels(size_t chunkIndex, TextureStreamer *textureStreamer, float projectedSize) const;
+
+    /**
+     * @param program if nullptr, chunk is rendered with its material, otherwise with given program like shadow passes
+     */
+    void renderChunk(size_t chunkIndex, uint32_t lod, GLSLProgram *program);
+};
+
+
+#endif //LIMONENGINE_STATICGEOMETRYBATCHER_H
@@ -0,0 +1,139 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_BINARYSTREAM_H
+#define LIMONENGINE_BINARYSTREAM_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+/**
+ * Helpers for cooked binary files. Values are written in native byte order, with no padding,
+ * so only plain types (integers, floats, glm vectors and matrices) should be written directly.
+ */
+class BinaryWriter {
+    std::vector<uint8_t> buffer;
+
+public:
+    void writeBytes(const void *data, size_t length) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + length);
+    }
+
+    template<typename T>
+    void write(const T &value) {
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(const std::string &text) {
+        write((uint32_t) text.length());
+        writeBytes(text.data(), text.length());
+    }
+
+    template<typename T>
+    void writeVector(const std::vector<T> &values) {
+        write((uint32_t) values.size());
+        if (!values.empty()) {
+            writeBytes(values.data(), values.size() * sizeof(T));
+        }
+    }
+
+    const std::vector<uint8_t> &getBuffer() const {
+        return buffer;
+    }
+
+    bool writeToFile(const std::string &fileName) const {
+        std::ofstream fileStream(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fileStream.is_open()) {
+            return false;
+        }
+        fileStream.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+        fileStream.close();
+        return !fileStream.fail();
+    }
+};
+
+/**
+ * Reads what BinaryWriter wrote. Reading past the end doesn't crash, it sets failed flag and returns zeroed values,
+ * so callers can read everything and check isFailed once.
+ */
+class BinaryReader {
+    const uint8_t *data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+public:
+    BinaryReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    bool readBytes(void *target, size_t length) {
+        if (failed || length > size - offset) {
+            failed = true;
+            memset(target, 0, length);
+            return false;
+        }
+        memcpy(target, data + offset, length);
+        offset += length;
+        return true;
+    }
+
+    bool skipBytes(size_t length) {
+        if (failed || length > size - offset) {
+            failed = true;
+            return false;
+        }
+        offset += length;
+        return true;
+    }
+
+    size_t getOffset() const {
+        return offset;
+    }
+
+    template<typename T>
+    T read() {
+        T value;
+        readBytes(&value, sizeof(T));
+        return value;
+    }
+
+    std::string readString() {
+        uint32_t length = read<uint32_t>();
+        if (failed || length > size - offset) {
+            failed = true;
+            return std::string();
+        }
+        std::string text(reinterpret_cast<const char *>(data + offset), length);
+        offset += length;
+        return text;
+    }
+
+    template<typename T>
+    void readVector(std::vector<T> &values) {
+        uint32_t count = read<uint32_t>();
+        if (failed || count > (size - offset) / sizeof(T)) {
+            failed = true;
+            values.clear();
+            return;
+        }
+        values.resize(count);
+        if (count > 0) {
+            readBytes(values.data(), count * sizeof(T));
+        }
+    }
+
+    bool isFailed() const {
+        return failed;
+    }
+
+    bool isAtEnd() const {
+        return offset == size;
+    }
+};
+
+
+#endif //LIMONENGINE_BINARYSTREAM_H
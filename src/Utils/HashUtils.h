@@ -0,0 +1,40 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_HASHUTILS_H
+#define LIMONENGINE_HASHUTILS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * FNV-1a 64 bit. It is not cryptographic, only used for detecting content changes and hashed lookups.
+ */
+class HashUtils {
+public:
+    static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    static uint64_t hashBytes(const void *data, size_t length, uint64_t hash = FNV_OFFSET_BASIS) {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    static uint64_t hashString(const std::string &text, uint64_t hash = FNV_OFFSET_BASIS) {
+        return hashBytes(text.data(), text.length(), hash);
+    }
+
+    template<typename T>
+    static uint64_t hashValue(const T &value, uint64_t hash = FNV_OFFSET_BASIS) {
+        return hashBytes(&value, sizeof(T), hash);
+    }
+};
+
+
+#endif //LIMONENGINE_HASHUTILS_H
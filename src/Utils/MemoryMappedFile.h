@@ -0,0 +1,53 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_MEMORYMAPPEDFILE_H
+#define LIMONENGINE_MEMORYMAPPEDFILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Read only memory mapping of a file. Mapping is removed when object is destroyed.
+ */
+class MemoryMappedFile {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+public:
+    MemoryMappedFile() = default;
+
+    MemoryMappedFile(const MemoryMappedFile &) = delete;
+    MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+    ~MemoryMappedFile() {
+        close();
+    }
+
+    bool open(const std::string &fileName);
+
+    void close();
+
+    bool isOpen() const {
+        return data != nullptr;
+    }
+
+    const uint8_t *getData() const {
+        return data;
+    }
+
+    size_t getSize() const {
+        return size;
+    }
+};
+
+
+#endif //LIMONENGINE_MEMORYMAPPEDFILE_H
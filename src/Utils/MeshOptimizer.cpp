@@ -0,0 +1,292 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+const uint32_t MeshOptimizer::ANALYSIS_CACHE_SIZE;
+const uint32_t MeshOptimizer::SCORING_CACHE_SIZE;
+constexpr float MeshOptimizer::OVERDRAW_ACMR_THRESHOLD;
+
+float MeshOptimizer::calculateVertexScore(int32_t cachePosition, uint32_t remainingTriangleCount) {
+    if (remainingTriangleCount == 0) {
+        //no triangle left to use this vertex
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            //used by last triangle, fixed score so the strip doesn't prefer going back
+            score = 0.75f;
+        } else {
+            score = std::pow(1.0f - (cachePosition - 3) / (float) (SCORING_CACHE_SIZE - 3), 1.5f);
+        }
+    }
+    //vertices with few triangles left are finished first, so they don't need to be loaded again later
+    score += 2.0f / std::sqrt((float) remainingTriangleCount);
+    return score;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount) {
+    uint32_t triangleCount = (uint32_t) (indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    //triangles using each vertex, remaining ones are kept in front
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        triangleOffsets[indices[i] + 1]++;
+    }
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        triangleOffsets[i + 1] += triangleOffsets[i];
+    }
+    std::vector<uint32_t> remainingTriangleCounts(vertexCount, 0);
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    for (uint32_t i = 0; i < triangleCount * 3; ++i) {
+        uint32_t vertex = indices[i];
+        vertexTriangles[triangleOffsets[vertex] + remainingTriangleCounts[vertex]] = i / 3;
+        remainingTriangleCounts[vertex]++;
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        vertexScores[i] = calculateVertexScore(-1, remainingTriangleCounts[i]);
+    }
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> isEmitted(triangleCount, false);
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] +
+                            vertexScores[indices[i * 3 + 2]];
+    }
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(SCORING_CACHE_SIZE + 3);
+    nextCache.reserve(SCORING_CACHE_SIZE + 3);
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    int64_t bestTriangle = -1;
+    uint32_t nextUnemittedTriangle = 0;
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestTriangle < 0) {
+            //nothing in cache has triangles left, restart from the first one that is not emitted
+            while (isEmitted[nextUnemittedTriangle]) {
+                nextUnemittedTriangle++;
+            }
+            bestTriangle = nextUnemittedTriangle;
+        }
+        uint32_t triangle = (uint32_t) bestTriangle;
+        isEmitted[triangle] = true;
+
+        nextCache.clear();
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            result.push_back(vertex);
+            nextCache.push_back(vertex);
+
+            //remove emitted triangle from remaining triangles of the vertex
+            uint32_t *triangles = &vertexTriangles[triangleOffsets[vertex]];
+            for (uint32_t i = 0; i < remainingTriangleCounts[vertex]; ++i) {
+                if (triangles[i] == triangle) {
+                    std::swap(triangles[i], triangles[remainingTriangleCounts[vertex] - 1]);
+                    break;
+                }
+            }
+            remainingTriangleCounts[vertex]--;
+        }
+        for (size_t i = 0; i < cache.size(); ++i) {
+            uint32_t vertex = cache[i];
+            if (vertex != nextCache[0] && vertex != nextCache[1] && vertex != nextCache[2]) {
+                nextCache.push_back(vertex);
+            }
+        }
+        //vertices that fall out of the cache are updated too
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            cachePositions[nextCache[i]] = i < SCORING_CACHE_SIZE ? (int32_t) i : -1;
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            uint32_t vertex = nextCache[i];
+            float newScore = calculateVertexScore(cachePositions[vertex], remainingTriangleCounts[vertex]);
+            float scoreChange = newScore - vertexScores[vertex];
+            vertexScores[vertex] = newScore;
+            const uint32_t *triangles = &vertexTriangles[triangleOffsets[vertex]];
+            for (uint32_t j = 0; j < remainingTriangleCounts[vertex]; ++j) {
+                triangleScores[triangles[j]] += scoreChange;
+                if (i < SCORING_CACHE_SIZE && triangleScores[triangles[j]] > bestScore) {
+                    bestScore = triangleScores[triangles[j]];
+                    bestTriangle = triangles[j];
+                }
+            }
+        }
+        if (nextCache.size() > SCORING_CACHE_SIZE) {
+            nextCache.resize(SCORING_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+uint32_t MeshOptimizer::simulateCacheMisses(const uint32_t *triangleIndices, std::vector<uint32_t> &cache) {
+    uint32_t missCount = 0;
+    for (uint32_t corner = 0; corner < 3; ++corner) {
+        uint32_t vertex = triangleIndices[corner];
+        if (std::find(cache.begin(), cache.end(), vertex) == cache.end()) {
+            missCount++;
+            cache.insert(cache.begin(), vertex);
+            if (cache.size() > ANALYSIS_CACHE_SIZE) {
+                cache.pop_back();
+            }
+        }
+    }
+    return missCount;
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions) {
+    uint32_t triangleCount = (uint32_t) (indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+
+    //hard boundaries, cluster starts where all 3 vertices of a triangle miss the cache
+    std::vector<uint32_t> hardClusterStarts;
+    uint32_t meshMissCount = 0;
+    std::vector<uint32_t> cache;
+    for (uint32_t triangle = 0; triangle < triangleCount; ++triangle) {
+        uint32_t missCount = simulateCacheMisses(&indices[triangle * 3], cache);
+        meshMissCount += missCount;
+        if (triangle == 0 || missCount == 3) {
+            hardClusterStarts.push_back(triangle);
+        }
+    }
+    hardClusterStarts.push_back(triangleCount);
+
+    /*
+     * Soft boundaries (Sander et al.), hard clusters are too big to sort well. Cache misses of a cluster are counted
+     * starting from an empty cache, since it can be drawn after any other cluster. A cluster is split after a triangle
+     * if its ACMR so far is within threshold of the mesh ACMR, so sorting clusters can't make ACMR much worse.
+     */
+    float clusterThreshold = OVERDRAW_ACMR_THRESHOLD * (meshMissCount / (float) triangleCount);
+    std::vector<uint32_t> clusterStarts;
+    for (size_t hardCluster = 0; hardCluster + 1 < hardClusterStarts.size(); ++hardCluster) {
+        uint32_t clusterStart = hardClusterStarts[hardCluster];
+        uint32_t clusterEnd = hardClusterStarts[hardCluster + 1];
+        clusterStarts.push_back(clusterStart);
+        cache.clear();
+        uint32_t clusterMissCount = 0;
+        for (uint32_t triangle = clusterStart; triangle + 1 < clusterEnd; ++triangle) {
+            clusterMissCount += simulateCacheMisses(&indices[triangle * 3], cache);
+            if (clusterMissCount <= clusterThreshold * (triangle + 1 - clusterStart)) {
+                clusterStart = triangle + 1;
+                clusterStarts.push_back(clusterStart);
+                cache.clear();
+                clusterMissCount = 0;
+            }
+        }
+    }
+    if (clusterStarts.size() < 2) {
+        return;
+    }
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCenter(0, 0, 0);
+    float meshArea = 0;
+    std::vector<glm::vec3> clusterCenters(clusterStarts.size() - 1);
+    std::vector<glm::vec3> clusterNormals(clusterStarts.size() - 1);
+    for (size_t cluster = 0; cluster + 1 < clusterStarts.size(); ++cluster) {
+        glm::vec3 center(0, 0, 0);
+        glm::vec3 normal(0, 0, 0);
+        float area = 0;
+        for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle) {
+            const glm::vec3 &position0 = positions[indices[triangle * 3]];
+            const glm::vec3 &position1 = positions[indices[triangle * 3 + 1]];
+            const glm::vec3 &position2 = positions[indices[triangle * 3 + 2]];
+            //length of the cross product is twice the area, so sum of them is area weighted
+            glm::vec3 triangleNormal = glm::cross(position1 - position0, position2 - position0);
+            float triangleArea = glm::length(triangleNormal);
+            center += (position0 + position1 + position2) * (triangleArea / 3.0f);
+            normal += triangleNormal;
+            area += triangleArea;
+        }
+        meshCenter += center;
+        meshArea += area;
+        clusterCenters[cluster] = area > 0 ? center / area : positions[indices[clusterStarts[cluster] * 3]];
+        float normalLength = glm::length(normal);
+        clusterNormals[cluster] = normalLength > 0 ? normal / normalLength : glm::vec3(0, 0, 0);
+    }
+    if (meshArea > 0) {
+        meshCenter /= meshArea;
+    }
+
+    std::vector<std::pair<float, uint32_t>> clusterOrder(clusterStarts.size() - 1);
+    for (uint32_t cluster = 0; cluster < clusterOrder.size(); ++cluster) {
+        clusterOrder[cluster] = std::make_pair(glm::dot(clusterCenters[cluster] - meshCenter, clusterNormals[cluster]),
+                                               cluster);
+    }
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [](const std::pair<float, uint32_t> &first, const std::pair<float, uint32_t> &second) {
+                         return first.first > second.first;
+                     });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t i = 0; i < clusterOrder.size(); ++i) {
+        uint32_t cluster = clusterOrder[i].second;
+        result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3,
+                      indices.begin() + clusterStarts[cluster + 1] * 3);
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(std::vector<uint32_t> &indices, uint32_t vertexCount) {
+    const uint32_t unassigned = UINT32_MAX;
+    std::vector<uint32_t> remap(vertexCount, unassigned);
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (remap[indices[i]] == unassigned) {
+            remap[indices[i]] = nextVertex++;
+        }
+        indices[i] = remap[indices[i]];
+    }
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        if (remap[i] == unassigned) {
+            remap[i] = nextVertex++;
+        }
+    }
+    return remap;
+}
+
+MeshOptimizer::CacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t> &indices,
+                                                                 uint32_t vertexCount, uint32_t cacheSize) {
+    CacheStatistics statistics;
+    if (indices.size() < 3) {
+        return statistics;
+    }
+    //cache is a ring of timestamps, vertex is in cache if it was added in last cacheSize misses
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t missCount = 0;
+    std::vector<bool> isUsed(vertexCount, false);
+    uint32_t usedVertexCount = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        uint32_t vertex = indices[i];
+        if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+            cacheTimestamps[vertex] = timestamp++;
+            missCount++;
+        }
+        if (!isUsed[vertex]) {
+            isUsed[vertex] = true;
+            usedVertexCount++;
+        }
+    }
+    statistics.acmr = missCount / (float) (indices.size() / 3);
+    statistics.atvr = missCount / (float) usedVertexCount;
+    return statistics;
+}
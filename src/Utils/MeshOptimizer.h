@@ -0,0 +1,71 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_MESHOPTIMIZER_H
+#define LIMONENGINE_MESHOPTIMIZER_H
+
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Index buffer reordering for faster rendering. Doesn't use GL, so it runs on loader threads while importing.
+ *
+ * Usual order is optimizeVertexCache, then optimizeOverdraw, then optimizeVertexFetch. Overdraw ordering only moves
+ * clusters that start with a cache restart or have a low enough ACMR, so it doesn't lose most of the vertex cache
+ * gains.
+ */
+class MeshOptimizer {
+public:
+    struct CacheStatistics {
+        float acmr = 0;//average cache miss per triangle, 0.5 is ideal, 3 is worst
+        float atvr = 0;//average transformed vertex per vertex, 1 is ideal
+    };
+
+    static const uint32_t ANALYSIS_CACHE_SIZE = 16;
+
+private:
+    static const uint32_t SCORING_CACHE_SIZE = 32;
+    static constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;//allowed ACMR increase for splitting overdraw clusters
+
+    static float calculateVertexScore(int32_t cachePosition, uint32_t remainingTriangleCount);
+
+    /**
+     * Adds vertices of the triangle to FIFO cache, most recent is first.
+     * @return number of vertices that were not in cache
+     */
+    static uint32_t simulateCacheMisses(const uint32_t *triangleIndices, std::vector<uint32_t> &cache);
+
+public:
+    /**
+     * Reorders triangles so vertices are reused while they are in post transform cache. Forsyth's linear speed
+     * algorithm, it doesn't depend on the exact cache size.
+     */
+    static void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+    /**
+     * Splits triangles to clusters where the vertex cache restarts, then splits them further where cache locality
+     * allows, and sorts clusters so the ones facing outwards are drawn first. Early depth test can reject more of
+     * the rest.
+     */
+    static void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions);
+
+    /**
+     * Renumbers vertices in the order they are first used, so vertex fetch is mostly sequential. Indices are updated,
+     * vertex attributes should be moved using the returned remap. Unused vertices are moved to the end.
+     *
+     * @return new index of each vertex
+     */
+    static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+    /**
+     * Simulates a FIFO post transform cache.
+     */
+    static CacheStatistics analyzeVertexCache(const std::vector<uint32_t> &indices, uint32_t vertexCount,
+                                              uint32_t cacheSize = ANALYSIS_CACHE_SIZE);
+};
+
+
+#endif //LIMONENGINE_MESHOPTIMIZER_H
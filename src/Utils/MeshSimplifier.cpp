@@ -0,0 +1,203 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+void MeshSimplifier::Quadric::addPlane(double a, double b, double c, double d, double weight) {
+    a00 += weight * a * a;
+    a01 += weight * a * b;
+    a02 += weight * a * c;
+    a03 += weight * a * d;
+    a11 += weight * b * b;
+    a12 += weight * b * c;
+    a13 += weight * b * d;
+    a22 += weight * c * c;
+    a23 += weight * c * d;
+    a33 += weight * d * d;
+}
+
+void MeshSimplifier::Quadric::add(const Quadric &other) {
+    a00 += other.a00;
+    a01 += other.a01;
+    a02 += other.a02;
+    a03 += other.a03;
+    a11 += other.a11;
+    a12 += other.a12;
+    a13 += other.a13;
+    a22 += other.a22;
+    a23 += other.a23;
+    a33 += other.a33;
+}
+
+double MeshSimplifier::Quadric::evaluate(const glm::vec3 &position) const {
+    double x = position.x, y = position.y, z = position.z;
+    return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+           a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+           a22 * z * z + 2 * a23 * z +
+           a33;
+}
+
+/**
+ * Checks if moving "from" vertex to position of "to" turns any of the remaining triangles around "from" backwards.
+ */
+bool MeshSimplifier::isCollapseFlipping(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+                                        const std::vector<uint32_t> &triangleOffsets,
+                                        const std::vector<uint32_t> &vertexTriangles, uint32_t from, uint32_t to) {
+    for (uint32_t i = triangleOffsets[from]; i < triangleOffsets[from + 1]; ++i) {
+        uint32_t triangle = vertexTriangles[i];
+        uint32_t corners[3] = {indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2]};
+        if (corners[0] == to || corners[1] == to || corners[2] == to) {
+            //this triangle is removed by the collapse
+            continue;
+        }
+        glm::vec3 oldNormal = glm::cross(positions[corners[1]] - positions[corners[0]],
+                                         positions[corners[2]] - positions[corners[0]]);
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            if (corners[corner] == from) {
+                corners[corner] = to;
+            }
+        }
+        glm::vec3 newNormal = glm::cross(positions[corners[1]] - positions[corners[0]],
+                                         positions[corners[2]] - positions[corners[0]]);
+        if (glm::dot(oldNormal, newNormal) <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(const std::vector<uint32_t> &originalIndices,
+                                               const std::vector<glm::vec3> &positions, size_t targetIndexCount,
+                                               float maximumError) {
+    std::vector<uint32_t> indices(originalIndices.begin(), originalIndices.begin() + (originalIndices.size() / 3) * 3);
+    uint32_t vertexCount = (uint32_t) positions.size();
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const glm::vec3 &position0 = positions[indices[i]];
+        glm::vec3 normal = glm::cross(positions[indices[i + 1]] - position0, positions[indices[i + 2]] - position0);
+        float length = glm::length(normal);
+        if (length <= 0.0f) {
+            continue;
+        }
+        normal /= length;
+        Quadric quadric;
+        quadric.addPlane(normal.x, normal.y, normal.z, -glm::dot(normal, position0), 1.0);
+        for (size_t corner = 0; corner < 3; ++corner) {
+            quadrics[indices[i + corner]].add(quadric);
+        }
+    }
+
+    //an edge used by only one triangle is a border, its vertices are locked
+    std::unordered_map<uint64_t, uint32_t> edgeUseCounts;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            uint32_t first = indices[i + corner];
+            uint32_t second = indices[i + (corner + 1) % 3];
+            edgeUseCounts[((uint64_t) std::min(first, second) << 32) | std::max(first, second)]++;
+        }
+    }
+    std::vector<bool> isLocked(vertexCount, false);
+    for (auto edgeIt = edgeUseCounts.begin(); edgeIt != edgeUseCounts.end(); ++edgeIt) {
+        if (edgeIt->second == 1) {
+            isLocked[(uint32_t) (edgeIt->first >> 32)] = true;
+            isLocked[(uint32_t) (edgeIt->first & 0xFFFFFFFF)] = true;
+        }
+    }
+
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+    std::vector<uint32_t> vertexTriangles;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> isTouched(vertexCount);
+    std::vector<Collapse> collapses;
+    //each pass collapses the cheapest edges that don't share triangles, then rebuilds adjacency
+    while (indices.size() > targetIndexCount) {
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangleOffsets[indices[i] + 1]++;
+        }
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        }
+        vertexTriangles.resize(indices.size());
+        std::vector<uint32_t> fillCounts(vertexCount, 0);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            vertexTriangles[triangleOffsets[indices[i]] + fillCounts[indices[i]]++] = (uint32_t) (i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                uint32_t first = indices[i + corner];
+                uint32_t second = indices[i + (corner + 1) % 3];
+                Quadric combined = quadrics[first];
+                combined.add(quadrics[second]);
+                //only to the cheaper direction that is allowed
+                double firstToSecond = isLocked[first] ? -1.0 : combined.evaluate(positions[second]);
+                double secondToFirst = isLocked[second] ? -1.0 : combined.evaluate(positions[first]);
+                if (firstToSecond >= 0 && (secondToFirst < 0 || firstToSecond <= secondToFirst)) {
+                    collapses.push_back({first, second, firstToSecond});
+                } else if (secondToFirst >= 0) {
+                    collapses.push_back({second, first, secondToFirst});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &first, const Collapse &second) {
+            return first.cost < second.cost;
+        });
+
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            remap[i] = i;
+        }
+        std::fill(isTouched.begin(), isTouched.end(), false);
+        size_t remainingIndexCount = indices.size();
+        size_t collapseCount = 0;
+        for (size_t i = 0; i < collapses.size() && remainingIndexCount > targetIndexCount; ++i) {
+            const Collapse &collapse = collapses[i];
+            if (collapse.cost > maximumError) {
+                break;
+            }
+            if (isTouched[collapse.from] || isTouched[collapse.to] ||
+                isCollapseFlipping(indices, positions, triangleOffsets, vertexTriangles, collapse.from, collapse.to)) {
+                continue;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            //triangles around the collapsed vertex are changed, their vertices can't collapse again in this pass
+            for (uint32_t j = triangleOffsets[collapse.from]; j < triangleOffsets[collapse.from + 1]; ++j) {
+                uint32_t triangle = vertexTriangles[j];
+                bool isRemoved = false;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    isTouched[indices[triangle * 3 + corner]] = true;
+                    isRemoved = isRemoved || indices[triangle * 3 + corner] == collapse.to;
+                }
+                if (isRemoved) {
+                    remainingIndexCount -= 3;
+                }
+            }
+            collapseCount++;
+        }
+        if (collapseCount == 0) {
+            break;
+        }
+
+        size_t writeIndex = 0;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            uint32_t corner0 = remap[indices[i]];
+            uint32_t corner1 = remap[indices[i + 1]];
+            uint32_t corner2 = remap[indices[i + 2]];
+            if (corner0 == corner1 || corner1 == corner2 || corner0 == corner2) {
+                continue;
+            }
+            indices[writeIndex++] = corner0;
+            indices[writeIndex++] = corner1;
+            indices[writeIndex++] = corner2;
+        }
+        indices.resize(writeIndex);
+    }
+    return indices;
+}
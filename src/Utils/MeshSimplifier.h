@@ -0,0 +1,56 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_MESHSIMPLIFIER_H
+#define LIMONENGINE_MESHSIMPLIFIER_H
+
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Quadric error metric mesh simplification, used for generating LOD levels.
+ *
+ * Collapses edges to one of their vertices, so simplified index lists use the same vertex buffer with the original
+ * mesh, and only index buffers are needed per LOD. Vertices on open borders are locked. Texture seams are borders
+ * in index space, since vertices are duplicated there, so they are locked too and UVs don't tear.
+ */
+class MeshSimplifier {
+    struct Quadric {
+        //symmetric 4x4 matrix, upper triangle
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+
+        void addPlane(double a, double b, double c, double d, double weight);
+
+        void add(const Quadric &other);
+
+        double evaluate(const glm::vec3 &position) const;
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    static bool isCollapseFlipping(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+                                   const std::vector<uint32_t> &triangleOffsets,
+                                   const std::vector<uint32_t> &vertexTriangles, uint32_t from, uint32_t to);
+
+public:
+    /**
+     * @param targetIndexCount simplification stops when index count is less or equal to this
+     * @param maximumError stops before collapsing an edge with bigger error, in squared distance units
+     * @return simplified indices, referencing the same vertices
+     */
+    static std::vector<uint32_t> simplify(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+                                          size_t targetIndexCount, float maximumError);
+};
+
+
+#endif //LIMONENGINE_MESHSIMPLIFIER_H
@@ -0,0 +1,265 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+void TextureCompressor::generateNextMip(const std::vector<uint8_t> &source, uint32_t width, uint32_t height,
+                                        std::vector<uint8_t> &target) {
+    uint32_t targetWidth = std::max(1u, width / 2);
+    uint32_t targetHeight = std::max(1u, height / 2);
+    target.resize(targetWidth * targetHeight * 4);
+    for (uint32_t y = 0; y < targetHeight; ++y) {
+        uint32_t y0 = std::min(y * 2, height - 1);
+        uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < targetWidth; ++x) {
+            uint32_t x0 = std::min(x * 2, width - 1);
+            uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            for (uint32_t channel = 0; channel < 4; ++channel) {
+                uint32_t sum = source[(y0 * width + x0) * 4 + channel] + source[(y0 * width + x1) * 4 + channel] +
+                               source[(y1 * width + x0) * 4 + channel] + source[(y1 * width + x1) * 4 + channel];
+                target[(y * targetWidth + x) * 4 + channel] = (uint8_t) ((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+/**
+ * Copies 4x4 block, edges are repeated if image size is not a multiple of 4.
+ */
+void TextureCompressor::fetchBlock(const uint8_t *rgbaPixels, uint32_t width, uint32_t height, uint32_t blockX,
+                                   uint32_t blockY, uint8_t *block) {
+    for (uint32_t y = 0; y < 4; ++y) {
+        uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+            memcpy(block + (y * 4 + x) * 4, rgbaPixels + (sourceY * width + sourceX) * 4, 4);
+        }
+    }
+}
+
+static uint16_t packColor565(const float *color) {
+    uint32_t red = (uint32_t) (std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    uint32_t green = (uint32_t) (std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+    uint32_t blue = (uint32_t) (std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (uint16_t) ((red << 11) | (green << 5) | blue);
+}
+
+static void unpackColor565(uint16_t packed, int32_t *color) {
+    int32_t red = (packed >> 11) & 31;
+    int32_t green = (packed >> 5) & 63;
+    int32_t blue = packed & 31;
+    color[0] = (red << 3) | (red >> 2);
+    color[1] = (green << 2) | (green >> 4);
+    color[2] = (blue << 3) | (blue >> 2);
+}
+
+/**
+ * Endpoints are picked on the principal axis of block colors, then inset a little, since extremes are rarely hit
+ * after quantization. Always uses 4 color mode, so it is valid for both BC1 and BC3.
+ */
+void TextureCompressor::encodeColorBlock(const uint8_t *block, uint8_t *output) {
+    float mean[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < 16; ++i) {
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            mean[channel] += block[i * 4 + channel];
+        }
+    }
+    for (uint32_t channel = 0; channel < 3; ++channel) {
+        mean[channel] /= 16.0f;
+    }
+
+    float covariance[6] = {0, 0, 0, 0, 0, 0};//rr, rg, rb, gg, gb, bb
+    for (uint32_t i = 0; i < 16; ++i) {
+        float red = block[i * 4 + 0] - mean[0];
+        float green = block[i * 4 + 1] - mean[1];
+        float blue = block[i * 4 + 2] - mean[2];
+        covariance[0] += red * red;
+        covariance[1] += red * green;
+        covariance[2] += red * blue;
+        covariance[3] += green * green;
+        covariance[4] += green * blue;
+        covariance[5] += blue * blue;
+    }
+
+    //power iteration for principal axis
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+        float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+        };
+        float length = std::max(std::fabs(next[0]), std::max(std::fabs(next[1]), std::fabs(next[2])));
+        if (length < 1e-6f) {
+            break;
+        }
+        axis[0] = next[0] / length;
+        axis[1] = next[1] / length;
+        axis[2] = next[2] / length;
+    }
+    float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (uint32_t channel = 0; channel < 3; ++channel) {
+        axis[channel] /= axisLength;
+    }
+
+    float minimumProjection = 0, maximumProjection = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float projection = (block[i * 4 + 0] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] +
+                           (block[i * 4 + 2] - mean[2]) * axis[2];
+        minimumProjection = std::min(minimumProjection, projection);
+        maximumProjection = std::max(maximumProjection, projection);
+    }
+    float inset = (maximumProjection - minimumProjection) / 16.0f;
+    minimumProjection += inset;
+    maximumProjection -= inset;
+
+    float maximumColor[3], minimumColor[3];
+    for (uint32_t channel = 0; channel < 3; ++channel) {
+        maximumColor[channel] = mean[channel] + axis[channel] * maximumProjection;
+        minimumColor[channel] = mean[channel] + axis[channel] * minimumProjection;
+    }
+    uint16_t color0 = packColor565(maximumColor);
+    uint16_t color1 = packColor565(minimumColor);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int32_t palette[4][3];
+        unpackColor565(color0, palette[0]);
+        unpackColor565(color1, palette[1]);
+        for (uint32_t channel = 0; channel < 3; ++channel) {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+        }
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint32_t bestIndex = 0;
+            int32_t bestDistance = INT32_MAX;
+            for (uint32_t j = 0; j < 4; ++j) {
+                int32_t red = block[i * 4 + 0] - palette[j][0];
+                int32_t green = block[i * 4 + 1] - palette[j][1];
+                int32_t blue = block[i * 4 + 2] - palette[j][2];
+                int32_t distance = red * red + green * green + blue * blue;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex = j;
+                }
+            }
+            indices |= bestIndex << (i * 2);
+        }
+    }
+
+    output[0] = (uint8_t) (color0 & 0xFF);
+    output[1] = (uint8_t) (color0 >> 8);
+    output[2] = (uint8_t) (color1 & 0xFF);
+    output[3] = (uint8_t) (color1 >> 8);
+    for (uint32_t i = 0; i < 4; ++i) {
+        output[4 + i] = (uint8_t) ((indices >> (i * 8)) & 0xFF);
+    }
+}
+
+/**
+ * BC4 block of one channel, used for alpha of BC3 and both channels of BC5.
+ */
+void TextureCompressor::encodeSingleChannelBlock(const uint8_t *block, uint32_t channel, uint8_t *output) {
+    uint8_t minimumValue = 255, maximumValue = 0;
+    for (uint32_t i = 0; i < 16; ++i) {
+        minimumValue = std::min(minimumValue, block[i * 4 + channel]);
+        maximumValue = std::max(maximumValue, block[i * 4 + channel]);
+    }
+
+    uint64_t indices = 0;
+    if (maximumValue != minimumValue) {
+        //first endpoint bigger means 8 value mode
+        int32_t palette[8];
+        palette[0] = maximumValue;
+        palette[1] = minimumValue;
+        for (int32_t i = 2; i < 8; ++i) {
+            palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7;
+        }
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint64_t bestIndex = 0;
+            int32_t bestDistance = INT32_MAX;
+            for (uint32_t j = 0; j < 8; ++j) {
+                int32_t distance = std::abs(block[i * 4 + channel] - palette[j]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestIndex = j;
+                }
+            }
+            indices |= bestIndex << (i * 3);
+        }
+    }
+
+    output[0] = maximumValue;
+    output[1] = minimumValue;
+    for (uint32_t i = 0; i < 6; ++i) {
+        output[2 + i] = (uint8_t) ((indices >> (i * 8)) & 0xFF);
+    }
+}
+
+void TextureCompressor::compressLevel(const uint8_t *rgbaPixels, uint32_t width, uint32_t height, Format format,
+                                      std::vector<uint8_t> &output) {
+    uint32_t blockCountX = (width + 3) / 4;
+    uint32_t blockCountY = (height + 3) / 4;
+    uint32_t blockSize = getBlockSize(format);
+    output.resize(blockCountX * blockCountY * blockSize);
+    uint8_t block[16 * 4];
+    for (uint32_t blockY = 0; blockY < blockCountY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blockCountX; ++blockX) {
+            fetchBlock(rgbaPixels, width, height, blockX, blockY, block);
+            uint8_t *blockOutput = output.data() + (blockY * blockCountX + blockX) * blockSize;
+            switch (format) {
+                case Format::BC1:
+                    encodeColorBlock(block, blockOutput);
+                    break;
+                case Format::BC3:
+                    encodeSingleChannelBlock(block, 3, blockOutput);
+                    encodeColorBlock(block, blockOutput + 8);
+                    break;
+                case Format::BC5:
+                    encodeSingleChannelBlock(block, 0, blockOutput);
+                    encodeSingleChannelBlock(block, 1, blockOutput + 8);
+                    break;
+            }
+        }
+    }
+}
+
+std::vector<TextureCompressor::MipLevel> TextureCompressor::compress(const uint8_t *rgbaPixels, uint32_t width,
+                                                                     uint32_t height, Format format) {
+    std::vector<MipLevel> levels;
+    std::vector<uint8_t> currentPixels(rgbaPixels, rgbaPixels + width * height * 4);
+    std::vector<uint8_t> nextPixels;
+    while (true) {
+        MipLevel level;
+        level.width = width;
+        level.height = height;
+        compressLevel(currentPixels.data(), width, height, format, level.data);
+        levels.push_back(std::move(level));
+        if (width == 1 && height == 1) {
+            break;
+        }
+        generateNextMip(currentPixels, width, height, nextPixels);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        currentPixels.swap(nextPixels);
+    }
+    return levels;
+}
+
+bool TextureCompressor::hasTransparency(const uint8_t *rgbaPixels, size_t pixelCount) {
+    for (size_t i = 0; i < pixelCount; ++i) {
+        if (rgbaPixels[i * 4 + 3] != 255) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_TEXTURECOMPRESSOR_H
+#define LIMONENGINE_TEXTURECOMPRESSOR_H
+
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * CPU block compression encoder. Generates the mip chain by box filtering, and compresses each level to BC1, BC3 or
+ * BC5. It doesn't use GL or SDL, so it can run on loader threads, or without a window.
+ *
+ * BC1 is for opaque textures, BC3 for textures with alpha, BC5 for two channel textures like normal maps.
+ */
+class TextureCompressor {
+public:
+    enum class Format : uint32_t { BC1 = 1, BC3 = 3, BC5 = 5 };
+
+    struct MipLevel {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> data;
+    };
+
+private:
+    static void generateNextMip(const std::vector<uint8_t> &source, uint32_t width, uint32_t height,
+                                std::vector<uint8_t> &target);
+
+    static void fetchBlock(const uint8_t *rgbaPixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+                           uint8_t *block);
+
+    static void encodeColorBlock(const uint8_t *block, uint8_t *output);
+
+    static void encodeSingleChannelBlock(const uint8_t *block, uint32_t channel, uint8_t *output);
+
+    static void compressLevel(const uint8_t *rgbaPixels, uint32_t width, uint32_t height, Format format,
+                              std::vector<uint8_t> &output);
+
+public:
+    /**
+     * @param rgbaPixels tightly packed, 4 bytes per pixel
+     * @return all mip levels, first one is full size
+     */
+    static std::vector<MipLevel> compress(const uint8_t *rgbaPixels, uint32_t width, uint32_t height, Format format);
+
+    static bool hasTransparency(const uint8_t *rgbaPixels, size_t pixelCount);
+
+    static uint32_t getBlockSize(Format format) {
+        return format == Format::BC1 ? 8 : 16;
+    }
+};
+
+
+#endif //LIMONENGINE_TEXTURECOMPRESSOR_H
@@ -0,0 +1,132 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "VertexQuantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static uint16_t quantizeUnorm16(float value) {
+    return (uint16_t) (std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+static int16_t quantizeSnorm16(float value) {
+    return (int16_t) std::round(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+void VertexQuantizer::calculatePositionRange(const std::vector<glm::vec3> &positions, glm::vec3 &positionOffset,
+                                             glm::vec3 &positionScale) {
+    if (positions.empty()) {
+        positionOffset = glm::vec3(0, 0, 0);
+        positionScale = glm::vec3(1, 1, 1);
+        return;
+    }
+    glm::vec3 minimum = positions[0];
+    glm::vec3 maximum = positions[0];
+    for (size_t i = 1; i < positions.size(); ++i) {
+        minimum = glm::min(minimum, positions[i]);
+        maximum = glm::max(maximum, positions[i]);
+    }
+    positionOffset = minimum;
+    positionScale = maximum - minimum;
+    for (int axis = 0; axis < 3; ++axis) {
+        //flat meshes, all packed values are 0 anyway
+        if (positionScale[axis] <= 0.0f) {
+            positionScale[axis] = 1.0f;
+        }
+    }
+}
+
+/**
+ * Octahedral encoding, normal is projected to octahedron, lower half is folded over upper half.
+ */
+void VertexQuantizer::encodeNormal(const glm::vec3 &normal, int16_t *encoded) {
+    float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (length <= 0.0f) {
+        encoded[0] = 0;
+        encoded[1] = 0;//decodes to +z
+        return;
+    }
+    glm::vec3 projected = normal / length;
+    float x = projected.x;
+    float y = projected.y;
+    if (projected.z < 0.0f) {
+        x = (1.0f - std::fabs(projected.y)) * (projected.x >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(projected.x)) * (projected.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    encoded[0] = quantizeSnorm16(x);
+    encoded[1] = quantizeSnorm16(y);
+}
+
+void VertexQuantizer::packVertex(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &textureCoordinate,
+                                 const glm::vec3 &positionOffset, const glm::vec3 &positionScale,
+                                 PackedVertex &packedVertex) {
+    glm::vec3 normalizedPosition = (position - positionOffset) / positionScale;
+    packedVertex.position[0] = quantizeUnorm16(normalizedPosition.x);
+    packedVertex.position[1] = quantizeUnorm16(normalizedPosition.y);
+    packedVertex.position[2] = quantizeUnorm16(normalizedPosition.z);
+    packedVertex.position[3] = 0;
+    packedVertex.textureCoordinate[0] = quantizeUnorm16(textureCoordinate.x);
+    packedVertex.textureCoordinate[1] = quantizeUnorm16(textureCoordinate.y);
+    encodeNormal(normal, packedVertex.normal);
+}
+
+/**
+ * Rounding error is given to the biggest weight, so weights still add up to 1.
+ */
+void VertexQuantizer::packBoneWeights(const glm::vec4 &boneWeights, uint8_t *packedWeights) {
+    int32_t sum = 0;
+    int32_t biggestIndex = 0;
+    for (int32_t i = 0; i < 4; ++i) {
+        packedWeights[i] = (uint8_t) (std::min(std::max(boneWeights[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+        sum += packedWeights[i];
+        if (packedWeights[i] > packedWeights[biggestIndex]) {
+            biggestIndex = i;
+        }
+    }
+    if (sum != 0) {
+        int32_t corrected = packedWeights[biggestIndex] + 255 - sum;
+        packedWeights[biggestIndex] = (uint8_t) std::min(std::max(corrected, 0), 255);
+    }
+}
+
+std::vector<VertexQuantizer::PackedVertex> VertexQuantizer::pack(const std::vector<glm::vec3> &positions,
+                                                                 const std::vector<glm::vec3> &normals,
+                                                                 const std::vector<glm::vec2> &textureCoordinates,
+                                                                 const glm::vec3 &positionOffset,
+                                                                 const glm::vec3 &positionScale) {
+    std::vector<PackedVertex> packedVertices(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+        packVertex(positions[i], normals[i], textureCoordinates.empty() ? glm::vec2(0, 0) : textureCoordinates[i],
+                   positionOffset, positionScale, packedVertices[i]);
+    }
+    return packedVertices;
+}
+
+std::vector<VertexQuantizer::PackedSkinnedVertex> VertexQuantizer::packSkinned(const std::vector<glm::vec3> &positions,
+                                                                               const std::vector<glm::vec3> &normals,
+                                                                               const std::vector<glm::vec2> &textureCoordinates,
+                                                                               const std::vector<glm::lowp_uvec4> &boneIDs,
+                                                                               const std::vector<glm::vec4> &boneWeights,
+                                                                               const glm::vec3 &positionOffset,
+                                                                               const glm::vec3 &positionScale) {
+    std::vector<PackedSkinnedVertex> packedVertices(positions.size());
+    bool isBoneIDClamped = false;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        packVertex(positions[i], normals[i], textureCoordinates.empty() ? glm::vec2(0, 0) : textureCoordinates[i],
+                   positionOffset, positionScale, packedVertices[i].vertex);
+        for (int j = 0; j < 4; ++j) {
+            if (boneIDs[i][j] > 255) {
+                isBoneIDClamped = true;
+            }
+            packedVertices[i].boneIDs[j] = (uint8_t) std::min((uint32_t) boneIDs[i][j], 255u);
+        }
+        packBoneWeights(boneWeights[i], packedVertices[i].boneWeights);
+    }
+    if (isBoneIDClamped) {
+        std::cerr << "Mesh has bone IDs bigger than 255, they can't be packed. Animation will be wrong." << std::endl;
+    }
+    return packedVertices;
+}
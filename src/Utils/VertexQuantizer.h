@@ -0,0 +1,66 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_VERTEXQUANTIZER_H
+#define LIMONENGINE_VERTEXQUANTIZER_H
+
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * Packs mesh vertices to interleaved, quantized vertex formats. Model and shadow map vertex shaders decode them.
+ *
+ * Positions are 16 bit normalized, relative to bounding box of the mesh, so the shader needs the offset and scale.
+ * Normals are octahedral encoded to two 16 bit snorm values. Texture coordinates are already in [0, 1] after
+ * MeshAsset normalizes them, so they are 16 bit normalized. Bone weights are 8 bit normalized, bone IDs are 8 bit.
+ */
+class VertexQuantizer {
+public:
+    struct PackedVertex {
+        uint16_t position[4];//4th is padding
+        uint16_t textureCoordinate[2];
+        int16_t normal[2];
+    };
+
+    struct PackedSkinnedVertex {
+        PackedVertex vertex;
+        uint8_t boneIDs[4];
+        uint8_t boneWeights[4];
+    };
+
+private:
+    static void packVertex(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &textureCoordinate,
+                           const glm::vec3 &positionOffset, const glm::vec3 &positionScale, PackedVertex &packedVertex);
+
+    static void packBoneWeights(const glm::vec4 &boneWeights, uint8_t *packedWeights);
+
+public:
+    /**
+     * @param positionOffset set to minimum of bounding box
+     * @param positionScale set to size of bounding box, position = offset + scale * packed
+     */
+    static void calculatePositionRange(const std::vector<glm::vec3> &positions, glm::vec3 &positionOffset,
+                                       glm::vec3 &positionScale);
+
+    /**
+     * @param textureCoordinates can be empty
+     */
+    static std::vector<PackedVertex> pack(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &normals,
+                                          const std::vector<glm::vec2> &textureCoordinates,
+                                          const glm::vec3 &positionOffset, const glm::vec3 &positionScale);
+
+    static std::vector<PackedSkinnedVertex> packSkinned(const std::vector<glm::vec3> &positions,
+                                                        const std::vector<glm::vec3> &normals,
+                                                        const std::vector<glm::vec2> &textureCoordinates,
+                                                        const std::vector<glm::lowp_uvec4> &boneIDs,
+                                                        const std::vector<glm::vec4> &boneWeights,
+                                                        const glm::vec3 &positionOffset, const glm::vec3 &positionScale);
+
+    static void encodeNormal(const glm::vec3 &normal, int16_t *encoded);
+};
+
+
+#endif //LIMONENGINE_VERTEXQUANTIZER_H
@@ -0,0 +1,96 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#include "WorkerPool.h"
+
+#include <iostream>
+
+WorkerPool::WorkerPool(uint32_t threadCount, const char *name) {
+    jobMutex = SDL_CreateMutex();
+    jobCondition = SDL_CreateCond();
+    finishCondition = SDL_CreateCond();
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(&staticWorker, name, this);
+        if (thread == nullptr) {
+            std::cerr << "Worker thread creation for " << name << " failed. " << SDL_GetError() << std::endl;
+            continue;
+        }
+        threads.push_back(thread);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    SDL_LockMutex(jobMutex);
+    stopWorkers = true;
+    SDL_CondBroadcast(jobCondition);
+    SDL_UnlockMutex(jobMutex);
+    for (size_t i = 0; i < threads.size(); ++i) {
+        SDL_WaitThread(threads[i], nullptr);
+    }
+    SDL_DestroyCond(finishCondition);
+    SDL_DestroyCond(jobCondition);
+    SDL_DestroyMutex(jobMutex);
+}
+
+int WorkerPool::staticWorker(void *workerPool) {
+    static_cast<WorkerPool *>(workerPool)->worker();
+    return 0;
+}
+
+void WorkerPool::worker() {
+    SDL_LockMutex(jobMutex);
+    while (true) {
+        while (!stopWorkers && nextJob >= jobCount) {
+            SDL_CondWait(jobCondition, jobMutex);
+        }
+        if (stopWorkers) {
+            break;
+        }
+        runAvailableJobs();
+    }
+    SDL_UnlockMutex(jobMutex);
+}
+
+void WorkerPool::runAvailableJobs() {
+    while (nextJob < jobCount) {
+        uint32_t jobIndex = nextJob++;
+        SDL_UnlockMutex(jobMutex);
+
+        jobFunction(jobContext, jobIndex);
+
+        SDL_LockMutex(jobMutex);
+        finishedJobCount++;
+        if (finishedJobCount == jobCount) {
+            SDL_CondSignal(finishCondition);
+        }
+    }
+}
+
+void WorkerPool::run(JobFunction function, void *context, uint32_t jobCount) {
+    if (jobCount == 0) {
+        return;
+    }
+    if (threads.empty() || jobCount == 1) {
+        for (uint32_t i = 0; i < jobCount; ++i) {
+            function(context, i);
+        }
+        return;
+    }
+    SDL_LockMutex(jobMutex);
+    this->jobFunction = function;
+    this->jobContext = context;
+    this->jobCount = jobCount;
+    this->nextJob = 0;
+    this->finishedJobCount = 0;
+    SDL_CondBroadcast(jobCondition);
+
+    runAvailableJobs();
+    while (finishedJobCount < this->jobCount) {
+        SDL_CondWait(finishCondition, jobMutex);
+    }
+    //workers go back to waiting
+    this->jobCount = 0;
+    this->nextJob = 0;
+    SDL_UnlockMutex(jobMutex);
+}
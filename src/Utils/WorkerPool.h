@@ -0,0 +1,71 @@
+//
+// Created by engin on 19.10.2026.
+//
+
+#ifndef LIMONENGINE_WORKERPOOL_H
+#define LIMONENGINE_WORKERPOOL_H
+
+
+#include <vector>
+#include <cstdint>
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+/**
+ * Persistent threads for splitting per tick work. Threads are created once, and wait on a condition variable
+ * between runs, so starting a run doesn't cost a thread creation.
+ *
+ * run blocks until all jobs are done, and the calling thread works on jobs too.
+ */
+class WorkerPool {
+public:
+    typedef void (*JobFunction)(void *context, uint32_t jobIndex);
+
+private:
+    std::vector<SDL_Thread *> threads;
+    SDL_mutex *jobMutex;
+    SDL_cond *jobCondition;
+    SDL_cond *finishCondition;
+
+    JobFunction jobFunction = nullptr;
+    void *jobContext = nullptr;
+    uint32_t jobCount = 0;
+    uint32_t nextJob = 0;
+    uint32_t finishedJobCount = 0;
+    bool stopWorkers = false;
+
+    static int staticWorker(void *workerPool);
+
+    void worker();
+
+    /**
+     * Runs jobs until none left to start. Must be called with mutex locked, returns with mutex locked.
+     */
+    void runAvailableJobs();
+
+public:
+    /**
+     * @param threadCount total thread count including the caller of run, so threadCount - 1 threads are created
+     */
+    WorkerPool(uint32_t threadCount, const char *name);
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    ~WorkerPool();
+
+    /**
+     * Calls function for each job index in [0, jobCount), and waits until all are finished.
+     */
+    void run(JobFunction function, void *context, uint32_t jobCount);
+
+    /**
+     * Includes the calling thread.
+     */
+    uint32_t getThreadCount() const {
+        return (uint32_t) threads.size() + 1;
+    }
+};
+
+
+#endif //LIMONENGINE_WORKERPOOL_H
@@ -2,13 +2,17 @@
 // Created by Engin Manap on 13.02.2016.
 //
 
-
+#include <algorithm>
+#include <sys/stat.h>
 #include "World.h"
 #include "AI/HumanEnemy.h"
 
 #include "Camera.h"
 #include "BulletDebugDrawer.h"
 #include "AI/AIMovementGrid.h"
+#include "Utils/HashUtils.h"
+#include "Assets/TextureStreamer.h"
+#include "StaticGeometryBatcher.h"
 
 
 #include "GameObjects/Players/FreeCursorPlayer.h"
@@ -49,7 +53,7 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
 
     // physics init
     broadphase = new btDbvtBroadphase();
-    ghostPairCallback = new btGhostPairCallback();
+    ghostPairCallback = new TriggerPairCallback();
     broadphase->getOverlappingPairCache()->setInternalGhostPairCallback(
             ghostPairCallback);    // Needed once to enable ghost objects inside Bullet
 
@@ -60,6 +64,8 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
 
     dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
     dynamicsWorld->setGravity(btVector3(0, -10, 0));
+    raycastService = new RaycastService(options->getRaycastThreadCount());
+    crowdSimulation = new CrowdSimulation(options->getCrowdSimulationThreadCount());
     debugDrawer = new BulletDebugDrawer(glHelper, options);
     dynamicsWorld->setDebugDrawer(debugDrawer);
     dynamicsWorld->getDebugDrawer()->setDebugMode(dynamicsWorld->getDebugDrawer()->DBG_NoDebug);
@@ -122,8 +128,10 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
 
     onLoadActions.push_back(new ActionForOnload());//this is here for editor, as if no action is added, editor would fail to allow setting the first one.
 
-    modelIndicesBuffer.reserve(NR_MAX_MODELS);
+    lodIndicesBuffers.resize(1);
+    lodIndicesBuffers[0].reserve(NR_MAX_MODELS);
     modelsInLightFrustum.resize(NR_POINT_LIGHTS);
+    chunksInLightFrustum.resize(NR_POINT_LIGHTS);
     animatedModelsInLightFrustum.resize(NR_POINT_LIGHTS);
 
     /************ ImGui *****************************/
@@ -135,33 +143,13 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
             glHelper->getOrthogonalProjectionMatrix(), options->getScreenHeight(), options->getScreenWidth());
 }
 
- bool World::checkPlayerVisibility(const glm::vec3 &from, const std::string &fromName) {
-     //FIXME this debug draw creates a flicker, because we redraw frames that surpass 60. we need duration for debug draw to prevent it
-     //debugDrawer->drawLine(GLMConverter::GLMToBlt(from), camera.getRigidBody()->getCenterOfMassPosition(), btVector3(1,0,0));
-     btCollisionWorld::AllHitsRayResultCallback RayCallback(GLMConverter::GLMToBlt(from), GLMConverter::GLMToBlt(currentPlayer->getPosition()));
-
-     dynamicsWorld->rayTest(
-             GLMConverter::GLMToBlt(from),
-             GLMConverter::GLMToBlt(currentPlayer->getPosition()),
-             RayCallback
-     );
-
-     //debugDrawer->flushDraws();
-     if (RayCallback.hasHit()) {
-         bool hasSeen = false;
-         for (int i = 0; i < RayCallback.m_collisionObjects.size(); ++i) {
-             GameObject *gameObject = static_cast<GameObject *>(RayCallback.m_collisionObjects[i]->getUserPointer());
-             if (gameObject->getTypeID() != GameObject::PLAYER && gameObject->getTypeID() != GameObject::TRIGGER && //trigger is ghost, so it should not block
-                 gameObject->getName() != fromName) {
-                 return false;
-             }
-             if(gameObject->getTypeID() == GameObject::PLAYER) {
-                 hasSeen = true;
-             }
-         }
-         return hasSeen;
+ bool World::checkPlayerVisibility(const RaycastService::RayResult &visibilityRayResult) const {
+     //ray is cast with a mask of models and player, ignoring the actor itself. So closest hit must be player to be seen
+     if (!visibilityRayResult.hasHit) {
+         return false;//if ray did not hit anything, return false. This should never happen
      }
-     return false;//if ray did not hit anything, return false. This should never happen
+     GameObject *gameObject = visibilityRayResult.getHitGameObject();
+     return gameObject != nullptr && gameObject->getTypeID() == GameObject::PLAYER;
  }
 
  /**
@@ -197,8 +185,13 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
         dynamicsWorld->stepSimulation(simulationTimeFrame / 1000.0f);
         currentPlayer->processPhysicsWorld(dynamicsWorld);
 
-        for(auto trigger = triggers.begin(); trigger != triggers.end(); trigger++) {
-            trigger->second->checkAndTrigger();
+        //trigger codes can remove triggers, so events are swapped out before running them
+        ghostPairCallback->swapTriggerEvents(triggerEventsBuffer);
+        for (size_t i = 0; i < triggerEventsBuffer.size(); ++i) {
+            auto trigger = triggers.find(triggerEventsBuffer[i].triggerID);
+            if(trigger != triggers.end()) {
+                trigger->second->playerOverlapChanged(triggerEventsBuffer[i].entered);
+            }
         }
 
         // ATTENTION iterator is not increased in for, it is done manually.
@@ -242,18 +235,99 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
             }
         }
 
-        for (auto actorIt = actors.begin(); actorIt != actors.end(); ++actorIt) {
-            ActorInformation information = fillActorInformation(actorIt->second);
-            actorIt->second->play(gameTime, information, options);
-        }
-        for (auto it = objects.begin(); it != objects.end(); ++it) {
-            if (!it->second->getRigidBody()->isStaticOrKinematicObject() && it->second->getRigidBody()->isActive()) {
-                it->second->updateTransformFromPhysics();
-                Model* model = dynamic_cast<Model*>(it->second);
-                assert(model!= nullptr);
-                updatedModels.push_back(model);
+        if(!actors.empty()) {
+            aiTickCount++;
+            activeActors.clear();
+            perceivingActors.clear();
+            waitingActors.clear();
+            for (auto actorIt = actors.begin(); actorIt != actors.end(); ++actorIt) {
+                float distanceToPlayer = glm::length(actorIt->second->getPosition() - currentPlayer->getPosition());
+                if(distanceToPlayer >= options->getAIDormantDistance()) {
+                    //forget what is perceived, so actor perceives as soon as it wakes up
+                    actorLastInformations.erase(actorIt->first);
+                    continue;
+                }
+                activeActors.push_back(actorIt->second);
+                //far actors perceive on their own tick slot, so their cost is spread to ticks evenly
+                if(distanceToPlayer < options->getAINearDistance() ||
+                   (actorIt->first + aiTickCount) % options->getAIFarUpdateInterval() == 0 ||
+                   actorLastInformations.find(actorIt->first) == actorLastInformations.end()) {
+                    perceivingActors.push_back(actorIt->second);
+                } else {
+                    waitingActors.push_back(actorIt->second);
+                }
+            }
+
+            //visibility rays of perceiving actors are run as a single batch, far ones only cast on their tick slot
+            raycastService->clear();
+            actorVisibilityRayHandles.clear();
+            for (size_t i = 0; i < perceivingActors.size(); ++i) {
+                actorVisibilityRayHandles.push_back(
+                        raycastService->addRequest(perceivingActors[i]->getPosition() + AIMovementGrid::floatingHeight,
+                                                   currentPlayer->getPosition(), COLLIDE_EVERYTHING,
+                                                   COLLIDE_MODELS | COLLIDE_PLAYER,
+                                                   perceivingActors[i]->getCollisionObject()));
+            }
+            raycastService->executeBatch(dynamicsWorld);
+
+            //player position on grid is same for all actors
+            glm::vec3 playerPosWithGrid = currentPlayer->getPosition();
+            bool isPlayerReachable = grid->setProperHeight(&playerPosWithGrid, AIMovementGrid::floatingHeight, 0.0f, dynamicsWorld);
+
+            //if player moved to another node, routes of actors that are not perceiving are stale too
+            routeRefreshingActors.clear();
+            if(isPlayerReachable) {
+                uint32_t playerNode = grid->findNode(playerPosWithGrid, lastPlayerNode);
+                if(playerNode != lastPlayerNode) {
+                    lastPlayerNode = playerNode;
+                    routeRefreshingActors.swap(waitingActors);
+                }
+                if(options->isFlowFieldPursuit()) {
+                    //all actors chase the player, so a single field is shared
+                    pathScheduler->updateFlowFieldGoal(playerPosWithGrid);
+                }
+                for (size_t i = 0; i < perceivingActors.size(); ++i) {
+                    requestPathToPlayer(perceivingActors[i], playerPosWithGrid);
+                }
+                for (size_t i = 0; i < routeRefreshingActors.size(); ++i) {
+                    requestPathToPlayer(routeRefreshingActors[i], playerPosWithGrid);
+                }
+            }
+            //requests that don't fit the budget are processed on next ticks, actors use their last route until then
+            pathScheduler->processRequests(options->getPathRequestBudgetMicroseconds());
+
+            for (size_t i = 0; i < perceivingActors.size(); ++i) {
+                const RaycastService::RayResult &visibilityRayResult = raycastService->getResult(actorVisibilityRayHandles[i]);
+                actorLastInformations[perceivingActors[i]->getWorldID()] =
+                        fillActorInformation(perceivingActors[i], visibilityRayResult, isPlayerReachable);
             }
+            //only the route is updated, rest of the information stays as perceived last
+            for (size_t i = 0; i < routeRefreshingActors.size(); ++i) {
+                fillActorRoute(routeRefreshingActors[i], isPlayerReachable, false,
+                               actorLastInformations[routeRefreshingActors[i]->getWorldID()]);
+            }
+            //actors that didn't perceive this tick act on what they perceived last
+            for (size_t i = 0; i < activeActors.size(); ++i) {
+                activeActors[i]->play(gameTime, actorLastInformations[activeActors[i]->getWorldID()], options);
+            }
+            //movements are applied after all actors decide, so they can avoid each other
+            crowdSimulation->clear();
+            for (size_t i = 0; i < activeActors.size(); ++i) {
+                crowdSimulation->addAgent(activeActors[i]->getPosition(), activeActors[i]->getLastMovement(),
+                                          activeActors[i]->getDesiredMovement(), actorRadius);
+            }
+            crowdSimulation->step();
+            for (size_t i = 0; i < activeActors.size(); ++i) {
+                activeActors[i]->applyMovement(crowdSimulation->getNewVelocity(i));
+            }
+        }
+        //only the objects that are moved by simulation are in this list
+        for (size_t i = 0; i < physicsMovedObjects.size(); ++i) {
+            physicsMovedObjects[i]->updateTransformFromPhysics();
+            updatedModels.push_back(static_cast<Model*>(physicsMovedObjects[i]));//only models are added to objects
         }
+        updateGridObstacles();
+        physicsMovedObjects.clear();
 
          fillVisibleObjects();
 
@@ -273,6 +347,7 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
 
          fillVisibleObjects();
     }
+    requestStreamedTextures();
 
     for (unsigned int i = 0; i < guiLayers.size(); ++i) {
         guiLayers[i]->setupForTime(gameTime);
@@ -312,7 +387,133 @@ World::World(const std::string &name, PlayerTypes startingPlayerType, InputHandl
     }
 }
 
+/**
+ * Size of the bounding box on screen in pixels.
+ */
+float World::calculateProjectedSize(const glm::vec3 &aabbMin, const glm::vec3 &aabbMax) const {
+    //projection uses 60 degrees vertical fov, see GLHelper::reshape
+    float pixelsPerUnitAtOneMeter = options->getScreenHeight() / (2.0f * std::tan(options->PI / 6.0f));
+    glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+    float size = glm::length(aabbMax - aabbMin);
+    float distance = std::max(glm::length(center - camera->getPosition()), 0.1f);
+    return size * pixelsPerUnitAtOneMeter / distance;
+}
+
+uint32_t World::selectLod(const Model *model, uint32_t lodBias) const {
+    return selectLod(model->getAabbMin(), model->getAabbMax(), model->getLodCount(), lodBias);
+}
+
+/**
+ * Each lod has about half the triangles of previous one, so a level is dropped every time projected size halves.
+ */
+uint32_t World::selectLod(const glm::vec3 &aabbMin, const glm::vec3 &aabbMax, uint32_t lodCount,
+                          uint32_t lodBias) const {
+    if (lodCount == 1) {
+        return 0;
+    }
+    uint32_t lod = 0;
+    float projectedSize = calculateProjectedSize(aabbMin, aabbMax);
+    if (projectedSize < options->getLodFullDetailSize()) {
+        lod = (uint32_t) std::log2(options->getLodFullDetailSize() / std::max(projectedSize, 1.0f));
+    }
+    return std::min(lod + lodBias, lodCount - 1);
+}
+
+void World::renderModelsByLod(const std::set<Model *> &modelSet, GLSLProgram *program, uint32_t lodBias) {
+    if (modelSet.empty()) {
+        return;
+    }
+    //all models in the set use the same asset
+    Model *sampleModel = *modelSet.begin();
+    uint32_t lodCount = sampleModel->getLodCount();
+    if (lodIndicesBuffers.size() < lodCount) {
+        lodIndicesBuffers.resize(lodCount);
+    }
+    for (uint32_t lod = 0; lod < lodCount; ++lod) {
+        lodIndicesBuffers[lod].clear();
+    }
+    for (auto model = modelSet.begin(); model != modelSet.end(); ++model) {
+        lodIndicesBuffers[selectLod(*model, lodBias)].push_back((*model)->getWorldObjectID());
+    }
+    for (uint32_t lod = 0; lod < lodCount; ++lod) {
+        if (lodIndicesBuffers[lod].empty()) {
+            continue;
+        }
+        if (program == nullptr) {
+            sampleModel->renderInstanced(lodIndicesBuffers[lod], lod);
+        } else {
+            sampleModel->renderWithProgramInstanced(lodIndicesBuffers[lod], *program, lod);
+        }
+    }
+}
+
+void World::renderStaticChunks(const std::vector<size_t> &chunkIndices, GLSLProgram *program, uint32_t lodBias) {
+    for (size_t i = 0; i < chunkIndices.size(); ++i) {
+        size_t chunkIndex = chunkIndices[i];
+        uint32_t lod = selectLod(staticGeometryBatcher->getChunkAabbMin(chunkIndex),
+                                 staticGeometryBatcher->getChunkAabbMax(chunkIndex),
+                                 staticGeometryBatcher->getChunkLodCount(chunkIndex), lodBias);
+        staticGeometryBatcher->renderChunk(chunkIndex, lod, program);
+    }
+}
+
+/**
+ * Texture levels are requested by the size of visible models on screen.
+ */
+void World::requestStreamedTextures() const {
+    TextureStreamer *textureStreamer = assetManager->getTextureStreamer();
+    if (textureStreamer == nullptr) {
+        return;
+    }
+    std::vector<const std::set<Model *> *> visibleModelSets;
+    for (auto modelAssetIterator = modelsInCameraFrustum.begin();
+         modelAssetIterator != modelsInCameraFrustum.end(); ++modelAssetIterator) {
+        visibleModelSets.push_back(&modelAssetIterator->second);
+    }
+    visibleModelSets.push_back(&animatedModelsInFrustum);
+    for (size_t i = 0; i < visibleModelSets.size(); ++i) {
+        for (auto modelIterator = visibleModelSets[i]->begin(); modelIterator != visibleModelSets[i]->end(); ++modelIterator) {
+            (*modelIterator)->requestTextureLevels(textureStreamer, calculateProjectedSize((*modelIterator)->getAabbMin(),
+                                                                                           (*modelIterator)->getAabbMax()));
+        }
+    }
+    for (size_t i = 0; i < chunksInCameraFrustum.size(); ++i) {
+        size_t chunkIndex = chunksInCameraFrustum[i];
+        staticGeometryBatcher->requestTextureLevels(chunkIndex, textureStreamer,
+                                                    calculateProjectedSize(staticGeometryBatcher->getChunkAabbMin(chunkIndex),
+                                                                           staticGeometryBatcher->getChunkAabbMax(chunkIndex)));
+    }
+}
+
 void World::fillVisibleObjects(){
+    if (staticGeometryBatcher != nullptr) {
+        //moved models are put to frustum sets by the updated models checks below
+        staticGeometryBatcher->removeMovedModels(updatedModels);
+        if (camera->isDirty() || isChunkVisibilityDirty) {
+            chunksInCameraFrustum.clear();
+            for (size_t i = 0; i < staticGeometryBatcher->getChunkCount(); ++i) {
+                if (glHelper->isInFrustum(staticGeometryBatcher->getChunkAabbMin(i),
+                                          staticGeometryBatcher->getChunkAabbMax(i))) {
+                    chunksInCameraFrustum.push_back(i);
+                }
+            }
+        }
+        for (size_t currentLightIndex = 0; currentLightIndex < lights.size(); ++currentLightIndex) {
+            if (!lights[currentLightIndex]->isFrustumChanged() && !isChunkVisibilityDirty) {
+                continue;
+            }
+            chunksInLightFrustum[currentLightIndex].clear();
+            for (size_t i = 0; i < staticGeometryBatcher->getChunkCount(); ++i) {
+                const glm::vec3 &aabbMin = staticGeometryBatcher->getChunkAabbMin(i);
+                const glm::vec3 &aabbMax = staticGeometryBatcher->getChunkAabbMax(i);
+                if (lights[currentLightIndex]->isShadowCaster(aabbMin, aabbMax, (aabbMin + aabbMax) * 0.5f)) {
+                    chunksInLightFrustum[currentLightIndex].push_back(i);
+                }
+            }
+        }
+        isChunkVisibilityDirty = false;
+    }
+
     if(camera->isDirty()) {
         modelsInCameraFrustum.clear();
         animatedModelsInFrustum.clear();
@@ -352,6 +553,10 @@ void World::setLightVisibilityAndPutToSets(size_t currentLightIndex, PhysicalRen
                                                   lights[currentLightIndex]->isShadowCaster(currentModel->getAabbMin(),
                                                                                             currentModel->getAabbMax(),
                                                                                             currentModel->getTransformation()->getTranslate()));
+    if (currentModel->isStaticBatched()) {
+        //rendered as part of static geometry chunks
+        return;
+    }
     if(currentModel->isInLightFrustum(currentLightIndex)) {
         if(currentModel->isAnimated()) {
             animatedModelsInLightFrustum[currentLightIndex].insert(currentModel);
@@ -391,6 +596,10 @@ void World::setVisibilityAndPutToSets(PhysicalRenderable *PhysicalRenderable, bo
     Model* currentModel = dynamic_cast<Model*>(PhysicalRenderable);
     assert(currentModel != nullptr);
     currentModel->setIsInFrustum(glHelper->isInFrustum(currentModel->getAabbMin(), currentModel->getAabbMax()));
+    if (currentModel->isStaticBatched()) {
+        //rendered as part of static geometry chunks
+        return;
+    }
     if(currentModel->isIsInFrustum()) {
         if(currentModel->isAnimated()) {
             animatedModelsInFrustum.insert(currentModel);
@@ -423,9 +632,38 @@ void World::setVisibilityAndPutToSets(PhysicalRenderable *PhysicalRenderable, bo
     }
 }
 
-ActorInformation World::fillActorInformation(Actor *actor) {
+void World::requestPathToPlayer(Actor *actor, const glm::vec3 &playerPosWithGrid) {
+    if (options->isFlowFieldPursuit()) {
+        return;//flow field result is read when route is filled, no request needed
+    }
+    //navigation mesh searches are scheduled too, if it is used
+    pathScheduler->submitRequest(actor->getWorldID(),
+                                 actor->getPosition() + glm::vec3(0, AIMovementGrid::floatingHeight, 0),
+                                 playerPosWithGrid);
+}
+
+void World::fillActorRoute(Actor *actor, bool isPlayerReachable, bool isWaitingResultUsed, ActorInformation &information) {
+    information.toPlayerRoute = glm::vec3(0, 0, 0);
+    information.canGoToPlayer = false;
+    const PathRequestScheduler::PathResult* pathResult = nullptr;
+    if(isPlayerReachable) {
+        if (options->isFlowFieldPursuit()) {
+            pathResult = pathScheduler->getFlowFieldResult(actor->getWorldID(), actor->getPosition() + glm::vec3(0, AIMovementGrid::floatingHeight, 0));
+        } else if (isWaitingResultUsed || !pathScheduler->isWaiting(actor->getWorldID())) {
+            pathResult = pathScheduler->getResult(actor->getWorldID());
+        }
+    }
+    if(pathResult != nullptr && pathResult->isFound && !pathResult->route.empty()) {
+        //Normally, this information should be used for straightening the path, but not yet.
+        information.toPlayerRoute = pathResult->route[pathResult->route.size() - 1] - actor->getPosition() - glm::vec3(0, 2.0f, 0);
+        information.canGoToPlayer = true;
+    }
+}
+
+ActorInformation World::fillActorInformation(Actor *actor, const RaycastService::RayResult &visibilityRayResult,
+                                             bool isPlayerReachable) {
     ActorInformation information;
-    information.canSeePlayerDirectly = checkPlayerVisibility(actor->getPosition()+ AIMovementGrid::floatingHeight, actor->getModel()->getName());
+    information.canSeePlayerDirectly = checkPlayerVisibility(visibilityRayResult);
     glm::vec3 front = actor->getFrontVector();
     glm::vec3 rayDir = currentPlayer->getPosition() - actor->getPosition();
     float cosBetween = glm::dot(normalize(front), normalize(rayDir));
@@ -465,19 +703,8 @@ ActorInformation World::fillActorInformation(Actor *actor) {
             information.isPlayerUp = true;
             information.isPlayerDown = false;
         }
-    std::vector<glm::vec3> route;
-    glm::vec3 playerPosWithGrid = currentPlayer->getPosition();
-    bool isPlayerReachable = grid->setProperHeight(&playerPosWithGrid, AIMovementGrid::floatingHeight, 0.0f, dynamicsWorld);
-    if(isPlayerReachable && grid->coursePath(actor->getPosition() + glm::vec3(0, AIMovementGrid::floatingHeight, 0), playerPosWithGrid, actor->getWorldID(), &route)) {
-        if (route.empty()) {
-            information.toPlayerRoute = glm::vec3(0, 0, 0);
-            information.canGoToPlayer = false;
-        } else {
-            //Normally, this information should be used for straightening the path, but not yet.
-            information.toPlayerRoute = route[route.size() - 1] - actor->getPosition() - glm::vec3(0, 2.0f, 0);
-            information.canGoToPlayer = true;
-        }
-    }
+    //perceiving actors keep their last route while new request waits
+    fillActorRoute(actor, isPlayerReachable, true, information);
     return information;
 }
 
@@ -654,24 +881,18 @@ void World::render() {
         shadowMapProgramDirectional->setUniform("renderLightIndex", (int)i);
 
         for (auto modelIterator = modelsInLightFrustum[i].begin(); modelIterator != modelsInLightFrustum[i].end(); ++modelIterator) {
-            //each iterator has a vector. each vector is a model that can be rendered instanced. They share is animated
-            std::set<Model*> modelSet = modelIterator->second;
-            modelIndicesBuffer.clear();
-            Model* sampleModel = nullptr;
-            for (auto model = modelSet.begin(); model != modelSet.end(); ++model) {
-                sampleModel = *model;
-                //all of these models will be rendered
-                modelIndicesBuffer.push_back((*model)->getWorldObjectID());
-            }
-            if(sampleModel != nullptr) {
-                sampleModel->renderWithProgramInstanced(modelIndicesBuffer, *shadowMapProgramDirectional);
-            }
+            //each iterator has a set of models that can be rendered instanced, they are split by lod
+            renderModelsByLod(modelIterator->second, shadowMapProgramDirectional, options->getShadowLodBias());
+        }
+        if (staticGeometryBatcher != nullptr) {
+            renderStaticChunks(chunksInLightFrustum[i], shadowMapProgramDirectional, options->getShadowLodBias());
         }
 
         for (auto animatedModelIterator = animatedModelsInLightFrustum[i].begin(); animatedModelIterator != animatedModelsInLightFrustum[i].end(); ++animatedModelIterator) {
             std::vector<uint32_t > temp;
             temp.push_back((*animatedModelIterator)->getWorldObjectID());
-            (*animatedModelIterator)->renderWithProgramInstanced(temp,*shadowMapProgramDirectional);
+            (*animatedModelIterator)->renderWithProgramInstanced(temp,*shadowMapProgramDirectional,
+                                                                 selectLod(*animatedModelIterator, options->getShadowLodBias()));
         }
     }
 
@@ -683,24 +904,18 @@ void World::render() {
         //FIXME why are these set here?
         shadowMapProgramDirectional->setUniform("renderLightIndex", (int)i);
         for (auto modelIterator = modelsInLightFrustum[i].begin(); modelIterator != modelsInLightFrustum[i].end(); ++modelIterator) {
-            //each iterator has a vector. each vector is a model that can be rendered instanced. They share is animated
-            std::set<Model*> modelSet = modelIterator->second;
-            modelIndicesBuffer.clear();
-            Model* sampleModel = nullptr;
-            for (auto model = modelSet.begin(); model != modelSet.end(); ++model) {
-                //all of these models will be rendered
-                modelIndicesBuffer.push_back((*model)->getWorldObjectID());
-                sampleModel = *model;
-            }
-            if(sampleModel != nullptr) {
-                sampleModel->renderWithProgramInstanced(modelIndicesBuffer, *shadowMapProgramPoint);
-            }
+            //each iterator has a set of models that can be rendered instanced, they are split by lod
+            renderModelsByLod(modelIterator->second, shadowMapProgramPoint, options->getShadowLodBias());
+        }
+        if (staticGeometryBatcher != nullptr) {
+            renderStaticChunks(chunksInLightFrustum[i], shadowMapProgramPoint, options->getShadowLodBias());
         }
 
         for (auto animatedModelIterator = animatedModelsInLightFrustum[i].begin(); animatedModelIterator != animatedModelsInLightFrustum[i].end(); ++animatedModelIterator) {
             std::vector<uint32_t > temp;
             temp.push_back((*animatedModelIterator)->getWorldObjectID());
-            (*animatedModelIterator)->renderWithProgramInstanced(temp,*shadowMapProgramPoint);
+            (*animatedModelIterator)->renderWithProgramInstanced(temp,*shadowMapProgramPoint,
+                                                                 selectLod(*animatedModelIterator, options->getShadowLodBias()));
         }
     }
 
@@ -710,24 +925,17 @@ void World::render() {
     }
 
     for (auto modelIterator = modelsInCameraFrustum.begin(); modelIterator != modelsInCameraFrustum.end(); ++modelIterator) {
-        //each iterator has a vector. each vector is a model that can be rendered instanced. They share is animated
-        std::set<Model*> modelSet = modelIterator->second;
-        modelIndicesBuffer.clear();
-        Model* sampleModel = nullptr;
-        for (auto model = modelSet.begin(); model != modelSet.end(); ++model) {
-            //all of these models will be rendered
-            modelIndicesBuffer.push_back((*model)->getWorldObjectID());
-            sampleModel = *model;
-        }
-        if(sampleModel != nullptr) {
-            sampleModel->renderInstanced(modelIndicesBuffer);
-        }
+        //each iterator has a set of models that can be rendered instanced, they are split by lod
+        renderModelsByLod(modelIterator->second, nullptr, 0);
+    }
+    if (staticGeometryBatcher != nullptr) {
+        renderStaticChunks(chunksInCameraFrustum, nullptr, 0);
     }
 
     for (auto modelIterator = animatedModelsInFrustum.begin(); modelIterator != animatedModelsInFrustum.end(); ++modelIterator) {
         std::vector<uint32_t > temp;
         temp.push_back((*modelIterator)->getWorldObjectID());
-        (*modelIterator)->renderInstanced(temp);
+        (*modelIterator)->renderInstanced(temp, selectLod(*modelIterator, 0));
     }
 
     dynamicsWorld->debugDrawWorld();
@@ -1108,6 +1316,8 @@ void World::ImGuiFrameSetup() {//TODO not const because it removes the object. S
                     //remove AI requested
                     if (dynamic_cast<Model *>(pickedObject)->getAIID() != 0) {
                         actors.erase(dynamic_cast<Model *>(pickedObject)->getAIID());
+                        pathScheduler->removeActor(dynamic_cast<Model *>(pickedObject)->getAIID());
+                        actorLastInformations.erase(dynamic_cast<Model *>(pickedObject)->getAIID());
                         dynamic_cast<Model *>(pickedObject)->detachAI();
                     }
                 }
@@ -1285,6 +1495,7 @@ void World::addAnimationDefinitionToEditor() {
 }
 
 World::~World() {
+    delete staticGeometryBatcher;
     delete dynamicsWorld;
     delete animationInProgress;
 
@@ -1312,6 +1523,8 @@ World::~World() {
         delete (*it);
     }
 
+    delete raycastService;
+    delete crowdSimulation;
     delete debugDrawer;
     delete solver;
     delete collisionConfiguration;
@@ -1319,6 +1532,11 @@ World::~World() {
     delete broadphase;
     delete ghostPairCallback;
 
+    delete pathScheduler;
+    delete navMesh;
+    if (grid != nullptr && options->isPrintPathSearchStats()) {
+        grid->printPathSearchStats();
+    }
     delete grid;
     delete camera;
     delete physicalPlayer;
@@ -1336,6 +1554,7 @@ bool World::addModelToWorld(Model *xmlModel) {
     }
     xmlModel->getTransformation()->getWorldTransform();
     objects[xmlModel->getWorldObjectID()] = xmlModel;
+    xmlModel->setPhysicsMovedList(&physicsMovedObjects);
     rigidBodies.push_back(xmlModel->getRigidBody());
     xmlModel->updateAABB();
     if(xmlModel->isDisconnected()) {
@@ -1348,6 +1567,10 @@ bool World::addModelToWorld(Model *xmlModel) {
 
     updateWorldAABB(GLMConverter::BltToGLM(aabbMin), GLMConverter::BltToGLM(aabbMax));
 
+    //grid is generated before non static models are added, they block it after they come to rest
+    if(isGridObstacle(xmlModel)) {
+        movingGridObstacles.insert(xmlModel->getWorldObjectID());
+    }
     return true;
 
 }
@@ -1376,11 +1599,126 @@ void World::addActor(Actor *actor) {
     this->actors[actor->getWorldID()] = actor;
 }
 
-void World::createGridFrom(const glm::vec3 &aiGridStartPoint) {
+uint64_t World::calculateStaticGeometryHash(const glm::vec3 &aiGridStartPoint) const {
+    uint64_t hash = HashUtils::FNV_OFFSET_BASIS;
+    //objects map is ordered by id, so same map always produces same hash
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        Model* model = dynamic_cast<Model*>(it->second);
+        if(model == nullptr) {
+            continue;
+        }
+        hash = HashUtils::hashValue(it->first, hash);
+        hash = HashUtils::hashString(model->getName(), hash);
+        hash = HashUtils::hashValue(model->getTransformation()->getTranslate(), hash);
+        hash = HashUtils::hashValue(model->getTransformation()->getOrientation(), hash);
+        hash = HashUtils::hashValue(model->getTransformation()->getScale(), hash);
+        hash = HashUtils::hashValue(model->getMass(), hash);
+        hash = HashUtils::hashValue(model->isDisconnected(), hash);
+        //same file name might have different content, checked like cooked models do
+        struct stat modelStat;
+        if (stat(model->getModelFileName().c_str(), &modelStat) == 0) {
+            hash = HashUtils::hashValue((uint64_t) modelStat.st_size, hash);
+            hash = HashUtils::hashValue((int64_t) modelStat.st_mtime, hash);
+        }
+    }
+    hash = HashUtils::hashValue(aiGridStartPoint, hash);
+    hash = HashUtils::hashValue(worldAABBMin, hash);
+    hash = HashUtils::hashValue(worldAABBMax, hash);
+    hash = HashUtils::hashValue(AIMovementGrid::floatingHeight, hash);
+    //parallel generation samples differently, so grids are not interchangeable
+    hash = HashUtils::hashValue(options->getAIGridGenerationThreadCount() > 1, hash);
+    return hash;
+}
+
+void World::createGridFrom(const glm::vec3 &aiGridStartPoint, const std::string &mapFileName) {
     if(grid != nullptr) {
+        delete pathScheduler;//uses the grid
+        pathScheduler = nullptr;
         delete grid;
     }
-    grid = new AIMovementGrid(aiGridStartPoint, dynamicsWorld, worldAABBMin, worldAABBMax);
+    uint64_t geometryHash = calculateStaticGeometryHash(aiGridStartPoint);
+    std::string cacheFileName = mapFileName + ".aigrid";
+    grid = AIMovementGrid::loadFromCache(cacheFileName, geometryHash);
+    if(grid == nullptr) {
+        grid = new AIMovementGrid(aiGridStartPoint, dynamicsWorld, worldAABBMin, worldAABBMax,
+                                  options->getAIGridGenerationThreadCount());
+        if (!grid->serializeToCache(cacheFileName, geometryHash)) {
+            std::cerr << "AI grid couldn't be cached, it will be generated again on next load." << std::endl;
+        }
+    }
+    delete pathScheduler;
+    pathScheduler = new PathRequestScheduler(grid);
+    lastPlayerNode = AIMovementNode::NO_NEIGHBOUR;//node indexes of old grid are not valid
+    //new grid has no blocked nodes, obstacles block it again when they are checked
+    for (auto areaIt = gridBlockedAreas.begin(); areaIt != gridBlockedAreas.end(); ++areaIt) {
+        movingGridObstacles.insert(areaIt->first);
+    }
+    gridBlockedAreas.clear();
+
+    delete navMesh;
+    navMesh = nullptr;
+    if(options->isUseNavMesh()) {
+        //same static geometry is used, so grid hash is valid for navigation mesh too
+        std::string navMeshCacheFileName = mapFileName + ".ainavmesh";
+        navMesh = AINavMesh::loadFromCache(navMeshCacheFileName, geometryHash);
+        if (navMesh == nullptr) {
+            navMesh = new AINavMesh(dynamicsWorld, worldAABBMin, worldAABBMax);
+            if (!navMesh->serializeToCache(navMeshCacheFileName, geometryHash)) {
+                std::cerr << "AI navigation mesh couldn't be cached, it will be generated again on next load." << std::endl;
+            }
+        }
+        pathScheduler->setNavMesh(navMesh);
+        std::cout << "AI grid has " << grid->getNodeCount() << " nodes using "
+                  << grid->getNodeCount() * sizeof(AIMovementNode) << " bytes, navigation mesh has "
+                  << navMesh->getPolygonCount() << " polygons using " << navMesh->getMemoryUsage() << " bytes." << std::endl;
+    }
+}
+
+bool World::isGridObstacle(Model *model) const {
+    //actors avoid each other by crowd simulation
+    return grid != nullptr && model->getMass() > 0 && model->getAIID() == 0 && !model->isDisconnected();
+}
+
+void World::unblockGridArea(uint32_t objectID) {
+    auto areaIt = gridBlockedAreas.find(objectID);
+    if(areaIt == gridBlockedAreas.end()) {
+        return;
+    }
+    grid->setAreaBlocked(areaIt->second.first, areaIt->second.second, false);
+    gridBlockedAreas.erase(areaIt);
+}
+
+void World::updateGridObstacles() {
+    if(grid == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < physicsMovedObjects.size(); ++i) {
+        Model* model = static_cast<Model*>(physicsMovedObjects[i]);
+        if(isGridObstacle(model)) {
+            unblockGridArea(model->getWorldObjectID());
+            movingGridObstacles.insert(model->getWorldObjectID());
+        }
+    }
+    //blocking a moving object would rebuild clusters every tick, so areas are blocked when bodies sleep
+    for (auto obstacleIt = movingGridObstacles.begin(); obstacleIt != movingGridObstacles.end();) {
+        auto objectIt = objects.find(*obstacleIt);
+        if(objectIt == objects.end()) {
+            obstacleIt = movingGridObstacles.erase(obstacleIt);
+            continue;
+        }
+        if(objectIt->second->getRigidBody()->isActive()) {
+            ++obstacleIt;
+            continue;
+        }
+        btVector3 aabbMin, aabbMax;
+        objectIt->second->getRigidBody()->getAabb(aabbMin, aabbMax);
+        //nodes float above the surface, and actors have a radius
+        glm::vec3 blockedMin = GLMConverter::BltToGLM(aabbMin) - glm::vec3(actorRadius, 0, actorRadius);
+        glm::vec3 blockedMax = GLMConverter::BltToGLM(aabbMax) + glm::vec3(actorRadius, AIMovementGrid::floatingHeight, actorRadius);
+        grid->setAreaBlocked(blockedMin, blockedMax, true);
+        gridBlockedAreas[*obstacleIt] = std::make_pair(blockedMin, blockedMax);
+        obstacleIt = movingGridObstacles.erase(obstacleIt);
+    }
 }
 
 void World::setSky(SkyBox *skyBox) {
@@ -1684,17 +2022,28 @@ uint32_t World::removeObject(uint32_t objectID) {
     if(objects.find(objectID) != objects.end()) {
         PhysicalRenderable* objectToRemove = objects[objectID];
         dynamicsWorld->removeRigidBody(objectToRemove->getRigidBody());
+        objectToRemove->removeFromPhysicsMovedList();
         //disconnect AI
         if (dynamic_cast<Model *>(objectToRemove)->getAIID() != 0) {
             actors.erase(dynamic_cast<Model *>(objectToRemove)->getAIID());
+            pathScheduler->removeActor(dynamic_cast<Model *>(objectToRemove)->getAIID());
+            actorLastInformations.erase(dynamic_cast<Model *>(objectToRemove)->getAIID());
         }
         //remove any active animations
         activeAnimations.erase(objectToRemove);
         onLoadAnimations.erase(objectToRemove);
 
+        if(grid != nullptr) {
+            unblockGridArea(objectID);
+        }
+        movingGridObstacles.erase(objectID);
+
 
         Model* modelToRemove = dynamic_cast<Model*>(objectToRemove);
         if(modelToRemove != nullptr) {
+            if (modelToRemove->isStaticBatched()) {
+                staticGeometryBatcher->removeModels(std::vector<Model *>(1, modelToRemove));
+            }
             //we need to remove from ligth frustum lists, and camera frustum lists
             if(modelToRemove->isAnimated()) {
                 animatedModelsInFrustum.erase(modelToRemove);
@@ -1731,6 +2080,68 @@ void World::afterLoadFinished() {
         music->play();
     }
 
+    if (options->isUseStaticBatching()) {
+        buildStaticBatches();
+    }
+}
+
+/**
+ * Models without mass, animation, AI or custom animation are merged. Onload animations are already added at this
+ * point, so they are skipped too. Assets with many static instances are already drawn with one instanced call per
+ * mesh, merging them would only multiply their vertices, so they are not batched.
+ */
+void World::buildStaticBatches() {
+    std::unordered_map<uint32_t, std::vector<Model *>> staticModelsPerAsset;
+    for (auto objectIt = objects.begin(); objectIt != objects.end(); ++objectIt) {
+        Model *model = dynamic_cast<Model *>(objectIt->second);
+        if (model == nullptr || model->getMass() != 0 || model->isAnimated() || model->getAIID() != 0 ||
+            activeAnimations.find(model) != activeAnimations.end()) {
+            continue;
+        }
+        staticModelsPerAsset[model->getAssetID()].push_back(model);
+    }
+    std::vector<Model *> staticModels;
+    //draw calls of static models when nothing is culled, instanced rendering does one call per asset mesh
+    uint32_t drawCallsBefore = 0;
+    uint32_t drawCallsAfter = 0;
+    for (auto assetIt = staticModelsPerAsset.begin(); assetIt != staticModelsPerAsset.end(); ++assetIt) {
+        uint32_t meshCount = (uint32_t) assetIt->second[0]->getMeshes().size();
+        drawCallsBefore += meshCount;
+        if (assetIt->second.size() > options->getStaticBatchMaxInstanceCount()) {
+            drawCallsAfter += meshCount;
+            continue;
+        }
+        staticModels.insert(staticModels.end(), assetIt->second.begin(), assetIt->second.end());
+    }
+    if (staticModels.empty()) {
+        return;
+    }
+    staticGeometryBatcher = new StaticGeometryBatcher(glHelper, staticModels, options->getStaticBatchChunkSize());
+    //models might be put to frustum sets before batching
+    for (size_t i = 0; i < staticModels.size(); ++i) {
+        modelsInCameraFrustum[staticModels[i]->getAssetID()].erase(staticModels[i]);
+        for (size_t j = 0; j < modelsInLightFrustum.size(); ++j) {
+            modelsInLightFrustum[j][staticModels[i]->getAssetID()].erase(staticModels[i]);
+        }
+    }
+    isChunkVisibilityDirty = true;
+    drawCallsAfter += staticGeometryBatcher->getChunkCount();
+    std::cout << "Static batching merged " << staticGeometryBatcher->getBatchedModelCount() << " models to "
+              << staticGeometryBatcher->getChunkCount() << " chunks, static draw calls " << drawCallsBefore << " -> "
+              << drawCallsAfter << "." << std::endl;
+}
+
+std::vector<std::string> World::getTargetWorldFiles() const {
+    std::vector<std::string> worldFiles;
+    for (auto trigger = triggers.begin(); trigger != triggers.end(); trigger++) {
+        trigger->second->getTargetWorldFiles(worldFiles);
+    }
+    if (currentQuitResponse == QuitResponse::LOAD_WORLD && !quitWorldName.empty()) {
+        worldFiles.push_back(quitWorldName);
+    }
+    std::sort(worldFiles.begin(), worldFiles.end());
+    worldFiles.erase(std::unique(worldFiles.begin(), worldFiles.end()), worldFiles.end());
+    return worldFiles;
 }
 
 bool World::disconnectObjectFromPhysics(uint32_t objectWorldID) {
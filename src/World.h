@@ -17,9 +17,13 @@
 #include "AI/Actor.h"
 #include "ALHelper.h"
 #include "GameObjects/Players/Player.h"
+#include "GameObjects/TriggerPairCallback.h"
+#include "RaycastService.h"
+#include "AI/PathRequestScheduler.h"
+#include "AI/AINavMesh.h"
+#include "AI/CrowdSimulation.h"
 
 
-class btGhostPairCallback;
 class Camera;
 class Model;
 class BulletDebugDrawer;
@@ -53,6 +57,7 @@ class AnimationSequenceInterface;
 class LimonAPI;
 
 class GLHelper;
+class StaticGeometryBatcher;
 class ALHelper;
 
 class World {
@@ -122,7 +127,11 @@ private:
     friend class WorldLoader;
     friend class WorldSaver; //Those classes require direct access to some of the internal data
 
-    std::vector<uint32_t > modelIndicesBuffer;
+    std::vector<std::vector<uint32_t>> lodIndicesBuffers;//instanced batches of one asset, split by lod
+    StaticGeometryBatcher *staticGeometryBatcher = nullptr;
+    std::vector<size_t> chunksInCameraFrustum;
+    std::vector<std::vector<size_t>> chunksInLightFrustum;
+    bool isChunkVisibilityDirty = false;
     AssetManager* assetManager;
     Options* options;
     uint32_t nextWorldID = 1;
@@ -133,6 +142,7 @@ private:
      * The variables below are redundant, but they allow instanced rendering, and saving frustum occlusion results.
      */
     std::vector<Model*> updatedModels;
+    std::vector<PhysicalRenderable*> physicsMovedObjects;//filled by motion states of objects that simulation moved
     std::vector<std::map<uint32_t , std::set<Model*>>> modelsInLightFrustum;
     std::vector<std::set<Model*>> animatedModelsInLightFrustum; //since animated models can't be instanced, they don't need to be in a map etc.
 
@@ -154,6 +164,11 @@ private:
     std::vector<GUILayer *> guiLayers;
     std::unordered_map<uint32_t, Actor*> actors;
     AIMovementGrid *grid = nullptr;
+    //models with mass block the grid nodes they rest on, until they move again
+    std::unordered_map<uint32_t, std::pair<glm::vec3, glm::vec3>> gridBlockedAreas;
+    std::set<uint32_t> movingGridObstacles;
+    PathRequestScheduler *pathScheduler = nullptr;
+    AINavMesh *navMesh = nullptr;
     SkyBox *sky = nullptr;
     GLHelper *glHelper;
     ALHelper *alHelper;
@@ -189,9 +204,22 @@ private:
     GUIButton *hoveringButton = nullptr;
     GUITextDynamic* debugOutputGUI;
 
-    btGhostPairCallback *ghostPairCallback;
+    TriggerPairCallback *ghostPairCallback;
+    std::vector<TriggerPairCallback::TriggerEvent> triggerEventsBuffer;
     btDiscreteDynamicsWorld *dynamicsWorld;
     std::vector<btRigidBody *> rigidBodies;
+    RaycastService* raycastService;
+    CrowdSimulation* crowdSimulation;
+    float actorRadius = 0.5f;//same with AI grid capsule
+    std::vector<uint32_t> actorVisibilityRayHandles;
+    //AI level of detail. Actors that are not dormant play every tick, but perceiving is staggered for far ones
+    uint64_t aiTickCount = 0;
+    std::vector<Actor*> activeActors;
+    std::vector<Actor*> perceivingActors;
+    std::vector<Actor*> waitingActors;//active but not perceiving this tick
+    std::vector<Actor*> routeRefreshingActors;
+    uint32_t lastPlayerNode = 0xFFFFFFFF;
+    std::unordered_map<uint32_t, ActorInformation> actorLastInformations;
 
     LimonAPI* apiInstance;
 
@@ -279,22 +307,60 @@ private:
 
     bool handlePlayerInput(InputHandler &inputHandler);
 
-    bool checkPlayerVisibility(const glm::vec3 &from, const std::string &fromName);
+    bool checkPlayerVisibility(const RaycastService::RayResult &visibilityRayResult) const;
 
-    ActorInformation fillActorInformation(Actor *actor);
+    ActorInformation fillActorInformation(Actor *actor, const RaycastService::RayResult &visibilityRayResult,
+                                          bool isPlayerReachable);
+
+    void requestPathToPlayer(Actor *actor, const glm::vec3 &playerPosWithGrid);
+
+    /**
+     * Fills route fields of information. If isWaitingResultUsed is false, result of a waiting request is
+     * considered stale, and route is dropped until the new result is calculated.
+     */
+    void fillActorRoute(Actor *actor, bool isPlayerReachable, bool isWaitingResultUsed, ActorInformation &information);
 
     void updateWorldAABB(glm::vec3 aabbMin, glm::vec3 aabbMax);
 
+    uint64_t calculateStaticGeometryHash(const glm::vec3 &aiGridStartPoint) const;
+
     bool addModelToWorld(Model *xmlModel);
     bool addGUIElementToWorld(GUIRenderable *guiRenderable, GUILayer *guiLayer);
 
     void fillVisibleObjects();
 
+    void requestStreamedTextures() const;
+
+    float calculateProjectedSize(const glm::vec3 &aabbMin, const glm::vec3 &aabbMax) const;
+
+    uint32_t selectLod(const glm::vec3 &aabbMin, const glm::vec3 &aabbMax, uint32_t lodCount, uint32_t lodBias) const;
+
+    uint32_t selectLod(const Model *model, uint32_t lodBias) const;
+
+    void renderModelsByLod(const std::set<Model *> &modelSet, GLSLProgram *program, uint32_t lodBias);
+
+    void buildStaticBatches();
+
+    void renderStaticChunks(const std::vector<size_t> &chunkIndices, GLSLProgram *program, uint32_t lodBias);
+
     GameObject * getPointedObject() const;
 
     void addActor(Actor *actor);
 
-    void createGridFrom(const glm::vec3 &aiGridStartPoint);
+    /**
+     * Loads the AI grid from cache next to map file if static geometry is not changed, generates and caches otherwise.
+     * Must be called after static objects are added, and before non static ones.
+     */
+    void createGridFrom(const glm::vec3 &aiGridStartPoint, const std::string &mapFileName);
+
+    bool isGridObstacle(Model *model) const;
+
+    void unblockGridArea(uint32_t objectID);
+
+    /**
+     * Unblocks the models moved by simulation, and blocks the area of the ones that came to rest.
+     */
+    void updateGridObstacles();
 
     void setSky(SkyBox *skyBox);
 
@@ -305,6 +371,11 @@ private:
 
     void afterLoadFinished();
 
+    /**
+     * World files that triggers of this world can switch to, used for prefetching.
+     */
+    std::vector<std::string> getTargetWorldFiles() const;
+
     void switchPlayer(Player* targetPlayer, InputHandler &inputHandler);
 
     void ImGuiFrameSetup();
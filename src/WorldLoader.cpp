@@ -3,6 +3,7 @@
 //
 
 #include <algorithm>
+#include <SDL_timer.h>
 
 #include "WorldLoader.h"
 #include "World.h"
@@ -21,6 +22,7 @@
 #include "GameObjects/Sound.h"
 #include "GameObjects/GUIImage.h"
 #include "GameObjects/GUIButton.h"
+#include "Assets/ModelAsset.h"
 
 #include "main.h"
 
@@ -32,6 +34,10 @@ WorldLoader::WorldLoader(AssetManager *assetManager, InputHandler *inputHandler,
         inputHandler(inputHandler)
 {}
 
+WorldLoader::~WorldLoader() {
+    prefetchWorlds(std::vector<std::string>());
+}
+
 World * WorldLoader::loadWorld(const std::string &worldFile, LimonAPI *limonAPI) const {
     World* newWorld = loadMapFromXML(worldFile, limonAPI);
     if(newWorld == nullptr) {
@@ -140,8 +146,13 @@ World * WorldLoader::loadMapFromXML(const std::string &worldFileName, LimonAPI *
     }
 
 
-    //load objects
-    if(!loadObjectsFromXML(worldNode, world)) {
+    //load objects, models are loaded in parallel first, then objects pick them from asset manager
+    std::vector<std::string> prefetchedModels = prefetchModels(worldNode);
+    bool isObjectsLoaded = loadObjectsFromXML(worldNode, world, worldFileName);
+    for (size_t i = 0; i < prefetchedModels.size(); ++i) {
+        assetManager->freeAsset({prefetchedModels[i]});
+    }
+    if(!isObjectsLoaded) {
         delete world;
         return nullptr;
     }
@@ -166,7 +177,73 @@ World * WorldLoader::loadMapFromXML(const std::string &worldFileName, LimonAPI *
     return world;
 }
 
-bool WorldLoader::loadObjectsFromXML(tinyxml2::XMLNode *objectsNode, World* world) const {
+std::vector<std::string> WorldLoader::getModelFiles(tinyxml2::XMLNode *worldNode) const {
+    std::vector<std::string> modelFiles;
+    tinyxml2::XMLElement* objectsListNode =  worldNode->FirstChildElement("Objects");
+    if (objectsListNode == nullptr) {
+        return modelFiles;
+    }
+    tinyxml2::XMLElement* objectNode =  objectsListNode->FirstChildElement("Object");
+    while(objectNode != nullptr) {
+        tinyxml2::XMLElement* fileNode =  objectNode->FirstChildElement("File");
+        if (fileNode != nullptr && std::find(modelFiles.begin(), modelFiles.end(), fileNode->GetText()) == modelFiles.end()) {
+            modelFiles.push_back(fileNode->GetText());
+        }
+        objectNode = objectNode->NextSiblingElement("Object");
+    }
+    return modelFiles;
+}
+
+std::vector<std::string> WorldLoader::prefetchModels(tinyxml2::XMLNode *objectsNode) const {
+    std::vector<std::string> modelFiles = getModelFiles(objectsNode);
+    std::vector<AssetFuture<ModelAsset>> modelFutures;
+    for (size_t i = 0; i < modelFiles.size(); ++i) {
+        modelFutures.push_back(assetManager->loadAssetAsync<ModelAsset>({modelFiles[i]}));
+    }
+
+    long start = SDL_GetTicks();
+    for (size_t i = 0; i < modelFutures.size(); ++i) {
+        while (!modelFutures[i].isReady()) {
+            if (assetManager->processUploads(options->getAssetUploadBudgetMicroseconds()) == 0) {
+                SDL_Delay(1);
+            }
+        }
+    }
+    std::cout << "Loaded " << modelFiles.size() << " models in " << SDL_GetTicks() - start << "ms." << std::endl;
+    return modelFiles;
+}
+
+void WorldLoader::prefetchWorlds(const std::vector<std::string> &worldFiles) {
+    for (auto prefetchIt = prefetchedWorlds.begin(); prefetchIt != prefetchedWorlds.end();) {
+        if (std::find(worldFiles.begin(), worldFiles.end(), prefetchIt->first) != worldFiles.end()) {
+            ++prefetchIt;
+            continue;
+        }
+        for (size_t i = 0; i < prefetchIt->second.size(); ++i) {
+            assetManager->freeAsset({prefetchIt->second[i]});
+        }
+        prefetchIt = prefetchedWorlds.erase(prefetchIt);
+    }
+
+    for (size_t i = 0; i < worldFiles.size(); ++i) {
+        if (prefetchedWorlds.find(worldFiles[i]) != prefetchedWorlds.end()) {
+            continue;
+        }
+        tinyxml2::XMLDocument xmlDoc;
+        if (xmlDoc.LoadFile(worldFiles[i].c_str()) != tinyxml2::XML_SUCCESS || xmlDoc.FirstChild() == nullptr) {
+            std::cerr << "Prefetch of world " << worldFiles[i] << " failed, it can't be read." << std::endl;
+            continue;
+        }
+        std::vector<std::string> modelFiles = getModelFiles(xmlDoc.FirstChild());
+        for (size_t j = 0; j < modelFiles.size(); ++j) {
+            assetManager->loadAssetAsync<ModelAsset>({modelFiles[j]});
+        }
+        std::cout << "Prefetching " << modelFiles.size() << " models of world " << worldFiles[i] << std::endl;
+        prefetchedWorlds[worldFiles[i]] = modelFiles;
+    }
+}
+
+bool WorldLoader::loadObjectsFromXML(tinyxml2::XMLNode *objectsNode, World* world, const std::string &worldFileName) const {
     tinyxml2::XMLElement* objectsListNode =  objectsNode->FirstChildElement("Objects");
     if (objectsListNode == nullptr) {
         std::cerr << "World doesn't have Objects clause, this might be a mistake." << std::endl;
@@ -294,7 +371,7 @@ bool WorldLoader::loadObjectsFromXML(tinyxml2::XMLNode *objectsNode, World* worl
         objectNode = objectNode->NextSiblingElement("Object");
     } // end of while (objects)
 
-    world->createGridFrom(aiGridStartPoint);
+    world->createGridFrom(aiGridStartPoint, worldFileName);
 
     for (unsigned int i = 0; i < notStaticObjects.size(); ++i) {
         world->addModelToWorld(notStaticObjects[i]);
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <tinyxml2.h>
 #include "ALHelper.h"
 #include "InputHandler.h"
@@ -26,9 +27,17 @@ class WorldLoader {
     ALHelper *alHelper;
     AssetManager *assetManager;
     InputHandler* inputHandler;
+    //world file to model files that are requested for it, references are held until prefetch is released
+    std::unordered_map<std::string, std::vector<std::string>> prefetchedWorlds;
 
     World *loadMapFromXML(const std::string &worldFileName, LimonAPI *limonAPI) const;
-    bool loadObjectsFromXML(tinyxml2::XMLNode *objectsNode, World* world)const;
+    std::vector<std::string> getModelFiles(tinyxml2::XMLNode *worldNode) const;
+    /**
+     * Starts async load of all models the world uses, and waits for them.
+     * @return model files that are loaded, caller should free them after objects are created
+     */
+    std::vector<std::string> prefetchModels(tinyxml2::XMLNode *objectsNode) const;
+    bool loadObjectsFromXML(tinyxml2::XMLNode *objectsNode, World* world, const std::string &worldFileName)const;
     bool loadSkymap(tinyxml2::XMLNode *skymapNode, World* world) const;
     bool loadLights(tinyxml2::XMLNode *lightsNode, World* world) const;
     bool loadAnimations(tinyxml2::XMLNode *worldNode, World *world) const;
@@ -41,7 +50,15 @@ class WorldLoader {
 
 public:
     WorldLoader(AssetManager *assetManager, InputHandler *inputHandler, Options *options);
+    ~WorldLoader();
     World *loadWorld(const std::string &worldFile, LimonAPI *limonAPI) const;
+
+    /**
+     * Starts async loading of models the given worlds use, without waiting. Uploads are done by the asset manager
+     * each frame, so when one of these worlds is loaded, its models are ready or close to ready.
+     * Prefetched worlds that are not in the list are released, so their models can be evicted from asset cache.
+     */
+    void prefetchWorlds(const std::vector<std::string> &worldFiles);
 };
 
 
@@ -2,6 +2,8 @@
 // Created by Engin Manap on 10.02.2016.
 //
 
+#include <algorithm>
+
 #include "main.h"
 #include "GLHelper.h"
 #include "SDL2Helper.h"
@@ -9,6 +11,8 @@
 #include "WorldLoader.h"
 #include "ALHelper.h"
 #include "GameObjects/GUIImage.h"
+#include "Assets/AssetManager.h"
+#include "Assets/TextureStreamer.h"
 
 const std::string PROGRAM_NAME = "LimonEngine";
 
@@ -26,10 +30,25 @@ bool GameEngine::loadAndChangeWorld(const std::string &worldFile) {
     currentWorld->setupForPlay(*inputHandler);
     loadedWorlds[worldFile] = currentWorld;
     returnWorldStack.push_back(currentWorld);
+    prefetchTargetWorlds();
     previousTime = SDL_GetTicks();
     return true;
 }
 
+void GameEngine::prefetchTargetWorlds() {
+    if (!options->isPrefetchTargetWorlds() || !assetManager->hasLoaderThreads()) {
+        //without loader threads prefetch would block, same as loading the world
+        return;
+    }
+    std::vector<std::string> worldFiles = currentWorld->getTargetWorldFiles();
+    for (auto worldIt = loadedWorlds.begin(); worldIt != loadedWorlds.end(); ++worldIt) {
+        if (worldIt->second == currentWorld) {
+            worldFiles.erase(std::remove(worldFiles.begin(), worldFiles.end(), worldIt->first), worldFiles.end());
+        }
+    }
+    worldLoader->prefetchWorlds(worldFiles);
+}
+
 void GameEngine::renderLoadingImage() const {
     loadingImage->setFullScreen(true);
     sdlHelper->swap();
@@ -51,6 +70,7 @@ bool GameEngine::returnOrLoadMap(const std::string &worldFile) {
     }
     currentWorld->setupForPlay(*inputHandler);
     returnWorldStack.push_back(currentWorld);
+    prefetchTargetWorlds();
     previousTime = SDL_GetTicks();
     return true;
 }
@@ -71,6 +91,7 @@ void GameEngine::returnPreviousMap() {
         returnWorldStack.pop_back();
         currentWorld = returnWorldStack[returnWorldStack.size()-1];
         currentWorld->setupForPlay(*inputHandler);
+        prefetchTargetWorlds();
     }
     previousTime = SDL_GetTicks();
 }
@@ -93,10 +114,10 @@ GameEngine::GameEngine() {
     glHelper = new GLHelper(options);
     glHelper->reshape();
 
-    ALHelper *alHelper = new ALHelper();
+    alHelper = new ALHelper();
 
     inputHandler = new InputHandler(sdlHelper->getWindow(), options);
-    assetManager = new AssetManager(glHelper, alHelper);
+    assetManager = new AssetManager(glHelper, alHelper, options);
 
     worldLoader = new WorldLoader(assetManager, inputHandler, options);
 
@@ -136,6 +157,11 @@ void GameEngine::run() {
             currentWorld->play(worldUpdateTime, *inputHandler);
             accumulatedTime -= worldUpdateTime;
         }
+        //finish async loaded assets, a few each frame
+        assetManager->processUploads(options->getAssetUploadBudgetMicroseconds());
+        if (assetManager->getTextureStreamer() != nullptr) {
+            assetManager->getTextureStreamer()->update();
+        }
         glHelper->clearFrame();
         currentWorld->render();
         sdlHelper->swap();
@@ -150,6 +176,9 @@ GameEngine::~GameEngine() {
 
     delete inputHandler;
 
+    //assets free their GL and AL resources, so helpers are deleted after them
+    delete assetManager;
+
     delete alHelper;
     delete glHelper;
 
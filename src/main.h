@@ -57,6 +57,11 @@ public:
     void run();
 
     void renderLoadingImage() const;
+
+    /**
+     * Starts loading the worlds current world can switch to, and releases the ones it can't.
+     */
+    void prefetchTargetWorlds();
 };
 
 